@@ -4,7 +4,7 @@
 #include "route.h"
 #include "esp_err.h"
 
-#define CONFIG_VERSION      2  // v2: UART defaults changed away from SDIO pins (GPIO 14-19)
+#define CONFIG_VERSION      8  // v8: port_coding covers every port id
 #define CONFIG_WIFI_SSID_MAX 33
 #define CONFIG_WIFI_PASS_MAX 65
 
@@ -51,6 +51,22 @@ typedef struct {
         uint8_t             dst_count;
         signal_mapping_t    signal_map[8];
         uint8_t             signal_map_count;
+        uint8_t             flow;
+        uint16_t            coalesce_bytes;
+        uint32_t            coalesce_us;
+        uint8_t             merge_src_ids[ROUTE_MERGE_MAX_SRC - 1];
+        uint8_t             merge_src_count;
+        uint8_t             arbitration;
+        uint8_t             arb_delimiter;
+        uint32_t            arb_idle_us;
+        uint8_t             merge_weights[ROUTE_MERGE_MAX_SRC];
+        uint8_t             framing;
+        uint8_t             frame_delim[ROUTE_FRAME_DELIM_MAX];
+        uint8_t             frame_delim_len;
+        uint16_t            frame_len;
+        uint16_t            frame_gap;
+        uint32_t            elastic_bytes;
+        uint8_t             elastic_overflow;
     } routes[ROUTE_MAX_COUNT];
 } system_config_t;
 
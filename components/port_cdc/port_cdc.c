@@ -7,13 +7,16 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "port_cdc";
 
 // Private data for each CDC port
 typedef struct {
-    int cdc_index;  // TinyUSB CDC port index (0-4)
+    int               cdc_index;    // TinyUSB CDC port index (0-4)
+    SemaphoreHandle_t rx_lock;      // keeps rx_ring single-producer (callback vs reader)
+    volatile bool     rx_stalled;   // rx_ring was full, OUT data left in TinyUSB
 } cdc_priv_t;
 
 static port_t cdc_ports[CDC_PORT_COUNT];
@@ -26,6 +29,39 @@ static usb_phy_handle_t hs_phy_hdl;
 // TinyUSB device task handle
 static TaskHandle_t tusb_task_hdl;
 
+// Move pending OUT data from TinyUSB straight into rx_ring, as much as fits.
+// What does not fit stays in the TinyUSB FIFO; once that fills, the endpoint
+// is not re-armed and the host is NAKed until cdc_read() makes room.
+// Called from the TinyUSB task (RX callback) and from the reader.
+static void cdc_rx_pull(port_t *port)
+{
+    cdc_priv_t *priv = (cdc_priv_t *)port->priv;
+    uint8_t *dst;
+    size_t space;
+
+    xSemaphoreTake(priv->rx_lock, portMAX_DELAY);
+    for (;;) {
+        while ((space = port_rx_reserve(port, &dst)) > 0) {
+            size_t rx_size = 0;
+            esp_err_t ret = tinyusb_cdcacm_read(priv->cdc_index, dst, space, &rx_size);
+            if (ret != ESP_OK || rx_size == 0) break;
+            port_rx_commit(port, rx_size);
+            port->state = PORT_STATE_ACTIVE;
+        }
+        if (space > 0) {
+            __atomic_store_n(&priv->rx_stalled, false, __ATOMIC_RELAXED);
+            break;
+        }
+
+        // rx_ring is full.  Flag the stall, then check again: a reader that
+        // emptied the ring before seeing the flag will not pull.
+        __atomic_store_n(&priv->rx_stalled, true, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (port_rx_space(port) == 0) break;
+    }
+    xSemaphoreGive(priv->rx_lock);
+}
+
 // --- Port ops implementation ---
 
 static int cdc_open(port_t *port)
@@ -43,8 +79,15 @@ static void cdc_close(port_t *port)
 
 static int cdc_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout)
 {
-    // Read from the stream buffer (data pushed in by RX callback)
-    size_t received = xStreamBufferReceive(port->rx_buf, buf, len, timeout);
+    cdc_priv_t *priv = (cdc_priv_t *)port->priv;
+
+    // Read from the RX ring (filled by the RX callback)
+    size_t received = port_rx_read(port, buf, len, timeout);
+
+    // The RX callback only fires for new packets: resume a stalled transfer.
+    if (received > 0 && __atomic_load_n(&priv->rx_stalled, __ATOMIC_SEQ_CST)) {
+        cdc_rx_pull(port);
+    }
     return (int)received;
 }
 
@@ -59,6 +102,22 @@ static int cdc_write(port_t *port, const uint8_t *buf, size_t len, TickType_t ti
     return (int)written;
 }
 
+// Queue every segment, then flush once.
+static int cdc_writev(port_t *port, const port_iov_t *iov, int iovcnt, TickType_t timeout)
+{
+    cdc_priv_t *priv = (cdc_priv_t *)port->priv;
+    (void)timeout;
+
+    size_t written = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        size_t n = tinyusb_cdcacm_write_queue(priv->cdc_index, iov[i].buf, iov[i].len);
+        written += n;
+        if (n < iov[i].len) break;
+    }
+    tinyusb_cdcacm_write_flush(priv->cdc_index, pdMS_TO_TICKS(50));
+    return (int)written;
+}
+
 static int cdc_get_signals(port_t *port, uint32_t *signals)
 {
     *signals = port_get_effective_signals(port);
@@ -91,6 +150,7 @@ static const port_ops_t cdc_ops = {
     .close          = cdc_close,
     .read           = cdc_read,
     .write          = cdc_write,
+    .writev         = cdc_writev,
     .get_signals    = cdc_get_signals,
     .set_signals    = cdc_set_signals,
     .set_line_coding = cdc_set_line_coding,
@@ -103,23 +163,7 @@ static void cdc_rx_callback(int itf, cdcacm_event_t *event)
 {
     if (itf < 0 || itf >= CDC_PORT_COUNT) return;
 
-    port_t *port = &cdc_ports[itf];
-    // Use heap buffer — this callback runs on the TinyUSB task stack which is
-    // small (~4KB). A 4096-byte stack buffer would overflow it immediately.
-    uint8_t *buf = malloc(512);
-    if (!buf) return;
-    size_t rx_size = 0;
-
-    esp_err_t ret = tinyusb_cdcacm_read(itf, buf, 512, &rx_size);
-    if (ret == ESP_OK && rx_size > 0) {
-        size_t sent = xStreamBufferSend(port->rx_buf, buf, rx_size, 0);
-        if (sent < rx_size) {
-            ESP_LOGW(TAG, "%s: rx buffer overflow, dropped %d bytes",
-                     port->name, (int)(rx_size - sent));
-        }
-        port->state = PORT_STATE_ACTIVE;
-    }
-    free(buf);
+    cdc_rx_pull(&cdc_ports[itf]);
 }
 
 static void cdc_line_state_changed_callback(int itf, cdcacm_event_t *event)
@@ -134,6 +178,7 @@ static void cdc_line_state_changed_callback(int itf, cdcacm_event_t *event)
     if (dtr) new_signals |= SIGNAL_DTR;
     if (rts) new_signals |= SIGNAL_RTS;
     port->signals = new_signals;
+    port_signals_changed(port);
 
     ESP_LOGI(TAG, "%s: line state DTR=%d RTS=%d", port->name, dtr, rts);
 
@@ -262,6 +307,11 @@ esp_err_t port_cdc_init(void)
 
     for (int i = 0; i < CDC_PORT_COUNT; i++) {
         cdc_priv[i].cdc_index = i;
+        cdc_priv[i].rx_lock = xSemaphoreCreateMutex();
+        if (!cdc_priv[i].rx_lock) {
+            ESP_LOGE(TAG, "Failed to create RX lock for CDC %d", i);
+            return ESP_ERR_NO_MEM;
+        }
 
         port_t *port = &cdc_ports[i];
         memset(port, 0, sizeof(port_t));
@@ -275,11 +325,12 @@ esp_err_t port_cdc_init(void)
         port->state = PORT_STATE_READY;
         port->ops = cdc_ops;
         port->line_coding = port_line_coding_default();
+        port->packet_size = (i < CDC_PORT_COUNT_FS) ? 64 : 512;   // bulk max packet size
+        port->home_core = CONFIG_TINYUSB_TASK_AFFINITY < portNUM_PROCESSORS
+                          ? CONFIG_TINYUSB_TASK_AFFINITY : PORT_CORE_ANY;
         port->priv = &cdc_priv[i];
 
-        port->rx_buf = xStreamBufferCreate(PORT_BUF_SIZE, 1);
-        if (!port->rx_buf) {
-            ESP_LOGE(TAG, "Failed to create rx buffer for %s", port->name);
+        if (port_rx_init(port) != ESP_OK || port_tx_init(port) != ESP_OK) {
             return ESP_ERR_NO_MEM;
         }
 
@@ -0,0 +1,114 @@
+#include "buf_pool.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "buf_pool";
+
+_Static_assert(BUF_POOL_TOTAL_BYTES <= CONFIG_VUART_BUF_POOL_BUDGET_KB * 1024,
+               "Data-plane buffer pool exceeds CONFIG_VUART_BUF_POOL_BUDGET_KB");
+
+// Free blocks are chained through their first word.
+typedef struct free_block {
+    struct free_block *next;
+} free_block_t;
+
+typedef struct {
+    uint8_t          *base;
+    uint16_t          size;
+    uint16_t          count;
+    free_block_t     *free_list;
+    buf_pool_stats_t  stats;
+} buf_class_pool_t;
+
+static uint8_t small_blocks[BUF_POOL_SMALL_COUNT][BUF_POOL_SMALL_SIZE]    __attribute__((aligned(4)));
+static uint8_t medium_blocks[BUF_POOL_MEDIUM_COUNT][BUF_POOL_MEDIUM_SIZE] __attribute__((aligned(4)));
+static uint8_t large_blocks[BUF_POOL_LARGE_COUNT][BUF_POOL_LARGE_SIZE]    __attribute__((aligned(4)));
+
+static buf_class_pool_t pools[BUF_CLASS_COUNT] = {
+    [BUF_CLASS_SMALL]  = { &small_blocks[0][0],  BUF_POOL_SMALL_SIZE,  BUF_POOL_SMALL_COUNT },
+    [BUF_CLASS_MEDIUM] = { &medium_blocks[0][0], BUF_POOL_MEDIUM_SIZE, BUF_POOL_MEDIUM_COUNT },
+    [BUF_CLASS_LARGE]  = { &large_blocks[0][0],  BUF_POOL_LARGE_SIZE,  BUF_POOL_LARGE_COUNT },
+};
+
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t buf_pool_init(void)
+{
+    for (int c = 0; c < BUF_CLASS_COUNT; c++) {
+        buf_class_pool_t *p = &pools[c];
+        p->free_list = NULL;
+        for (int i = p->count - 1; i >= 0; i--) {
+            free_block_t *b = (free_block_t *)(p->base + (size_t)i * p->size);
+            b->next = p->free_list;
+            p->free_list = b;
+        }
+        memset(&p->stats, 0, sizeof(p->stats));
+        p->stats.block_size  = p->size;
+        p->stats.block_count = p->count;
+    }
+    ESP_LOGI(TAG, "Buffer pool initialized: %dx%d + %dx%d + %dx%d = %d bytes",
+             BUF_POOL_SMALL_COUNT, BUF_POOL_SMALL_SIZE,
+             BUF_POOL_MEDIUM_COUNT, BUF_POOL_MEDIUM_SIZE,
+             BUF_POOL_LARGE_COUNT, BUF_POOL_LARGE_SIZE, BUF_POOL_TOTAL_BYTES);
+    return ESP_OK;
+}
+
+void *buf_pool_take(size_t len)
+{
+    void *blk = NULL;
+    buf_class_pool_t *fit = NULL;   // best-fit class, when it was exhausted
+
+    portENTER_CRITICAL_SAFE(&pool_lock);
+    for (int c = 0; c < BUF_CLASS_COUNT; c++) {
+        buf_class_pool_t *p = &pools[c];
+        if (len > p->size) continue;
+        if (!p->free_list) {
+            if (!fit) fit = p;
+            continue;
+        }
+        if (fit) fit->stats.fallbacks++;
+        fit = NULL;
+        free_block_t *b = p->free_list;
+        p->free_list = b->next;
+        p->stats.takes++;
+        if (++p->stats.in_use > p->stats.high_water) {
+            p->stats.high_water = p->stats.in_use;
+        }
+        blk = b;
+        break;
+    }
+    if (fit) fit->stats.failures++;
+    portEXIT_CRITICAL_SAFE(&pool_lock);
+
+    return blk;
+}
+
+void buf_pool_give(void *buf)
+{
+    if (!buf) return;
+
+    uint8_t *ptr = (uint8_t *)buf;
+    for (int c = 0; c < BUF_CLASS_COUNT; c++) {
+        buf_class_pool_t *p = &pools[c];
+        if (ptr < p->base || ptr >= p->base + (size_t)p->count * p->size) continue;
+
+        portENTER_CRITICAL_SAFE(&pool_lock);
+        free_block_t *b = (free_block_t *)buf;
+        b->next = p->free_list;
+        p->free_list = b;
+        p->stats.in_use--;
+        portEXIT_CRITICAL_SAFE(&pool_lock);
+        return;
+    }
+    ESP_EARLY_LOGW(TAG, "buf_pool_give: %p is not a pool block", buf);
+}
+
+void buf_pool_get_stats(buf_pool_stats_t *out)
+{
+    portENTER_CRITICAL_SAFE(&pool_lock);
+    for (int c = 0; c < BUF_CLASS_COUNT; c++) {
+        out[c] = pools[c].stats;
+    }
+    portEXIT_CRITICAL_SAFE(&pool_lock);
+}
@@ -0,0 +1,19 @@
+#include "dp_notify.h"
+
+static volatile uint32_t notify_total;
+static volatile uint32_t notify_cross;
+
+void dp_notify(TaskHandle_t task)
+{
+    __atomic_add_fetch(&notify_total, 1, __ATOMIC_RELAXED);
+    if (xTaskGetCoreID(task) != xPortGetCoreID()) {
+        __atomic_add_fetch(&notify_cross, 1, __ATOMIC_RELAXED);
+    }
+    xTaskNotifyGive(task);
+}
+
+void dp_notify_get_counts(uint32_t *total, uint32_t *cross_core)
+{
+    *total      = notify_total;
+    *cross_core = notify_cross;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Fixed-size-class buffer pool for the data plane.
+// All storage is reserved statically, so the memory used by data-path
+// buffers is bounded at build time and never fragments the heap.
+// buf_pool_take()/buf_pool_give() are safe from tasks and ISRs.
+
+#define BUF_POOL_SMALL_SIZE     128
+#define BUF_POOL_MEDIUM_SIZE    512
+#define BUF_POOL_LARGE_SIZE     4096    // one fan-out ring
+
+#define BUF_POOL_SMALL_COUNT    CONFIG_VUART_BUF_POOL_SMALL_COUNT
+#define BUF_POOL_MEDIUM_COUNT   CONFIG_VUART_BUF_POOL_MEDIUM_COUNT
+#define BUF_POOL_LARGE_COUNT    CONFIG_VUART_BUF_POOL_LARGE_COUNT
+
+#define BUF_POOL_TOTAL_BYTES    (BUF_POOL_SMALL_SIZE  * BUF_POOL_SMALL_COUNT  + \
+                                 BUF_POOL_MEDIUM_SIZE * BUF_POOL_MEDIUM_COUNT + \
+                                 BUF_POOL_LARGE_SIZE  * BUF_POOL_LARGE_COUNT)
+
+typedef enum {
+    BUF_CLASS_SMALL = 0,
+    BUF_CLASS_MEDIUM,
+    BUF_CLASS_LARGE,
+    BUF_CLASS_COUNT,
+} buf_class_t;
+
+typedef struct {
+    uint16_t block_size;
+    uint16_t block_count;
+    uint16_t in_use;
+    uint16_t high_water;    // max blocks in use at once since boot
+    uint32_t takes;         // blocks handed out since boot
+    uint32_t fallbacks;     // takes served by a larger class, this one exhausted
+    uint32_t failures;      // takes of this size no class could serve
+} buf_pool_stats_t;
+
+// Build the free lists. Call once at startup before any port is created.
+esp_err_t buf_pool_init(void);
+
+// Take the smallest free block that holds at least len bytes.
+// Falls through to larger classes when the best fit is exhausted.
+// Returns NULL if len is larger than BUF_POOL_LARGE_SIZE or no block is free.
+void *buf_pool_take(size_t len);
+
+// Return a block obtained from buf_pool_take(). NULL is ignored.
+void buf_pool_give(void *buf);
+
+// Copy per-class statistics into out[BUF_CLASS_COUNT].
+void buf_pool_get_stats(buf_pool_stats_t *out);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Data-plane task notification. Same as xTaskNotifyGive(), but counts how
+// many wakeups were sent and how many targeted a task that is not pinned to
+// the calling core (unpinned targets count as cross-core).
+void dp_notify(TaskHandle_t task);
+
+// Totals since boot.
+void dp_notify_get_counts(uint32_t *total, uint32_t *cross_core);
@@ -3,12 +3,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_err.h"
+#include "spsc_ring.h"
+#include "seqcount.h"
 
-#define PORT_MAX_COUNT      8   // 2 CDC + 2 UART + 4 TCP
+#define PORT_MAX_COUNT      12  // port ids: CDC 0-4, UART 6-7, TCP 8-11
 #define PORT_NAME_MAX       16
 #define PORT_BUF_SIZE       2048
+#define PORT_PACKET_DEFAULT 256
+#define PORT_CORE_ANY       (-1)
+#define PORT_RX_STAMPS      32  // ingress timestamps kept per rx_ring, power of two
+#define PORT_TX_QUEUE_SIZE  CONFIG_VUART_PORT_TX_QUEUE_SIZE
 
 typedef enum {
     PORT_TYPE_CDC = 0,
@@ -39,13 +46,53 @@ typedef struct {
     bool     flow_control;  // RTS/CTS hardware flow control
 } port_line_coding_t;
 
+// Monotonic traffic counters. Never reset: consumers take snapshots with
+// port_get_stats() and diff them.
+typedef struct {
+    uint64_t bytes;         // accepted into rx_ring
+    uint64_t chunks;        // driver pushes/commits
+    uint64_t dropped;       // bytes lost: rx_ring or hardware FIFO full
+    uint64_t overflows;     // events that lost bytes
+} port_rx_stats_t;
+
+typedef struct {
+    uint64_t queued;        // accepted into tx_ring
+    uint64_t refused;       // offered with tx_ring full, left to the caller
+    uint64_t discarded;     // queued, then flushed: port closed or no peer
+    uint64_t bytes;         // written by the driver
+    uint64_t writes;        // driver write calls
+    uint64_t short_writes;  // ... that took less than offered (the rest is retried)
+} port_tx_stats_t;
+
+typedef struct {
+    port_rx_stats_t rx;
+    port_tx_stats_t tx;
+} port_stats_t;
+
+// Arrival time of the bytes committed to rx_ring from sequence `seq` on.
+typedef struct {
+    uint32_t seq;
+    uint32_t us;            // low 32 bits of esp_timer_get_time()
+} port_rx_stamp_t;
+
+// One segment of a gather write.
+typedef struct {
+    const uint8_t *buf;
+    size_t         len;
+} port_iov_t;
+
+#define PORT_IOV_MAX        4   // segments per gather write
+
 typedef struct port port_t;
 
+// write/writev return the bytes the driver took, or -1 if it has no peer
+// to deliver to; the port's queue is then flushed.
 typedef struct {
     int  (*open)(port_t *port);
     void (*close)(port_t *port);
     int  (*read)(port_t *port, uint8_t *buf, size_t len, TickType_t timeout);
     int  (*write)(port_t *port, const uint8_t *buf, size_t len, TickType_t timeout);
+    int  (*writev)(port_t *port, const port_iov_t *iov, int iovcnt, TickType_t timeout);   // optional
     int  (*get_signals)(port_t *port, uint32_t *signals);
     int  (*set_signals)(port_t *port, uint32_t signals);
     int  (*set_line_coding)(port_t *port, const port_line_coding_t *coding);
@@ -62,7 +109,21 @@ struct port {
     uint32_t            signals;            // Current signal state bitmask
     uint32_t            signal_override;    // Which signals are manually overridden
     uint32_t            signal_override_val;// Override values for those signals
-    StreamBufferHandle_t rx_buf;            // Incoming data buffer
+    spsc_ring_t         rx_ring;            // Incoming data: driver -> route engine
+    TaskHandle_t        rx_notify;          // Notified when rx_ring becomes non-empty (optional)
+    uint16_t            packet_size;        // Natural transfer unit, sizes route reads
+    int8_t              home_core;          // Core of the driver's own task, or PORT_CORE_ANY
+    port_rx_stamp_t     rx_stamps[PORT_RX_STAMPS];  // SPSC, alongside rx_ring
+    uint32_t            rx_stamp_head;      // written by the rx_ring producer
+    uint32_t            rx_stamp_tail;      // written by the rx_ring consumer
+    seqcount_t          rx_seq;             // Written by the rx_ring producer only
+    port_rx_stats_t     rx_stats;
+    spsc_ring_t         tx_ring;            // Outgoing data: routes -> tx_task
+    TaskHandle_t        tx_task;            // Sole caller of ops.write/writev once started
+    SemaphoreHandle_t   tx_mutex;           // Serialises tx_ring producers
+    portMUX_TYPE        tx_lock;            // Serialises tx_stats writers
+    seqcount_t          tx_seq;
+    port_tx_stats_t     tx_stats;
     void               *priv;              // Type-specific private data
 };
 
@@ -71,9 +132,76 @@ esp_err_t port_init(port_t *port, uint8_t id, const char *name, port_type_t type
 esp_err_t port_open(port_t *port);
 void port_close(port_t *port);
 
+// Allocate the RX ring. Called by each driver when it sets up a port.
+esp_err_t port_rx_init(port_t *port);
+
+// Allocate the TX queue and start the port's writer task, next to
+// home_core.  Called by each driver once the port is set up.
+esp_err_t port_tx_init(port_t *port);
+
+// Push received bytes into rx_ring and notify the rx_notify task, if any.
+// Never blocks. Returns the number of bytes accepted; the rest is counted
+// as dropped.
+size_t port_rx_push(port_t *port, const uint8_t *data, size_t len);
+
+// Account an overrun in which the driver lost bytes before they reached
+// rx_ring (e.g. a hardware FIFO overflow). Called from the rx_ring producer.
+void port_rx_overflow(port_t *port, size_t lost);
+
+// Zero-copy receive: get a contiguous free region of rx_ring, fill it,
+// then commit what was written.
+size_t port_rx_reserve(port_t *port, uint8_t **ptr);
+void port_rx_commit(port_t *port, size_t len);
+
+// Free space in rx_ring. Producers pull at most this much from the transport
+// so that a full rx_ring throttles the peer instead of dropping data.
+size_t port_rx_space(port_t *port);
+
+// Read from rx_ring (single consumer), waiting up to timeout for data.
+size_t port_rx_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout);
+
+// Sequence number of the next byte the rx_ring consumer will read.
+static inline uint32_t port_rx_position(port_t *port)
+{
+    return port->rx_ring.tail;
+}
+
+// Arrival time (low 32 bits of esp_timer_get_time()) of the byte at rx_ring
+// sequence `seq`, as stamped when the driver committed it. Consumer side;
+// forgets the stamps of earlier bytes.
+uint32_t port_rx_ingress(port_t *port, uint32_t seq);
+
+// Queue data for the port's writer task.  Never waits for room: returns the
+// number of bytes that fit, always a prefix of the segments, and counts the
+// rest as refused -- the caller retries or drops them.  Any number of tasks
+// may write the same port; their writes never interleave.  Task context only.
+int port_write(port_t *port, const uint8_t *buf, size_t len);
+int port_writev(port_t *port, const port_iov_t *iov, int iovcnt);
+
+// Bytes queued and not yet written by the driver.
+uint32_t port_tx_pending(port_t *port);
+
+// Consistent snapshot of the port's traffic counters.
+void port_get_stats(port_t *port, port_stats_t *out);
+
 // Get effective signals (hardware signals with overrides applied)
 uint32_t port_get_effective_signals(port_t *port);
 
+// Signal change events.  Whoever changes a port's input signals or its
+// overrides -- a driver on a line-state callback, a GPIO edge or a
+// connection change, or the API -- reports it here; the subscribed task
+// (the signal router) is notified and collects the changed ports.
+// Signals set through ops.set_signals are outputs and are not reported.
+void port_signals_changed(port_t *port);
+void port_signals_changed_from_isr(port_t *port, BaseType_t *woken);
+
+// Register the task notified on signal changes.
+void port_signal_subscribe(TaskHandle_t task);
+
+// Take the set of changed ports: bit n is port id n.  stamps_us[n] is set
+// to the esp_timer time of the first unreported change of each.
+uint32_t port_signal_take(int64_t stamps_us[PORT_MAX_COUNT]);
+
 // Default line coding: 115200 8N1
 static inline port_line_coding_t port_line_coding_default(void) {
     return (port_line_coding_t){
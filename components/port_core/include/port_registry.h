@@ -2,10 +2,20 @@
 
 #include "port.h"
 
+// Ports are indexed by id (0 .. PORT_MAX_COUNT-1).  Lookups are wait-free
+// and never block; registration and removal are serialised internally.
+//
+// Each id has a generation that changes whenever a port is registered or
+// removed under it.  A caller that caches a port_t * can keep the
+// generation from port_registry_lookup() and check it with
+// port_registry_valid() before trusting the pointer again.
+
 esp_err_t port_registry_init(void);
 esp_err_t port_registry_add(port_t *port);
 esp_err_t port_registry_remove(uint8_t port_id);
 port_t   *port_registry_get(uint8_t port_id);
+port_t   *port_registry_lookup(uint8_t port_id, uint32_t *gen);
+bool      port_registry_valid(uint8_t port_id, uint32_t gen);
 port_t   *port_registry_get_by_name(const char *name);
 int       port_registry_get_all(port_t **ports, int max_count);
 int       port_registry_count(void);
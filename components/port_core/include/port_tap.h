@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "port.h"
+
+// Byte-stream taps.  A tapped port's RX (as the route engine pumps it) and
+// TX (as its tx task writes it) are copied, one timestamped chunk at a time,
+// into a ring of its own, and a single consumer takes the oldest chunk of
+// any ring.  Producers copy without a lock and never wait: a chunk that
+// does not fit is dropped and counted against its port.  An untapped port
+// costs one atomic load per chunk.
+
+#define PORT_TAP_RX         0
+#define PORT_TAP_TX         1
+#define PORT_TAP_CHUNK_MAX  512     // longer chunks are split
+#define PORT_TAP_RING_SIZE  CONFIG_VUART_PORT_TAP_RING_SIZE
+
+typedef struct {
+    uint32_t us;        // low 32 bits of esp_timer_get_time() at ingress / egress
+    uint16_t len;
+    uint8_t  port_id;
+    uint8_t  dir;       // PORT_TAP_RX / PORT_TAP_TX
+} port_tap_chunk_t;
+
+extern uint32_t port_tap_mask[2];   // port id bits, per direction
+
+static inline bool port_tap_active(const port_t *port, int dir)
+{
+    return (__atomic_load_n(&port_tap_mask[dir], __ATOMIC_RELAXED) >> port->id) & 1;
+}
+
+// Reference counted, so subscribers can share a tap.
+esp_err_t port_tap_enable(uint8_t port_id, int dir);
+void port_tap_disable(uint8_t port_id, int dir);
+
+// Copy the first len bytes of iov into the ring.  Producers only.
+void port_tap_feed(port_t *port, int dir, uint32_t us, const port_iov_t *iov, int iovcnt, size_t len);
+
+// Next chunk, waiting up to timeout: its header and PORT_TAP_CHUNK_MAX
+// bytes at most into data.  Single consumer.
+bool port_tap_read(port_tap_chunk_t *chunk, uint8_t *data, TickType_t timeout);
+
+// Bytes of a port's tap dropped because the ring was full.
+uint64_t port_tap_lost(uint8_t port_id, int dir);
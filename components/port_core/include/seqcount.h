@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Sequence counter guarding a block of counters with a single writer.
+//
+// The writer makes the sequence odd, updates the block and makes it even
+// again; a reader copies the block and retries if the sequence was odd or
+// changed meanwhile.  Readers never block the writer, and a 64-bit counter
+// can never be seen half-updated on this 32-bit CPU.
+
+typedef struct {
+    uint32_t seq;
+} seqcount_t;
+
+static inline void seqcount_write_begin(seqcount_t *s)
+{
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqcount_write_end(seqcount_t *s)
+{
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+// Spins a reader makes on an odd sequence before it sleeps a tick.
+#define SEQCOUNT_SPIN_MAX   64
+
+// Copy len bytes of the block at src into dst, consistently.
+static inline void seqcount_read(const seqcount_t *s, void *dst, const void *src, size_t len)
+{
+    for (int spins = 0;; spins++) {
+        uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            // Writer is mid-update: a few stores away, on the other core or
+            // preempted on this one by a task of equal priority.  Only a
+            // lower-priority writer needs the reader to sleep.
+            if (spins < SEQCOUNT_SPIN_MAX) {
+                portYIELD();
+            } else {
+                vTaskDelay(1);
+            }
+            continue;
+        }
+        memcpy(dst, src, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq) return;
+    }
+}
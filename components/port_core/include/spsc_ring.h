@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+// Single-producer / single-consumer byte ring.
+//
+// Push and pop are wait-free: only the producer writes `head` and only the
+// consumer writes `tail`.  Each side keeps its index and a cached copy of
+// the other side's index on its own cache line, so the two cores do not
+// false-share.  A consumer blocked in spsc_ring_read() is woken with a task
+// notification, and only on the empty -> non-empty transition.
+//
+// reserve()/commit() and peek()/consume() expose contiguous regions so a
+// driver can receive straight into the ring.
+
+#define SPSC_CACHE_LINE     64
+
+typedef struct {
+    // Producer side
+    uint32_t        head __attribute__((aligned(SPSC_CACHE_LINE)));
+    uint32_t        tail_cache;     // producer's last view of tail
+
+    // Consumer side
+    uint32_t        tail __attribute__((aligned(SPSC_CACHE_LINE)));
+    uint32_t        head_cache;     // consumer's last view of head
+    TaskHandle_t    waiter;         // consumer blocked in spsc_ring_read()
+
+    // Read-only after init
+    uint8_t        *buf __attribute__((aligned(SPSC_CACHE_LINE)));
+    uint32_t        size;           // power of two
+} spsc_ring_t;
+
+// Allocate storage for a ring of `size` bytes (rounded up to a power of two).
+esp_err_t spsc_ring_init(spsc_ring_t *r, size_t size);
+
+// --- Producer ---
+
+// Contiguous free region at the write position. Returns its length (0 if full).
+size_t spsc_ring_reserve(spsc_ring_t *r, uint8_t **ptr);
+
+// Publish len bytes written into the reserved region. Returns true if the
+// ring was empty before, i.e. the consumer may need waking.
+bool spsc_ring_commit(spsc_ring_t *r, size_t len);
+
+// spsc_ring_commit() in two halves, for producers that publish inside a
+// critical section and wake the consumer after leaving it.
+bool spsc_ring_publish(spsc_ring_t *r, size_t len);
+void spsc_ring_wake(spsc_ring_t *r);
+
+// Copy in as much of data as fits. Returns the number of bytes accepted.
+size_t spsc_ring_push(spsc_ring_t *r, const uint8_t *data, size_t len, bool *was_empty);
+
+// Free space.
+size_t spsc_ring_space(spsc_ring_t *r);
+
+// --- Consumer ---
+
+// Contiguous readable region at the read position. Returns its length.
+size_t spsc_ring_peek(spsc_ring_t *r, const uint8_t **ptr);
+
+// Release len bytes returned by spsc_ring_peek().
+void spsc_ring_consume(spsc_ring_t *r, size_t len);
+
+// Copy out up to len bytes, waiting up to timeout for the first one.
+size_t spsc_ring_read(spsc_ring_t *r, uint8_t *dst, size_t len, TickType_t timeout);
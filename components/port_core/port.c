@@ -1,5 +1,11 @@
 #include "port.h"
+#include "port_tap.h"
 #include "esp_log.h"
+#include "freertos/task.h"
+#include "dp_notify.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "port";
@@ -17,17 +23,15 @@ esp_err_t port_init(port_t *port, uint8_t id, const char *name, port_type_t type
     port->state = PORT_STATE_DISABLED;
     port->ops = *ops;
     port->line_coding = port_line_coding_default();
+    port->packet_size = PORT_PACKET_DEFAULT;
+    port->home_core = PORT_CORE_ANY;
     port->signals = 0;
     port->signal_override = 0;
     port->signal_override_val = 0;
     port->priv = priv;
 
-    port->rx_buf = xStreamBufferCreate(PORT_BUF_SIZE, 1);
-    if (!port->rx_buf) {
-        ESP_LOGE(TAG, "Failed to create stream buffer for port %s", name);
-        return ESP_ERR_NO_MEM;
-    }
-
+    // The driver calls port_rx_init() and port_tx_init() once it has set
+    // packet_size and home_core, so the writer task lands on the right core.
     ESP_LOGI(TAG, "Port %s (id=%d, type=%d) initialized", name, id, type);
     return ESP_OK;
 }
@@ -52,6 +56,288 @@ void port_close(port_t *port)
     }
 }
 
+esp_err_t port_rx_init(port_t *port)
+{
+    if (spsc_ring_init(&port->rx_ring, PORT_BUF_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate rx ring for port %s", port->name);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void port_rx_wake(port_t *port)
+{
+    TaskHandle_t waiter = port->rx_notify;
+    if (waiter) {
+        dp_notify(waiter);
+    }
+}
+
+// Stamp the bytes about to be committed at the current head.  When the
+// stamp ring is full they inherit the previous stamp, which only makes
+// their latency look longer.
+static void port_rx_stamp(port_t *port)
+{
+    uint32_t head = port->rx_stamp_head;
+    if (head - __atomic_load_n(&port->rx_stamp_tail, __ATOMIC_ACQUIRE) >= PORT_RX_STAMPS) return;
+
+    port_rx_stamp_t *s = &port->rx_stamps[head & (PORT_RX_STAMPS - 1)];
+    s->seq = port->rx_ring.head;
+    s->us  = (uint32_t)esp_timer_get_time();
+    __atomic_store_n(&port->rx_stamp_head, head + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t port_rx_ingress(port_t *port, uint32_t seq)
+{
+    uint32_t head = __atomic_load_n(&port->rx_stamp_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = port->rx_stamp_tail;
+    if (head == tail) return (uint32_t)esp_timer_get_time();
+
+    // Keep the newest stamp at or before seq: later bytes may still need it.
+    while (tail + 1 != head &&
+           (int32_t)(port->rx_stamps[(tail + 1) & (PORT_RX_STAMPS - 1)].seq - seq) <= 0) {
+        tail++;
+    }
+    __atomic_store_n(&port->rx_stamp_tail, tail, __ATOMIC_RELEASE);
+    return port->rx_stamps[tail & (PORT_RX_STAMPS - 1)].us;
+}
+
+static void port_rx_account(port_t *port, size_t bytes, size_t lost)
+{
+    seqcount_write_begin(&port->rx_seq);
+    if (bytes) {
+        port->rx_stats.bytes += bytes;
+        port->rx_stats.chunks++;
+    }
+    if (lost) {
+        port->rx_stats.dropped += lost;
+        port->rx_stats.overflows++;
+    }
+    seqcount_write_end(&port->rx_seq);
+}
+
+size_t port_rx_push(port_t *port, const uint8_t *data, size_t len)
+{
+    bool was_empty;
+    port_rx_stamp(port);
+    size_t sent = spsc_ring_push(&port->rx_ring, data, len, &was_empty);
+    if (was_empty) {
+        port_rx_wake(port);
+    }
+    port_rx_account(port, sent, len - sent);
+    return sent;
+}
+
+void port_rx_overflow(port_t *port, size_t lost)
+{
+    seqcount_write_begin(&port->rx_seq);
+    port->rx_stats.dropped += lost;
+    port->rx_stats.overflows++;
+    seqcount_write_end(&port->rx_seq);
+}
+
+size_t port_rx_reserve(port_t *port, uint8_t **ptr)
+{
+    return spsc_ring_reserve(&port->rx_ring, ptr);
+}
+
+void port_rx_commit(port_t *port, size_t len)
+{
+    if (len) port_rx_stamp(port);
+    if (spsc_ring_commit(&port->rx_ring, len)) {
+        port_rx_wake(port);
+    }
+    if (len) port_rx_account(port, len, 0);
+}
+
+size_t port_rx_space(port_t *port)
+{
+    return spsc_ring_space(&port->rx_ring);
+}
+
+size_t port_rx_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout)
+{
+    return spsc_ring_read(&port->rx_ring, buf, len, timeout);
+}
+
+// ---------------------------------------------------------------------------
+// TX queue
+//
+// Routes never call the driver themselves: port_writev() copies into
+// tx_ring and the port's writer task drains it through ops.writev, so a
+// blocking send() or a full USB FIFO only ever stalls that task.  Producers
+// serialise on tx_mutex, which makes tx_ring single-producer again, and are
+// refused rather than blocked when it is full.  They copy with interrupts
+// enabled; tx_lock only covers the tx_stats stores.  Partial driver writes are
+// retried; a port that is closed, or whose driver has no peer to deliver to
+// (a TCP port between connections), has its queue flushed so a later peer
+// never receives stale bytes.
+// ---------------------------------------------------------------------------
+
+#define PORT_TX_STACK_SIZE  3072
+#define PORT_TX_RETRY_TICKS 1
+
+// Add to the tx counters. Caller holds tx_lock.
+static void port_tx_count(port_t *port, const port_tx_stats_t *d)
+{
+    seqcount_write_begin(&port->tx_seq);
+    port->tx_stats.queued       += d->queued;
+    port->tx_stats.refused      += d->refused;
+    port->tx_stats.discarded    += d->discarded;
+    port->tx_stats.bytes        += d->bytes;
+    port->tx_stats.writes       += d->writes;
+    port->tx_stats.short_writes += d->short_writes;
+    seqcount_write_end(&port->tx_seq);
+}
+
+// Hand segments straight to the driver: ops.writev, or ops.write per
+// segment up to the first short write.  Negative if the driver has no peer.
+static int port_tx_driver(port_t *port, const port_iov_t *iov, int iovcnt)
+{
+    if (port->ops.writev) return port->ops.writev(port, iov, iovcnt, 0);
+
+    int w = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int n = port->ops.write(port, iov[i].buf, iov[i].len, 0);
+        if (n < 0 && i == 0) return n;
+        if (n > 0) w += n;
+        if (n < (int)iov[i].len) break;
+    }
+    return w;
+}
+
+// Drop everything queued. Writer task only.
+static void port_tx_flush(port_t *port, uint32_t len)
+{
+    port_tx_stats_t d = { .discarded = len };
+    spsc_ring_consume(&port->tx_ring, len);
+    portENTER_CRITICAL(&port->tx_lock);
+    port_tx_count(port, &d);
+    portEXIT_CRITICAL(&port->tx_lock);
+}
+
+static void port_tx_task(void *arg)
+{
+    port_t      *port = (port_t *)arg;
+    spsc_ring_t *r    = &port->tx_ring;
+
+    for (;;) {
+        uint32_t tail = r->tail;
+        uint32_t len  = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+        if (len == 0) {
+            __atomic_store_n(&r->waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&r->head, __ATOMIC_SEQ_CST) == tail) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            __atomic_store_n(&r->waiter, NULL, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (port->state == PORT_STATE_DISABLED) {
+            port_tx_flush(port, len);
+            continue;
+        }
+
+        uint32_t off   = tail & (r->size - 1);
+        uint32_t first = r->size - off;
+        port_iov_t iov[2] = {
+            { &r->buf[off], len < first ? len : first },
+            { r->buf, len < first ? 0 : len - first },
+        };
+        int w = port_tx_driver(port, iov, iov[1].len ? 2 : 1);
+        if (w < 0) {
+            port_tx_flush(port, len);
+            continue;
+        }
+        if (w > 0 && port_tap_active(port, PORT_TAP_TX)) {
+            port_tap_feed(port, PORT_TAP_TX, (uint32_t)esp_timer_get_time(), iov, iov[1].len ? 2 : 1, w);
+        }
+        if (w > 0) spsc_ring_consume(r, w);
+
+        port_tx_stats_t d = {0};
+        d.bytes        = w;
+        d.writes       = 1;
+        d.short_writes = w < (int)len;
+        portENTER_CRITICAL(&port->tx_lock);
+        port_tx_count(port, &d);
+        portEXIT_CRITICAL(&port->tx_lock);
+
+        if (w == 0) vTaskDelay(PORT_TX_RETRY_TICKS);
+    }
+}
+
+esp_err_t port_tx_init(port_t *port)
+{
+    portMUX_INITIALIZE(&port->tx_lock);
+    port->tx_mutex = xSemaphoreCreateMutex();
+    if (!port->tx_mutex || spsc_ring_init(&port->tx_ring, PORT_TX_QUEUE_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate tx queue for port %s", port->name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    char name[PORT_NAME_MAX + 4]; // "tx_" + name + NUL
+    snprintf(name, sizeof(name), "tx_%s", port->name);
+    if (xTaskCreatePinnedToCore(port_tx_task, name, PORT_TX_STACK_SIZE, port, 5, &port->tx_task,
+                                port->home_core >= 0 ? port->home_core : tskNO_AFFINITY) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create tx task for port %s", port->name);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+int port_write(port_t *port, const uint8_t *buf, size_t len)
+{
+    port_iov_t iov = { buf, len };
+    return port_writev(port, &iov, 1);
+}
+
+int port_writev(port_t *port, const port_iov_t *iov, int iovcnt)
+{
+    spsc_ring_t *r = &port->tx_ring;
+    port_tx_stats_t d = {0};
+    bool wake = false;
+
+    if (!port->tx_mutex) return 0;
+    xSemaphoreTake(port->tx_mutex, portMAX_DELAY);
+    for (int i = 0; i < iovcnt; i++) {
+        const uint8_t *src  = iov[i].buf;
+        size_t         left = iov[i].len;
+        while (left > 0) {
+            uint8_t *dst;
+            size_t n = spsc_ring_reserve(r, &dst);
+            if (n == 0) break;
+            if (n > left) n = left;
+            memcpy(dst, src, n);
+            wake |= spsc_ring_publish(r, n);
+            src  += n;
+            left -= n;
+            d.queued += n;
+        }
+        d.refused += left;
+    }
+    xSemaphoreGive(port->tx_mutex);
+
+    portENTER_CRITICAL(&port->tx_lock);
+    port_tx_count(port, &d);
+    portEXIT_CRITICAL(&port->tx_lock);
+
+    if (wake) spsc_ring_wake(r);
+    return (int)d.queued;
+}
+
+uint32_t port_tx_pending(port_t *port)
+{
+    spsc_ring_t *r = &port->tx_ring;
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+void port_get_stats(port_t *port, port_stats_t *out)
+{
+    seqcount_read(&port->rx_seq, &out->rx, &port->rx_stats, sizeof(out->rx));
+    seqcount_read(&port->tx_seq, &out->tx, &port->tx_stats, sizeof(out->tx));
+}
+
 uint32_t port_get_effective_signals(port_t *port)
 {
     if (!port) return 0;
@@ -61,3 +347,50 @@ uint32_t port_get_effective_signals(port_t *port)
     uint32_t result = (hw_signals & ~port->signal_override) | (port->signal_override_val & port->signal_override);
     return result;
 }
+
+// ---------------------------------------------------------------------------
+// Signal change events
+// ---------------------------------------------------------------------------
+
+_Static_assert(PORT_MAX_COUNT <= 32, "signal_pending holds one bit per port id");
+
+static TaskHandle_t signal_task;
+static uint32_t     signal_pending;
+static int64_t      signal_stamp[PORT_MAX_COUNT];
+
+// Mark the port changed. Returns true if the subscriber needs a wakeup.
+static inline IRAM_ATTR bool signal_mark(port_t *port)
+{
+    if (port->id >= PORT_MAX_COUNT) return false;
+    uint32_t bit = 1u << port->id;
+    if (!(__atomic_load_n(&signal_pending, __ATOMIC_ACQUIRE) & bit)) {
+        signal_stamp[port->id] = esp_timer_get_time();
+    }
+    uint32_t old = __atomic_fetch_or(&signal_pending, bit, __ATOMIC_ACQ_REL);
+    return old == 0 && signal_task;
+}
+
+void port_signals_changed(port_t *port)
+{
+    if (signal_mark(port)) xTaskNotifyGive(signal_task);
+}
+
+void IRAM_ATTR port_signals_changed_from_isr(port_t *port, BaseType_t *woken)
+{
+    if (signal_mark(port)) vTaskNotifyGiveFromISR(signal_task, woken);
+}
+
+void port_signal_subscribe(TaskHandle_t task)
+{
+    signal_task = task;
+    if (__atomic_load_n(&signal_pending, __ATOMIC_ACQUIRE) && task) xTaskNotifyGive(task);
+}
+
+uint32_t port_signal_take(int64_t stamps_us[PORT_MAX_COUNT])
+{
+    uint32_t changed = __atomic_exchange_n(&signal_pending, 0, __ATOMIC_ACQ_REL);
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        if (changed & (1u << i)) stamps_us[i] = signal_stamp[i];
+    }
+    return changed;
+}
@@ -5,7 +5,16 @@
 
 static const char *TAG = "port_reg";
 
-static port_t *ports[PORT_MAX_COUNT];
+// gen is odd while a port is registered.  Writers publish the pointer
+// before making gen odd and make gen even before clearing it, so a reader
+// that sees the same gen on both sides of its pointer load has a
+// consistent pair.
+typedef struct {
+    port_t   *port;
+    uint32_t  gen;
+} reg_slot_t;
+
+static reg_slot_t ports[PORT_MAX_COUNT];
 static int port_count = 0;
 static SemaphoreHandle_t registry_mutex;
 
@@ -25,105 +34,96 @@ esp_err_t port_registry_init(void)
 esp_err_t port_registry_add(port_t *port)
 {
     if (!port) return ESP_ERR_INVALID_ARG;
+    if (port->id >= PORT_MAX_COUNT) {
+        ESP_LOGE(TAG, "Port id %d out of range, cannot add port %s", port->id, port->name);
+        return ESP_ERR_INVALID_ARG;
+    }
 
     xSemaphoreTake(registry_mutex, portMAX_DELAY);
 
-    if (port_count >= PORT_MAX_COUNT) {
+    reg_slot_t *s = &ports[port->id];
+    if (s->port) {
         xSemaphoreGive(registry_mutex);
-        ESP_LOGE(TAG, "Registry full, cannot add port %s", port->name);
-        return ESP_ERR_NO_MEM;
-    }
-
-    // Check for duplicate ID
-    for (int i = 0; i < PORT_MAX_COUNT; i++) {
-        if (ports[i] && ports[i]->id == port->id) {
-            xSemaphoreGive(registry_mutex);
-            ESP_LOGE(TAG, "Port id %d already registered", port->id);
-            return ESP_ERR_INVALID_STATE;
-        }
-    }
-
-    // Find empty slot
-    for (int i = 0; i < PORT_MAX_COUNT; i++) {
-        if (!ports[i]) {
-            ports[i] = port;
-            port_count++;
-            xSemaphoreGive(registry_mutex);
-            ESP_LOGI(TAG, "Registered port %s (id=%d) in slot %d", port->name, port->id, i);
-            return ESP_OK;
-        }
+        ESP_LOGE(TAG, "Port id %d already registered", port->id);
+        return ESP_ERR_INVALID_STATE;
     }
 
+    __atomic_store_n(&s->port, port, __ATOMIC_RELEASE);
+    __atomic_store_n(&s->gen, s->gen + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&port_count, 1, __ATOMIC_RELAXED);
     xSemaphoreGive(registry_mutex);
-    return ESP_ERR_NO_MEM;
+    ESP_LOGI(TAG, "Registered port %s (id=%d)", port->name, port->id);
+    return ESP_OK;
 }
 
 esp_err_t port_registry_remove(uint8_t port_id)
 {
+    if (port_id >= PORT_MAX_COUNT) return ESP_ERR_NOT_FOUND;
+
     xSemaphoreTake(registry_mutex, portMAX_DELAY);
 
-    for (int i = 0; i < PORT_MAX_COUNT; i++) {
-        if (ports[i] && ports[i]->id == port_id) {
-            ESP_LOGI(TAG, "Removed port %s (id=%d)", ports[i]->name, port_id);
-            ports[i] = NULL;
-            port_count--;
-            xSemaphoreGive(registry_mutex);
-            return ESP_OK;
-        }
+    reg_slot_t *s = &ports[port_id];
+    if (!s->port) {
+        xSemaphoreGive(registry_mutex);
+        return ESP_ERR_NOT_FOUND;
     }
 
+    ESP_LOGI(TAG, "Removed port %s (id=%d)", s->port->name, port_id);
+    __atomic_store_n(&s->gen, s->gen + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&s->port, NULL, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&port_count, 1, __ATOMIC_RELAXED);
     xSemaphoreGive(registry_mutex);
-    return ESP_ERR_NOT_FOUND;
+    return ESP_OK;
 }
 
 port_t *port_registry_get(uint8_t port_id)
 {
-    xSemaphoreTake(registry_mutex, portMAX_DELAY);
+    if (port_id >= PORT_MAX_COUNT) return NULL;
+    return __atomic_load_n(&ports[port_id].port, __ATOMIC_ACQUIRE);
+}
 
-    for (int i = 0; i < PORT_MAX_COUNT; i++) {
-        if (ports[i] && ports[i]->id == port_id) {
-            xSemaphoreGive(registry_mutex);
-            return ports[i];
-        }
+port_t *port_registry_lookup(uint8_t port_id, uint32_t *gen)
+{
+    if (port_id >= PORT_MAX_COUNT) return NULL;
+
+    reg_slot_t *s = &ports[port_id];
+    for (;;) {
+        uint32_t g    = __atomic_load_n(&s->gen, __ATOMIC_ACQUIRE);
+        port_t  *port = __atomic_load_n(&s->port, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->gen, __ATOMIC_ACQUIRE) != g) continue;  // add/remove in between
+        if (!(g & 1)) return NULL;
+        if (gen) *gen = g;
+        return port;
     }
+}
 
-    xSemaphoreGive(registry_mutex);
-    return NULL;
+bool port_registry_valid(uint8_t port_id, uint32_t gen)
+{
+    return port_id < PORT_MAX_COUNT && __atomic_load_n(&ports[port_id].gen, __ATOMIC_ACQUIRE) == gen;
 }
 
 port_t *port_registry_get_by_name(const char *name)
 {
     if (!name) return NULL;
 
-    xSemaphoreTake(registry_mutex, portMAX_DELAY);
-
     for (int i = 0; i < PORT_MAX_COUNT; i++) {
-        if (ports[i] && strcmp(ports[i]->name, name) == 0) {
-            xSemaphoreGive(registry_mutex);
-            return ports[i];
-        }
+        port_t *port = port_registry_get(i);
+        if (port && strcmp(port->name, name) == 0) return port;
     }
-
-    xSemaphoreGive(registry_mutex);
     return NULL;
 }
 
 int port_registry_get_all(port_t **out, int max_count)
 {
-    xSemaphoreTake(registry_mutex, portMAX_DELAY);
-
     int count = 0;
     for (int i = 0; i < PORT_MAX_COUNT && count < max_count; i++) {
-        if (ports[i]) {
-            out[count++] = ports[i];
-        }
+        port_t *port = port_registry_get(i);
+        if (port) out[count++] = port;
     }
-
-    xSemaphoreGive(registry_mutex);
     return count;
 }
 
 int port_registry_count(void)
 {
-    return port_count;
+    return __atomic_load_n(&port_count, __ATOMIC_RELAXED);
 }
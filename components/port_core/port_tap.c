@@ -0,0 +1,172 @@
+#include "port_tap.h"
+#include "spsc_ring.h"
+#include "dp_notify.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "port_tap";
+
+uint32_t port_tap_mask[2];
+
+// One ring per port and direction, each with a single producer (the route
+// engine's pump for RX, the port's tx task for TX), so a chunk is copied in
+// without any lock and published whole.  Rings are allocated the first time
+// their tap is enabled and kept; tap_alloc says which exist.
+static spsc_ring_t  tap_rings[PORT_MAX_COUNT][2];
+static uint32_t     tap_alloc[2];           // port id bits, per direction
+static TaskHandle_t tap_reader;             // port_tap_read() caller
+static portMUX_TYPE tap_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t      tap_refs[PORT_MAX_COUNT][2];    // under tap_lock
+static uint64_t     tap_lost[PORT_MAX_COUNT][2];    // under tap_lock
+
+static bool tap_allocated(uint8_t port_id, int dir)
+{
+    return (__atomic_load_n(&tap_alloc[dir], __ATOMIC_ACQUIRE) >> port_id) & 1;
+}
+
+esp_err_t port_tap_enable(uint8_t port_id, int dir)
+{
+    if (port_id >= PORT_MAX_COUNT || (dir != PORT_TAP_RX && dir != PORT_TAP_TX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Only the web server enables taps, one at a time.
+    if (!tap_allocated(port_id, dir)) {
+        if (spsc_ring_init(&tap_rings[port_id][dir], PORT_TAP_RING_SIZE) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to allocate tap ring for port %d", port_id);
+            return ESP_ERR_NO_MEM;
+        }
+        __atomic_or_fetch(&tap_alloc[dir], 1u << port_id, __ATOMIC_RELEASE);
+    }
+
+    portENTER_CRITICAL(&tap_lock);
+    if (tap_refs[port_id][dir]++ == 0) {
+        __atomic_or_fetch(&port_tap_mask[dir], 1u << port_id, __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&tap_lock);
+    return ESP_OK;
+}
+
+void port_tap_disable(uint8_t port_id, int dir)
+{
+    if (port_id >= PORT_MAX_COUNT || (dir != PORT_TAP_RX && dir != PORT_TAP_TX)) return;
+
+    portENTER_CRITICAL(&tap_lock);
+    if (tap_refs[port_id][dir] && --tap_refs[port_id][dir] == 0) {
+        __atomic_and_fetch(&port_tap_mask[dir], ~(1u << port_id), __ATOMIC_RELAXED);
+    }
+    portEXIT_CRITICAL(&tap_lock);
+}
+
+// Copy len bytes between a ring and a buffer at ring sequence *at, across
+// the wrap point, and advance *at.
+static void tap_put(spsc_ring_t *r, uint32_t *at, const void *src, size_t len)
+{
+    uint32_t off   = *at & (r->size - 1);
+    size_t   first = r->size - off;
+    if (first > len) first = len;
+    memcpy(&r->buf[off], src, first);
+    memcpy(r->buf, (const uint8_t *)src + first, len - first);
+    *at += len;
+}
+
+static void tap_get(const spsc_ring_t *r, uint32_t *at, void *dst, size_t len)
+{
+    uint32_t off   = *at & (r->size - 1);
+    size_t   first = r->size - off;
+    if (first > len) first = len;
+    memcpy(dst, &r->buf[off], first);
+    memcpy((uint8_t *)dst + first, r->buf, len - first);
+    *at += len;
+}
+
+void port_tap_feed(port_t *port, int dir, uint32_t us, const port_iov_t *iov, int iovcnt, size_t len)
+{
+    spsc_ring_t *r = &tap_rings[port->id][dir];
+    port_tap_chunk_t chunk = { .us = us, .port_id = port->id, .dir = dir };
+    bool ready = tap_allocated(port->id, dir);
+    bool wake = false;
+    int i = 0;
+    size_t off = 0;
+
+    while (len > 0 && i < iovcnt) {
+        chunk.len = len < PORT_TAP_CHUNK_MAX ? len : PORT_TAP_CHUNK_MAX;
+        if (!ready || spsc_ring_space(r) < sizeof(chunk) + chunk.len) {
+            portENTER_CRITICAL(&tap_lock);
+            tap_lost[port->id][dir] += len;
+            portEXIT_CRITICAL(&tap_lock);
+            break;
+        }
+
+        uint32_t at = r->head;
+        tap_put(r, &at, &chunk, sizeof(chunk));
+        size_t left = chunk.len;
+        while (left > 0 && i < iovcnt) {
+            size_t n = iov[i].len - off;
+            if (n > left) n = left;
+            tap_put(r, &at, (const uint8_t *)iov[i].buf + off, n);
+            off  += n;
+            left -= n;
+            if (off == iov[i].len) {
+                i++;
+                off = 0;
+            }
+        }
+        wake |= spsc_ring_publish(r, sizeof(chunk) + chunk.len);
+        len -= chunk.len;
+    }
+
+    if (wake) {
+        TaskHandle_t reader = __atomic_load_n(&tap_reader, __ATOMIC_ACQUIRE);
+        if (reader) dp_notify(reader);
+    }
+}
+
+// Take the oldest chunk waiting in any ring.
+static bool tap_take_oldest(port_tap_chunk_t *chunk, uint8_t *data)
+{
+    spsc_ring_t *best = NULL;
+
+    for (int dir = PORT_TAP_RX; dir <= PORT_TAP_TX; dir++) {
+        uint32_t alloc = __atomic_load_n(&tap_alloc[dir], __ATOMIC_ACQUIRE);
+        for (int id = 0; alloc; id++, alloc >>= 1) {
+            if (!(alloc & 1)) continue;
+            spsc_ring_t *r = &tap_rings[id][dir];
+            uint32_t at = r->tail;
+            if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == at) continue;
+
+            port_tap_chunk_t c;
+            tap_get(r, &at, &c, sizeof(c));
+            if (!best || (int32_t)(c.us - chunk->us) < 0) {
+                best   = r;
+                *chunk = c;
+            }
+        }
+    }
+    if (!best) return false;
+
+    uint32_t at = best->tail + sizeof(*chunk);
+    tap_get(best, &at, data, chunk->len);
+    spsc_ring_consume(best, sizeof(*chunk) + chunk->len);
+    return true;
+}
+
+bool port_tap_read(port_tap_chunk_t *chunk, uint8_t *data, TickType_t timeout)
+{
+    // Producers notify the reader when a ring turns non-empty; a notice
+    // arriving between the scan and the wait is kept, so none is missed.
+    __atomic_store_n(&tap_reader, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+    if (tap_take_oldest(chunk, data)) return true;
+    ulTaskNotifyTake(pdTRUE, timeout);
+    return tap_take_oldest(chunk, data);
+}
+
+uint64_t port_tap_lost(uint8_t port_id, int dir)
+{
+    if (port_id >= PORT_MAX_COUNT) return 0;
+
+    portENTER_CRITICAL(&tap_lock);
+    uint64_t lost = tap_lost[port_id][dir];
+    portEXIT_CRITICAL(&tap_lock);
+    return lost;
+}
@@ -0,0 +1,144 @@
+#include "spsc_ring.h"
+#include "dp_notify.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+esp_err_t spsc_ring_init(spsc_ring_t *r, size_t size)
+{
+    uint32_t pow2 = 1;
+    while (pow2 < size) pow2 <<= 1;
+
+    memset(r, 0, sizeof(*r));
+    r->buf = heap_caps_aligned_alloc(SPSC_CACHE_LINE, pow2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!r->buf) return ESP_ERR_NO_MEM;
+    r->size = pow2;
+    return ESP_OK;
+}
+
+// --- Producer ---
+
+size_t spsc_ring_reserve(spsc_ring_t *r, uint8_t **ptr)
+{
+    uint32_t head = r->head;
+    uint32_t off  = head & (r->size - 1);
+    uint32_t contig = r->size - off;
+
+    // Only look at the consumer's cache line when the cached tail limits us.
+    uint32_t free = r->size - (head - r->tail_cache);
+    if (free < contig) {
+        r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        free = r->size - (head - r->tail_cache);
+    }
+
+    *ptr = &r->buf[off];
+    return free < contig ? free : contig;
+}
+
+bool spsc_ring_publish(spsc_ring_t *r, size_t len)
+{
+    if (len == 0) return false;
+
+    uint32_t head = r->head;
+    __atomic_store_n(&r->head, head + len, __ATOMIC_SEQ_CST);
+
+    // Only the empty -> non-empty transition needs a wakeup.  The consumer
+    // registers as waiter before its final emptiness check, so either it
+    // sees the new head or we see it waiting.
+    return __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) == head;
+}
+
+void spsc_ring_wake(spsc_ring_t *r)
+{
+    TaskHandle_t waiter = __atomic_load_n(&r->waiter, __ATOMIC_SEQ_CST);
+    if (waiter) dp_notify(waiter);
+}
+
+bool spsc_ring_commit(spsc_ring_t *r, size_t len)
+{
+    if (!spsc_ring_publish(r, len)) return false;
+    spsc_ring_wake(r);
+    return true;
+}
+
+size_t spsc_ring_push(spsc_ring_t *r, const uint8_t *data, size_t len, bool *was_empty)
+{
+    size_t done = 0;
+    bool empty = false;
+
+    // At most two spans: up to the wrap point, then from the start.
+    for (int i = 0; i < 2 && done < len; i++) {
+        uint8_t *dst;
+        size_t n = spsc_ring_reserve(r, &dst);
+        if (n == 0) break;
+        if (n > len - done) n = len - done;
+        memcpy(dst, data + done, n);
+        empty |= spsc_ring_commit(r, n);
+        done += n;
+    }
+
+    if (was_empty) *was_empty = empty;
+    return done;
+}
+
+size_t spsc_ring_space(spsc_ring_t *r)
+{
+    r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    return r->size - (r->head - r->tail_cache);
+}
+
+// --- Consumer ---
+
+size_t spsc_ring_peek(spsc_ring_t *r, const uint8_t **ptr)
+{
+    uint32_t tail = r->tail;
+    uint32_t off  = tail & (r->size - 1);
+    uint32_t contig = r->size - off;
+
+    uint32_t avail = r->head_cache - tail;
+    if (avail < contig) {
+        r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        avail = r->head_cache - tail;
+    }
+
+    *ptr = &r->buf[off];
+    return avail < contig ? avail : contig;
+}
+
+void spsc_ring_consume(spsc_ring_t *r, size_t len)
+{
+    __atomic_store_n(&r->tail, r->tail + len, __ATOMIC_SEQ_CST);
+}
+
+static size_t spsc_ring_pop(spsc_ring_t *r, uint8_t *dst, size_t len)
+{
+    size_t done = 0;
+
+    for (int i = 0; i < 2 && done < len; i++) {
+        const uint8_t *src;
+        size_t n = spsc_ring_peek(r, &src);
+        if (n == 0) break;
+        if (n > len - done) n = len - done;
+        memcpy(dst + done, src, n);
+        spsc_ring_consume(r, n);
+        done += n;
+    }
+    return done;
+}
+
+size_t spsc_ring_read(spsc_ring_t *r, uint8_t *dst, size_t len, TickType_t timeout)
+{
+    size_t n = spsc_ring_pop(r, dst, len);
+    if (n > 0 || timeout == 0) return n;
+
+    TimeOut_t to;
+    vTaskSetTimeOutState(&to);
+    for (;;) {
+        __atomic_store_n(&r->waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        n = spsc_ring_pop(r, dst, len);
+        if (n > 0 || xTaskCheckForTimeOut(&to, &timeout) == pdTRUE) break;
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+    __atomic_store_n(&r->waiter, NULL, __ATOMIC_RELAXED);
+    return n;
+}
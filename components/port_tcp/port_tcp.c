@@ -12,12 +12,14 @@ static const char *TAG = "port_tcp";
 
 #define TCP_RECONNECT_DELAY_MS  3000
 #define TCP_ACCEPT_TIMEOUT_MS   1000
+#define TCP_RX_CHUNK            1460    // one full-size segment
+#define TCP_RX_STALL_POLL_MS    10
 
 typedef struct {
     tcp_port_config_t   cfg;
     int                 listen_fd;
     int                 client_fd;
-    TaskHandle_t        accept_task;
+    TaskHandle_t        conn_task;
     volatile bool       task_running;
 } tcp_priv_t;
 
@@ -25,74 +27,62 @@ static port_t tcp_ports[TCP_PORT_COUNT];
 static tcp_priv_t tcp_priv[TCP_PORT_COUNT];
 static int tcp_port_count = 0;
 
-// --- Server accept task ---
+// --- Receive path ---
+// Receives from the connected socket straight into port->rx_ring.
 
-static void tcp_accept_task(void *arg)
+static void tcp_rx_once(port_t *port)
 {
-    port_t *port = (port_t *)arg;
     tcp_priv_t *priv = (tcp_priv_t *)port->priv;
+    uint8_t *dst;
 
-    ESP_LOGI(TAG, "%s: server listening on port %d", port->name, priv->cfg.tcp_port);
+    size_t space = port_rx_reserve(port, &dst);
+    if (space == 0) return;
 
-    while (priv->task_running) {
-        struct sockaddr_in client_addr;
-        socklen_t addr_len = sizeof(client_addr);
+    int n = recv(priv->client_fd, dst, space, 0);
+    if (n <= 0) {
+        ESP_LOGI(TAG, "%s: %s", port->name,
+                 priv->cfg.is_server ? "client disconnected" : "connection lost");
+        close(priv->client_fd);
+        priv->client_fd = -1;
+        port->state = PORT_STATE_READY;
+        port->signals &= ~SIGNAL_DCD;
+        port_signals_changed(port);
+        return;
+    }
 
-        // Use select with timeout so we can check task_running
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(priv->listen_fd, &rfds);
-        struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+    port_rx_commit(port, n);
+}
 
-        int sel = select(priv->listen_fd + 1, &rfds, NULL, NULL, &tv);
-        if (sel <= 0) continue;
+// --- Server accept ---
 
-        int fd = accept(priv->listen_fd, (struct sockaddr *)&client_addr, &addr_len);
-        if (fd < 0) {
-            ESP_LOGW(TAG, "%s: accept failed: %d", port->name, errno);
-            continue;
-        }
+// Accept a pending connection on the (readable) listen socket.
+// A new client replaces the previous one.
+static void tcp_accept_one(port_t *port)
+{
+    tcp_priv_t *priv = (tcp_priv_t *)port->priv;
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
 
-        // Close previous client if any
-        if (priv->client_fd >= 0) {
-            close(priv->client_fd);
-        }
+    int fd = accept(priv->listen_fd, (struct sockaddr *)&client_addr, &addr_len);
+    if (fd < 0) {
+        ESP_LOGW(TAG, "%s: accept failed: %d", port->name, errno);
+        return;
+    }
 
-        priv->client_fd = fd;
-        port->state = PORT_STATE_ACTIVE;
-        port->signals |= SIGNAL_DCD;  // Connection established
-
-        char addr_str[16];
-        inet_ntoa_r(client_addr.sin_addr, addr_str, sizeof(addr_str));
-        ESP_LOGI(TAG, "%s: client connected from %s:%d",
-                 port->name, addr_str, ntohs(client_addr.sin_port));
-
-        // Wait for disconnect
-        while (priv->task_running && priv->client_fd >= 0) {
-            // Check if client is still connected
-            char probe;
-            fd_set check;
-            FD_ZERO(&check);
-            FD_SET(priv->client_fd, &check);
-            struct timeval check_tv = { .tv_sec = 1, .tv_usec = 0 };
-
-            int ready = select(priv->client_fd + 1, &check, NULL, NULL, &check_tv);
-            if (ready > 0) {
-                int n = recv(priv->client_fd, &probe, 1, MSG_PEEK);
-                if (n == 0) {
-                    // Client disconnected
-                    ESP_LOGI(TAG, "%s: client disconnected", port->name);
-                    close(priv->client_fd);
-                    priv->client_fd = -1;
-                    port->state = PORT_STATE_READY;
-                    port->signals &= ~SIGNAL_DCD;
-                    break;
-                }
-            }
-        }
+    // Close previous client if any
+    if (priv->client_fd >= 0) {
+        close(priv->client_fd);
     }
 
-    vTaskDelete(NULL);
+    priv->client_fd = fd;
+    port->state = PORT_STATE_ACTIVE;
+    port->signals |= SIGNAL_DCD;  // Connection established
+    port_signals_changed(port);
+
+    char addr_str[16];
+    inet_ntoa_r(client_addr.sin_addr, addr_str, sizeof(addr_str));
+    ESP_LOGI(TAG, "%s: client connected from %s:%d",
+             port->name, addr_str, ntohs(client_addr.sin_port));
 }
 
 // --- Client connect logic ---
@@ -123,11 +113,68 @@ static int tcp_client_connect(port_t *port)
     priv->client_fd = fd;
     port->state = PORT_STATE_ACTIVE;
     port->signals |= SIGNAL_DCD;
+    port_signals_changed(port);
 
     ESP_LOGI(TAG, "%s: connected to %s:%d", port->name, priv->cfg.host, priv->cfg.tcp_port);
     return 0;
 }
 
+// --- Connection task ---
+// Owns the sockets: accepts (server) or connects/reconnects (client) and
+// receives from the connected peer.
+
+static void tcp_conn_task(void *arg)
+{
+    port_t *port = (port_t *)arg;
+    tcp_priv_t *priv = (tcp_priv_t *)port->priv;
+
+    if (priv->cfg.is_server) {
+        ESP_LOGI(TAG, "%s: server listening on port %d", port->name, priv->cfg.tcp_port);
+    }
+
+    while (priv->task_running) {
+        if (!priv->cfg.is_server && priv->client_fd < 0) {
+            if (tcp_client_connect(port) != 0) {
+                vTaskDelay(pdMS_TO_TICKS(TCP_RECONNECT_DELAY_MS));
+            }
+            continue;
+        }
+
+        // Use select with timeout so we can check task_running.  While rx_ring
+        // is full the client socket is left unread, so its receive window
+        // closes and the peer stops sending; poll for room meanwhile.
+        bool stalled = port_rx_space(port) == 0;
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        int max_fd = -1;
+        if (priv->listen_fd >= 0) {
+            FD_SET(priv->listen_fd, &rfds);
+            max_fd = priv->listen_fd;
+        }
+        if (priv->client_fd >= 0 && !stalled) {
+            FD_SET(priv->client_fd, &rfds);
+            if (priv->client_fd > max_fd) max_fd = priv->client_fd;
+        }
+        struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+        if (stalled) {
+            tv.tv_sec  = 0;
+            tv.tv_usec = TCP_RX_STALL_POLL_MS * 1000;
+        }
+
+        int sel = select(max_fd + 1, &rfds, NULL, NULL, &tv);
+        if (sel <= 0) continue;
+
+        if (priv->client_fd >= 0 && FD_ISSET(priv->client_fd, &rfds)) {
+            tcp_rx_once(port);
+        }
+        if (priv->listen_fd >= 0 && FD_ISSET(priv->listen_fd, &rfds)) {
+            tcp_accept_one(port);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
 // --- Port ops ---
 
 static int tcp_open(port_t *port)
@@ -163,21 +210,17 @@ static int tcp_open(port_t *port)
             priv->listen_fd = -1;
             return -1;
         }
-
-        // Start accept task
-        priv->task_running = true;
-        char name[16];
-        snprintf(name, sizeof(name), "tcp_s%.4s", port->name + 3);
-        xTaskCreate(tcp_accept_task, name, 4096, port, 4, &priv->accept_task);
-
-        port->state = PORT_STATE_READY;
-    } else {
-        // Client mode: attempt connection
-        if (tcp_client_connect(port) != 0) {
-            port->state = PORT_STATE_READY;  // Will retry on read/write
-        }
     }
 
+    // Connection task accepts or connects (and reconnects) in the background
+    port->state = PORT_STATE_READY;
+    priv->task_running = true;
+    char name[16];
+    snprintf(name, sizeof(name), "tcp_%c%.4s", priv->cfg.is_server ? 's' : 'c', port->name + 3);
+    // Run next to the lwIP core task when it is pinned.
+    xTaskCreatePinnedToCore(tcp_conn_task, name, 4096, port, 4, &priv->conn_task,
+                            port->home_core >= 0 ? port->home_core : tskNO_AFFINITY);
+
     return 0;
 }
 
@@ -186,9 +229,9 @@ static void tcp_close(port_t *port)
     tcp_priv_t *priv = (tcp_priv_t *)port->priv;
 
     priv->task_running = false;
-    if (priv->accept_task) {
-        vTaskDelay(pdMS_TO_TICKS(1500));  // Let accept task exit
-        priv->accept_task = NULL;
+    if (priv->conn_task) {
+        vTaskDelay(pdMS_TO_TICKS(1500));  // Let connection task exit
+        priv->conn_task = NULL;
     }
 
     if (priv->client_fd >= 0) {
@@ -202,68 +245,58 @@ static void tcp_close(port_t *port)
 
     port->state = PORT_STATE_DISABLED;
     port->signals &= ~SIGNAL_DCD;
+    port_signals_changed(port);
     ESP_LOGI(TAG, "%s closed", port->name);
 }
 
 static int tcp_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout)
 {
-    tcp_priv_t *priv = (tcp_priv_t *)port->priv;
-
-    if (priv->client_fd < 0) {
-        // Client mode: try reconnect
-        if (!priv->cfg.is_server) {
-            tcp_client_connect(port);
-        }
-        if (priv->client_fd < 0) return 0;
-    }
-
-    // Use select with timeout
-    fd_set rfds;
-    FD_ZERO(&rfds);
-    FD_SET(priv->client_fd, &rfds);
+    // Read from the RX ring (filled by the connection task)
+    size_t received = port_rx_read(port, buf, len, timeout);
+    return (int)received;
+}
 
-    int timeout_ms = (timeout * portTICK_PERIOD_MS);
-    struct timeval tv = {
-        .tv_sec = timeout_ms / 1000,
-        .tv_usec = (timeout_ms % 1000) * 1000,
-    };
+static int tcp_write(port_t *port, const uint8_t *buf, size_t len, TickType_t timeout)
+{
+    tcp_priv_t *priv = (tcp_priv_t *)port->priv;
+    (void)timeout;
 
-    int sel = select(priv->client_fd + 1, &rfds, NULL, NULL, &tv);
-    if (sel <= 0) return 0;
+    int fd = priv->client_fd;
+    if (fd < 0) return -1;      // between connections: flush, don't hold for the next peer
 
-    int n = recv(priv->client_fd, buf, len, 0);
-    if (n <= 0) {
-        // Connection closed or error
-        ESP_LOGI(TAG, "%s: connection lost", port->name);
-        close(priv->client_fd);
-        priv->client_fd = -1;
-        port->state = PORT_STATE_READY;
-        port->signals &= ~SIGNAL_DCD;
+    int n = send(fd, buf, len, 0);
+    if (n < 0) {
+        // Let the connection task notice and clean up the socket
+        ESP_LOGW(TAG, "%s: send failed: %d", port->name, errno);
+        shutdown(fd, SHUT_RDWR);
         return 0;
     }
 
     return n;
 }
 
-static int tcp_write(port_t *port, const uint8_t *buf, size_t len, TickType_t timeout)
+// One sendmsg() for all segments, so they can share a TCP segment.
+static int tcp_writev(port_t *port, const port_iov_t *iov, int iovcnt, TickType_t timeout)
 {
     tcp_priv_t *priv = (tcp_priv_t *)port->priv;
     (void)timeout;
 
-    if (priv->client_fd < 0) {
-        if (!priv->cfg.is_server) {
-            tcp_client_connect(port);
-        }
-        if (priv->client_fd < 0) return 0;
-    }
+    int fd = priv->client_fd;
+    if (fd < 0) return -1;
 
-    int n = send(priv->client_fd, buf, len, 0);
+    struct iovec v[PORT_IOV_MAX];
+    for (int i = 0; i < iovcnt; i++) {
+        v[i].iov_base = (void *)iov[i].buf;
+        v[i].iov_len  = iov[i].len;
+    }
+    struct msghdr msg = {
+        .msg_iov    = v,
+        .msg_iovlen = iovcnt,
+    };
+    int n = sendmsg(fd, &msg, 0);
     if (n < 0) {
-        ESP_LOGW(TAG, "%s: send failed: %d", port->name, errno);
-        close(priv->client_fd);
-        priv->client_fd = -1;
-        port->state = PORT_STATE_READY;
-        port->signals &= ~SIGNAL_DCD;
+        ESP_LOGW(TAG, "%s: sendmsg failed: %d", port->name, errno);
+        shutdown(fd, SHUT_RDWR);
         return 0;
     }
 
@@ -301,6 +334,7 @@ static const port_ops_t tcp_ops = {
     .close          = tcp_close,
     .read           = tcp_read,
     .write          = tcp_write,
+    .writev         = tcp_writev,
     .get_signals    = tcp_get_signals,
     .set_signals    = tcp_set_signals,
     .set_line_coding = tcp_set_line_coding,
@@ -326,7 +360,7 @@ esp_err_t port_tcp_init(uint8_t port_id, const tcp_port_config_t *cfg)
     priv->cfg = *cfg;
     priv->listen_fd = -1;
     priv->client_fd = -1;
-    priv->accept_task = NULL;
+    priv->conn_task = NULL;
     priv->task_running = false;
 
     port_t *port = &tcp_ports[idx];
@@ -337,11 +371,12 @@ esp_err_t port_tcp_init(uint8_t port_id, const tcp_port_config_t *cfg)
     port->state = PORT_STATE_DISABLED;
     port->ops = tcp_ops;
     port->line_coding = port_line_coding_default();
+    port->packet_size = TCP_RX_CHUNK;
+    port->home_core = CONFIG_LWIP_TCPIP_TASK_AFFINITY < portNUM_PROCESSORS
+                      ? CONFIG_LWIP_TCPIP_TASK_AFFINITY : PORT_CORE_ANY;
     port->priv = priv;
 
-    port->rx_buf = xStreamBufferCreate(PORT_BUF_SIZE, 1);
-    if (!port->rx_buf) {
-        ESP_LOGE(TAG, "Failed to create rx buffer for %s", port->name);
+    if (port_rx_init(port) != ESP_OK || port_tx_init(port) != ESP_OK) {
         return ESP_ERR_NO_MEM;
     }
 
@@ -1,75 +1,150 @@
 #include "port_uart.h"
 #include "port_registry.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include <string.h>
 
 static const char *TAG = "port_uart";
 
 #define UART_RX_BUF_SIZE    1024
-#define SIGNAL_POLL_MS      10
+#define UART_EVENT_Q_LEN    16
+#define UART_RX_CHUNK       256
+#define UART_TASK_EXIT_MS   20
 
 typedef struct {
     uart_port_t     uart_num;
     uart_pin_config_t pins;
-    TaskHandle_t    signal_task;
-    volatile bool   signal_task_running;
+    QueueHandle_t   event_queue;
+    TaskHandle_t    rx_task;
+    volatile bool   rx_task_running;
+    volatile bool   rx_stalled;     // rx_ring full, data held in the driver
 } uart_priv_t;
 
 static port_t uart_ports[UART_PORT_COUNT];
 static uart_priv_t uart_priv[UART_PORT_COUNT];
 static int uart_port_count = 0;
 
-// --- Signal polling task ---
-// Polls GPIO-based signal lines (DSR, DCD, RI) and updates port state
+// --- Signal inputs ---
+// CTS, DSR, DCD and RI raise a GPIO interrupt on every edge.  The ISR only
+// reports the change; the signal router then reads the pins back through
+// uart_get_signals() in task context.
 
-static void uart_signal_poll_task(void *arg)
+static void IRAM_ATTR uart_signal_isr(void *arg)
 {
-    port_t *port = (port_t *)arg;
-    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    BaseType_t woken = pdFALSE;
+    port_signals_changed_from_isr((port_t *)arg, &woken);
+    portYIELD_FROM_ISR(woken);
+}
 
-    while (priv->signal_task_running) {
-        uint32_t new_signals = port->signals;
+static void uart_signal_sample(port_t *port)
+{
+    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    const struct { int pin; uint32_t bit; } inputs[] = {
+        { priv->pins.cts_pin, SIGNAL_CTS },
+        { priv->pins.dsr_pin, SIGNAL_DSR },
+        { priv->pins.dcd_pin, SIGNAL_DCD },
+        { priv->pins.ri_pin,  SIGNAL_RI  },
+    };
 
-        // Read CTS from UART hardware (if pin configured)
-        if (priv->pins.cts_pin >= 0) {
-            if (gpio_get_level(priv->pins.cts_pin)) {
-                new_signals |= SIGNAL_CTS;
-            } else {
-                new_signals &= ~SIGNAL_CTS;
-            }
+    uint32_t signals = port->signals;
+    for (int i = 0; i < 4; i++) {
+        if (inputs[i].pin < 0) continue;
+        if (gpio_get_level(inputs[i].pin)) {
+            signals |= inputs[i].bit;
+        } else {
+            signals &= ~inputs[i].bit;
         }
+    }
+    port->signals = signals;
+}
 
-        // Read DSR from GPIO (if pin configured)
-        if (priv->pins.dsr_pin >= 0) {
-            if (gpio_get_level(priv->pins.dsr_pin)) {
-                new_signals |= SIGNAL_DSR;
-            } else {
-                new_signals &= ~SIGNAL_DSR;
-            }
+static void uart_signal_irq(port_t *port, bool enable)
+{
+    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    const int pins[] = { priv->pins.cts_pin, priv->pins.dsr_pin, priv->pins.dcd_pin, priv->pins.ri_pin };
+
+    for (int i = 0; i < 4; i++) {
+        if (pins[i] < 0) continue;
+        if (enable) {
+            gpio_set_intr_type(pins[i], GPIO_INTR_ANYEDGE);
+            gpio_isr_handler_add(pins[i], uart_signal_isr, port);
+            gpio_intr_enable(pins[i]);
+        } else {
+            gpio_intr_disable(pins[i]);
+            gpio_isr_handler_remove(pins[i]);
         }
+    }
+}
 
-        // Read DCD from GPIO (if pin configured)
-        if (priv->pins.dcd_pin >= 0) {
-            if (gpio_get_level(priv->pins.dcd_pin)) {
-                new_signals |= SIGNAL_DCD;
-            } else {
-                new_signals &= ~SIGNAL_DCD;
-            }
+// --- RX task ---
+// Blocks on the UART driver event queue and moves received bytes into
+// port->rx_ring, so readers are woken only when data actually arrives.
+//
+// Only as much as fits in rx_ring is taken from the driver.  When rx_ring is
+// full the driver ring buffer fills next, the driver stops emptying the
+// hardware FIFO and, with RTS/CTS enabled, the UART deasserts RTS.
+// uart_read() nudges this task once it has made room.
+
+static void uart_rx_drain(port_t *port)
+{
+    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    uint8_t *dst;
+    size_t space;
+    int n;
+
+    for (;;) {
+        while ((space = port_rx_reserve(port, &dst)) > 0) {
+            if (space > UART_RX_CHUNK) space = UART_RX_CHUNK;
+            n = uart_read_bytes(priv->uart_num, dst, space, 0);
+            if (n <= 0) break;
+            port_rx_commit(port, n);
         }
+        if (space > 0) {
+            __atomic_store_n(&priv->rx_stalled, false, __ATOMIC_RELAXED);
+            return;
+        }
+
+        // rx_ring is full.  Flag the stall before looking at the ring once
+        // more: a reader that emptied it before the flag was visible sent no
+        // nudge, and none will come again.
+        __atomic_store_n(&priv->rx_stalled, true, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (port_rx_space(port) == 0) return;
+    }
+}
 
-        // Read RI from GPIO (if pin configured)
-        if (priv->pins.ri_pin >= 0) {
-            if (gpio_get_level(priv->pins.ri_pin)) {
-                new_signals |= SIGNAL_RI;
-            } else {
-                new_signals &= ~SIGNAL_RI;
+static void uart_rx_task(void *arg)
+{
+    port_t *port = (port_t *)arg;
+    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    uart_event_t event;
+
+    while (priv->rx_task_running) {
+        if (xQueueReceive(priv->event_queue, &event, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (event.type) {
+        case UART_DATA:
+        case UART_BUFFER_FULL:
+        case UART_EVENT_MAX:        // resume nudge from uart_read()
+            uart_rx_drain(port);
+            break;
+        case UART_FIFO_OVF:
+            // Hardware FIFO overran (no flow control): data is already lost.
+            ESP_LOGW(TAG, "%s: RX FIFO overflow, flushing", port->name);
+            {
+                size_t pending = 0;
+                uart_get_buffered_data_len(priv->uart_num, &pending);
+                port_rx_overflow(port, pending);
             }
+            uart_flush_input(priv->uart_num);
+            xQueueReset(priv->event_queue);
+            break;
+        default:
+            break;
         }
-
-        port->signals = new_signals;
-        vTaskDelay(pdMS_TO_TICKS(SIGNAL_POLL_MS));
     }
 
     vTaskDelete(NULL);
@@ -124,7 +199,8 @@ static int uart_open(port_t *port)
         return -1;
     }
 
-    ret = uart_driver_install(priv->uart_num, UART_RX_BUF_SIZE * 2, UART_RX_BUF_SIZE, 0, NULL, 0);
+    ret = uart_driver_install(priv->uart_num, UART_RX_BUF_SIZE * 2, UART_RX_BUF_SIZE,
+                              UART_EVENT_Q_LEN, &priv->event_queue, 0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "%s: uart_driver_install failed: %s", port->name, esp_err_to_name(ret));
         return -1;
@@ -160,13 +236,22 @@ static int uart_open(port_t *port)
         gpio_config(&io_conf);
     }
 
-    // Start signal polling task
-    priv->signal_task_running = true;
+    // Start RX task
+    priv->rx_task_running = true;
     char task_name[24];
-    snprintf(task_name, sizeof(task_name), "sig_%.8s", port->name);
-    xTaskCreate(uart_signal_poll_task, task_name, 2048, port, 4, &priv->signal_task);
+    snprintf(task_name, sizeof(task_name), "rx_%.8s", port->name);
+    xTaskCreate(uart_rx_task, task_name, 3072, port, 5, &priv->rx_task);
+
+    // Signal input edges. The ISR service may already be installed.
+    esp_err_t isr_ret = gpio_install_isr_service(0);
+    if (isr_ret == ESP_OK || isr_ret == ESP_ERR_INVALID_STATE) {
+        uart_signal_irq(port, true);
+    } else {
+        ESP_LOGW(TAG, "%s: no GPIO ISR service, input signals not tracked", port->name);
+    }
 
     port->state = PORT_STATE_ACTIVE;
+    port_signals_changed(port);     // initial pin levels
     ESP_LOGI(TAG, "%s opened: %lu baud on TX=%d RX=%d",
              port->name, (unsigned long)port->line_coding.baud_rate,
              priv->pins.tx_pin, priv->pins.rx_pin);
@@ -177,10 +262,15 @@ static void uart_close(port_t *port)
 {
     uart_priv_t *priv = (uart_priv_t *)port->priv;
 
-    priv->signal_task_running = false;
-    if (priv->signal_task) {
-        vTaskDelay(pdMS_TO_TICKS(SIGNAL_POLL_MS * 2));  // Let task exit
-        priv->signal_task = NULL;
+    uart_signal_irq(port, false);
+
+    // Wake the RX task with a dummy event so it sees the stop flag.
+    priv->rx_task_running = false;
+    if (priv->rx_task) {
+        uart_event_t wake = { .type = UART_EVENT_MAX };
+        xQueueSend(priv->event_queue, &wake, 0);
+        vTaskDelay(pdMS_TO_TICKS(UART_TASK_EXIT_MS));  // Let task exit
+        priv->rx_task = NULL;
     }
 
     uart_driver_delete(priv->uart_num);
@@ -191,8 +281,15 @@ static void uart_close(port_t *port)
 static int uart_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout)
 {
     uart_priv_t *priv = (uart_priv_t *)port->priv;
-    int received = uart_read_bytes(priv->uart_num, buf, len, timeout);
-    return received > 0 ? received : 0;
+
+    // Read from the RX ring (filled by the RX task)
+    size_t received = port_rx_read(port, buf, len, timeout);
+
+    if (received > 0 && __atomic_exchange_n(&priv->rx_stalled, false, __ATOMIC_SEQ_CST)) {
+        uart_event_t resume = { .type = UART_EVENT_MAX };
+        xQueueSend(priv->event_queue, &resume, 0);
+    }
+    return (int)received;
 }
 
 static int uart_write(port_t *port, const uint8_t *buf, size_t len, TickType_t timeout)
@@ -203,8 +300,24 @@ static int uart_write(port_t *port, const uint8_t *buf, size_t len, TickType_t t
     return written > 0 ? written : 0;
 }
 
+// Copy the segments into the driver's TX ring back to back.
+static int uart_writev(port_t *port, const port_iov_t *iov, int iovcnt, TickType_t timeout)
+{
+    uart_priv_t *priv = (uart_priv_t *)port->priv;
+    (void)timeout;
+
+    int written = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int n = uart_write_bytes(priv->uart_num, iov[i].buf, iov[i].len);
+        if (n > 0) written += n;
+        if (n < (int)iov[i].len) break;
+    }
+    return written;
+}
+
 static int uart_get_signals(port_t *port, uint32_t *signals)
 {
+    if (port->state != PORT_STATE_DISABLED) uart_signal_sample(port);
     *signals = port_get_effective_signals(port);
     return 0;
 }
@@ -285,6 +398,7 @@ static const port_ops_t uart_ops = {
     .close          = uart_close,
     .read           = uart_read,
     .write          = uart_write,
+    .writev         = uart_writev,
     .get_signals    = uart_get_signals,
     .set_signals    = uart_set_signals,
     .set_line_coding = uart_set_line_coding,
@@ -304,8 +418,9 @@ esp_err_t port_uart_init(uint8_t port_id, const uart_pin_config_t *pin_cfg)
     uart_priv_t *priv = &uart_priv[idx];
     priv->uart_num = pin_cfg->uart_num;
     priv->pins = *pin_cfg;
-    priv->signal_task = NULL;
-    priv->signal_task_running = false;
+    priv->event_queue = NULL;
+    priv->rx_task = NULL;
+    priv->rx_task_running = false;
 
     port_t *port = &uart_ports[idx];
     memset(port, 0, sizeof(port_t));
@@ -315,11 +430,11 @@ esp_err_t port_uart_init(uint8_t port_id, const uart_pin_config_t *pin_cfg)
     port->state = PORT_STATE_DISABLED;
     port->ops = uart_ops;
     port->line_coding = port_line_coding_default();
+    port->packet_size = UART_RX_CHUNK;
+    port->home_core = PORT_CORE_ANY;
     port->priv = priv;
 
-    port->rx_buf = xStreamBufferCreate(PORT_BUF_SIZE, 1);
-    if (!port->rx_buf) {
-        ESP_LOGE(TAG, "Failed to create rx buffer for %s", port->name);
+    if (port_rx_init(port) != ESP_OK || port_tx_init(port) != ESP_OK) {
         return ESP_ERR_NO_MEM;
     }
 
@@ -0,0 +1,151 @@
+#include "elastic_buf.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+#define ELASTIC_MIN_SIZE    1024
+#define ELASTIC_BURST_MIN   64
+#define ELASTIC_BURST_MAX   512     // stays below the UART driver's TX ring
+
+esp_err_t elastic_buf_init(elastic_buf_t *e, size_t limit)
+{
+    uint32_t size = ELASTIC_MIN_SIZE;
+    while (size * 2 <= limit) size *= 2;
+
+    memset(e, 0, sizeof(*e));
+    e->buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!e->buf) return ESP_ERR_NO_MEM;
+    e->size = size;
+    return ESP_OK;
+}
+
+void elastic_buf_free(elastic_buf_t *e)
+{
+    heap_caps_free(e->buf);
+    e->buf  = NULL;
+    __atomic_store_n(&e->size, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->tail, e->head, __ATOMIC_RELAXED);
+}
+
+void elastic_buf_set_rate(elastic_buf_t *e, uint32_t bytes_per_s)
+{
+    uint32_t burst = bytes_per_s / 50;
+    if (burst < ELASTIC_BURST_MIN) burst = ELASTIC_BURST_MIN;
+    if (burst > ELASTIC_BURST_MAX) burst = ELASTIC_BURST_MAX;
+    if (bytes_per_s != e->rate) e->tokens = burst;
+    e->rate  = bytes_per_s;
+    e->burst = burst;
+}
+
+uint32_t elastic_buf_tokens(elastic_buf_t *e, int64_t now)
+{
+    if (!e->rate) return UINT32_MAX;
+
+    int64_t dt = now - e->refill_us;
+    if (dt <= 0) return e->tokens;
+    if (dt >= 1000000) {
+        e->tokens    = e->burst;
+        e->refill_us = now;
+        return e->tokens;
+    }
+    uint64_t add = (uint64_t)dt * e->rate / 1000000;
+    if (add == 0) return e->tokens;
+
+    // Advance the refill time only by what was credited, so rounding does
+    // not slow the pacer down.
+    e->refill_us += (int64_t)(add * 1000000 / e->rate);
+    if (add >= e->burst - e->tokens) {
+        e->tokens    = e->burst;
+        e->refill_us = now;
+    } else {
+        e->tokens += add;
+    }
+    return e->tokens;
+}
+
+void elastic_buf_spend(elastic_buf_t *e, uint32_t n)
+{
+    if (!e->rate) return;
+    e->tokens = n < e->tokens ? e->tokens - n : 0;
+}
+
+int64_t elastic_buf_wait_us(const elastic_buf_t *e, uint32_t want)
+{
+    if (!e->rate) return 0;
+    if (want > e->burst) want = e->burst;
+    if (want <= e->tokens) return 0;
+    return ((int64_t)(want - e->tokens) * 1000000 + e->rate - 1) / e->rate;
+}
+
+size_t elastic_buf_put(elastic_buf_t *e, const uint8_t *data, size_t len, bool drop_old)
+{
+    size_t discard = 0;
+    if (len > e->size) {
+        // Only the newest bytes can be kept, or none of the new ones.
+        discard = drop_old ? len - e->size : len;
+        if (drop_old) data += discard;
+        len -= discard;
+    }
+
+    uint32_t space = elastic_buf_space(e);
+    if (len > space) {
+        if (drop_old) {
+            uint32_t old = len - space;
+            __atomic_store_n(&e->tail, e->tail + old, __ATOMIC_RELAXED);
+            discard += old;
+        } else {
+            discard += len - space;
+            len = space;
+        }
+    }
+
+    uint32_t off   = e->head & (e->size - 1);
+    uint32_t first = e->size - off;
+    if (first > len) first = len;
+    memcpy(&e->buf[off], data, first);
+    memcpy(e->buf, data + first, len - first);
+    __atomic_store_n(&e->head, e->head + len, __ATOMIC_RELAXED);
+
+    uint32_t fill = elastic_buf_fill(e);
+    if (fill > e->marks.high_water || discard) {
+        seqcount_write_begin(&e->seq);
+        if (fill > e->marks.high_water) e->marks.high_water = fill;
+        e->marks.overflow += discard;
+        seqcount_write_end(&e->seq);
+    }
+    return discard;
+}
+
+int elastic_buf_iov(const elastic_buf_t *e, size_t max, port_iov_t iov[2])
+{
+    uint32_t off    = e->tail & (e->size - 1);
+    uint32_t contig = e->size - off;
+    size_t   len    = elastic_buf_fill(e);
+    if (len > max) len = max;
+
+    if (len <= contig) {
+        iov[0] = (port_iov_t){ &e->buf[off], len };
+        return 1;
+    }
+    iov[0] = (port_iov_t){ &e->buf[off], contig };
+    iov[1] = (port_iov_t){ e->buf, len - contig };
+    return 2;
+}
+
+void elastic_buf_consume(elastic_buf_t *e, size_t len)
+{
+    __atomic_store_n(&e->tail, e->tail + len, __ATOMIC_RELAXED);
+}
+
+void elastic_buf_stats(const elastic_buf_t *e, elastic_stats_t *out)
+{
+    struct elastic_marks marks;
+    seqcount_read(&e->seq, &marks, &e->marks, sizeof(marks));
+
+    uint32_t head = __atomic_load_n(&e->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&e->tail, __ATOMIC_RELAXED);
+    out->capacity   = __atomic_load_n(&e->size, __ATOMIC_RELAXED);
+    out->fill       = out->capacity ? head - tail : 0;
+    out->high_water = marks.high_water;
+    out->overflow   = marks.overflow;
+    out->rate       = e->rate;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "seqcount.h"
+#include "port.h"
+
+// Elastic byte buffer with a token-bucket pacer, in front of a destination
+// slower than its source.  Storage comes from PSRAM.  The pacer releases
+// bytes no faster than the destination's line rate, so a paced write never
+// blocks in the driver.  One task owns the buffer; any task may read
+// elastic_buf_stats().
+
+typedef struct {
+    uint8_t    *buf;
+    uint32_t    size;           // power of two, 0 if not allocated
+    uint32_t    head;           // free-running
+    uint32_t    tail;
+    uint32_t    rate;           // bytes per second, 0 = unpaced
+    uint32_t    burst;          // bucket depth
+    uint32_t    tokens;
+    int64_t     refill_us;
+    seqcount_t  seq;
+    struct elastic_marks {
+        uint32_t high_water;
+        uint64_t overflow;      // bytes discarded by the overflow policy
+    } marks;                    // guarded by seq
+} elastic_buf_t;
+
+typedef struct {
+    uint32_t    capacity;       // bytes, 0 if the buffer is not in use
+    uint32_t    fill;
+    uint32_t    high_water;     // largest fill since the buffer was allocated
+    uint64_t    overflow;
+    uint32_t    rate;           // pacing rate in bytes per second, 0 = unpaced
+} elastic_stats_t;
+
+// Allocate up to limit bytes (rounded down to a power of two) of PSRAM.
+esp_err_t elastic_buf_init(elastic_buf_t *e, size_t limit);
+void elastic_buf_free(elastic_buf_t *e);
+
+static inline uint32_t elastic_buf_fill(const elastic_buf_t *e)
+{
+    return e->head - e->tail;
+}
+
+static inline uint32_t elastic_buf_space(const elastic_buf_t *e)
+{
+    return e->size - (e->head - e->tail);
+}
+
+// Pace to bytes_per_s (0 = unpaced).  The bucket holds about 20 ms worth.
+void elastic_buf_set_rate(elastic_buf_t *e, uint32_t bytes_per_s);
+
+// Tokens available now; spend them with elastic_buf_spend().
+uint32_t elastic_buf_tokens(elastic_buf_t *e, int64_t now);
+void elastic_buf_spend(elastic_buf_t *e, uint32_t n);
+
+// Microseconds until want tokens (capped at the bucket depth) are available.
+int64_t elastic_buf_wait_us(const elastic_buf_t *e, uint32_t want);
+
+// Append len bytes.  When they do not fit, drop_old discards the oldest
+// buffered bytes to make room, otherwise the excess of data is discarded.
+// Returns the number of bytes discarded.
+size_t elastic_buf_put(elastic_buf_t *e, const uint8_t *data, size_t len, bool drop_old);
+
+// The oldest min(fill, max) buffered bytes as at most two segments, and
+// their release.  Returns the segment count.
+int elastic_buf_iov(const elastic_buf_t *e, size_t max, port_iov_t iov[2]);
+void elastic_buf_consume(elastic_buf_t *e, size_t len);
+
+void elastic_buf_stats(const elastic_buf_t *e, elastic_stats_t *out);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include "seqcount.h"
+
+// Log-linear latency histogram: exact below 8 us, then 8 buckets per power
+// of two (12.5 % resolution) up to 2^24 us (~16.8 s); slower samples land in
+// the last bucket but still count towards max.  One writer; readers take
+// seqcount snapshots.
+
+#define LATENCY_SUB_BITS    3
+#define LATENCY_BUCKETS     176
+
+typedef struct {
+    seqcount_t  seq;
+    uint32_t    reset_req;      // bumped by latency_hist_reset()
+    uint32_t    reset_done;     // writer's acknowledgement of reset_req
+    uint64_t    count;
+    uint64_t    sum_us;
+    uint32_t    max_us;
+    uint32_t    buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+typedef struct {
+    uint64_t    count;
+    uint32_t    mean_us;
+    uint32_t    p50_us;         // percentiles are bucket upper bounds
+    uint32_t    p99_us;
+    uint32_t    p999_us;
+    uint32_t    max_us;
+} latency_summary_t;
+
+// Add a sample. Writer only.
+void latency_hist_record(latency_hist_t *h, uint32_t us);
+
+// Clear the histogram. Safe from any task: the writer applies it at its
+// next sample, and summaries read as empty until then.
+void latency_hist_reset(latency_hist_t *h);
+
+// Percentiles of a consistent snapshot.
+void latency_hist_summary(const latency_hist_t *h, latency_summary_t *out);
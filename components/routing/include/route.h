@@ -1,10 +1,23 @@
 #pragma once
 
 #include "port.h"
+#include "latency_hist.h"
+#include "elastic_buf.h"
 #include "esp_err.h"
 
 #define ROUTE_MAX_COUNT     16
 #define ROUTE_MAX_DEST      4   // Max destinations per route
+#define ROUTE_COALESCE_MAX_BYTES    2048
+#define ROUTE_COALESCE_MAX_US       255000  // 255 ms, like an FTDI latency timer
+#define ROUTE_MERGE_MAX_SRC         4       // sources of one merge route
+#define ROUTE_MERGE_IDLE_DEFAULT_US 5000    // idle gap ending a frame (3.5 chars at 9600 baud is ~4 ms)
+#define ROUTE_MERGE_IDLE_MAX_US     1000000
+#define ROUTE_MERGE_TURN_MAX_US     100000  // a source mid-frame yields after this if others wait
+#define ROUTE_FRAME_MAX             512     // longest frame forwarded in one write
+#define ROUTE_FRAME_DELIM_MAX       4
+#define ROUTE_FRAME_GAP_DEFAULT     35      // tenths of a character time, Modbus RTU's 3.5
+#define ROUTE_FRAME_GAP_MAX         1000
+#define ROUTE_FRAME_STALE_US        100000  // an unfinished frame is flushed after this
 
 typedef enum {
     ROUTE_TYPE_BRIDGE = 0,  // Bidirectional 1:1
@@ -12,6 +25,32 @@ typedef enum {
     ROUTE_TYPE_MERGE,       // Unidirectional N:1 (all sources -> single destination)
 } route_type_t;
 
+typedef enum {
+    ROUTE_FLOW_DROP = 0,    // Never hold the source; a lagging destination loses data
+    ROUTE_FLOW_LOSSLESS,    // Credit-based: a slow destination throttles the source port
+} route_flow_t;
+
+// Where a merge route may switch from one source to the next
+typedef enum {
+    ROUTE_ARB_BYTE = 0,     // Between any two chunks
+    ROUTE_ARB_DELIMITER,    // After a delimiter byte (e.g. '\n')
+    ROUTE_ARB_IDLE_GAP,     // After the source has been silent for arb_idle_us
+} route_arbitration_t;
+
+// What a drop-mode route does when a destination's elastic buffer is full
+typedef enum {
+    ROUTE_OVERFLOW_DROP_NEW = 0,    // Keep the buffered bytes, discard the new ones
+    ROUTE_OVERFLOW_DROP_OLD,        // Discard the oldest buffered bytes to make room
+} route_overflow_t;
+
+// How a bridge or clone route cuts the byte stream into frames
+typedef enum {
+    ROUTE_FRAME_NONE = 0,   // Forward bytes as they come
+    ROUTE_FRAME_DELIMITER,  // A frame ends with frame_delim (e.g. "\r\n")
+    ROUTE_FRAME_FIXED,      // Every frame is frame_len bytes
+    ROUTE_FRAME_IDLE,       // A frame ends when the source is silent for frame_gap
+} route_framing_t;
+
 typedef struct {
     uint8_t from_signal;    // Source signal bit (SIGNAL_DTR, etc.)
     uint8_t to_signal;      // Destination signal bit
@@ -26,18 +65,99 @@ typedef struct {
     uint8_t             dst_count;
     signal_mapping_t    signal_map[8];
     uint8_t             signal_map_count;
+    route_flow_t        flow;
+    uint16_t            coalesce_bytes;     // flush once this much is pending (0 = no coalescing)
+    uint32_t            coalesce_us;        // ... or this long after the first pending byte
+
+    // ROUTE_TYPE_MERGE: the sources are src_port_id followed by merge_src_ids,
+    // and dst_port_ids[0] is the single destination.
+    uint8_t             merge_src_ids[ROUTE_MERGE_MAX_SRC - 1];
+    uint8_t             merge_src_count;
+    route_arbitration_t arbitration;
+    uint8_t             arb_delimiter;      // ROUTE_ARB_DELIMITER
+    uint32_t            arb_idle_us;        // ROUTE_ARB_IDLE_GAP (0 = default)
+    uint8_t             merge_weights[ROUTE_MERGE_MAX_SRC];  // frames per turn (0 = 1)
+
+    // Framing (not for merge routes): each frame goes to a destination in
+    // a single write.  Takes precedence over coalescing.
+    route_framing_t     framing;
+    uint8_t             frame_delim[ROUTE_FRAME_DELIM_MAX];
+    uint8_t             frame_delim_len;
+    uint16_t            frame_len;          // ROUTE_FRAME_FIXED
+    uint16_t            frame_gap;          // ROUTE_FRAME_IDLE, tenths of a character time (0 = default)
+
+    // Elastic buffering (not for merge or framed routes): each destination
+    // gets up to elastic_bytes of PSRAM, drained at the line rate if it is
+    // a UART.  A lossless route holds its source back once a buffer is
+    // full; a drop route applies elastic_overflow.
+    uint32_t            elastic_bytes;      // 0 = unbuffered
+    route_overflow_t    elastic_overflow;
 
     // Runtime state (not persisted)
     TaskHandle_t        task_handles[2];    // Up to 2 tasks (bridge needs 2 directions)
     uint8_t             task_count;
-    volatile uint32_t   bytes_fwd_src_to_dst;
-    volatile uint32_t   bytes_fwd_dst_to_src;
 } route_t;
 
+// Monotonic counters for one direction of a route, from route_create() on.
+// Never reset: consumers take snapshots with route_get_stats() and diff them.
+typedef struct {
+    uint64_t bytes;         // read from the source and forwarded
+    uint64_t chunks;        // reads from the fan-out ring
+    uint64_t writes;        // destination writes issued
+    uint64_t short_writes;  // ... that accepted less than offered
+    uint64_t lost;          // bytes dropped: fan-out overrun or refused by a destination
+    uint64_t overruns;      // times the fan-out ring lapped this route
+    uint64_t stalls;        // times this route held its source back (lossless)
+    uint64_t frames;        // frames forwarded (framed routes)
+    uint64_t partial_frames;    // ... cut at ROUTE_FRAME_MAX or flushed after ROUTE_FRAME_STALE_US
+} route_dir_stats_t;
+
+typedef struct {
+    route_dir_stats_t src_to_dst;
+    route_dir_stats_t dst_to_src;
+} route_stats_t;
+
+// Monotonic per-source counters of a merge route.
+typedef struct {
+    uint64_t bytes;         // forwarded to the destination
+    uint64_t frames;        // frames completed (chunks in ROUTE_ARB_BYTE mode)
+    uint64_t lost;          // fan-out overrun or refused by the destination
+    uint64_t forced;        // turns cut mid-frame after ROUTE_MERGE_TURN_MAX_US
+} route_merge_stats_t;
+
+// Immutable snapshot of every created or running route, republished with a
+// new version on each change.  Readers take it with route_table_acquire(),
+// without locking, and must hand it back with route_table_release(); the
+// engine does not reuse its memory until then.
+typedef struct {
+    uint32_t    version;
+    int         count;
+    route_t     routes[ROUTE_MAX_COUNT];
+} route_table_t;
+
+typedef enum {
+    ROUTE_AFFINITY_NONE = 0,    // Data-plane tasks float between cores
+    ROUTE_AFFINITY_AUTO,        // Pin next to the driver tasks of the ports involved
+} route_affinity_t;
+
+// Data-plane resource usage
+typedef struct {
+    bool        dispatcher;     // true if routes run in shared dispatcher task(s)
+    uint32_t    tasks;          // data-plane tasks currently alive
+    uint32_t    stack_bytes;    // stack reserved by those tasks
+    uint32_t    wakeups;        // data-plane task wakeups since boot (diff for a rate)
+    route_affinity_t affinity;
+    int8_t      cpu_load[portNUM_PROCESSORS];   // % busy per core, -1 if run-time stats are off
+    uint32_t    notify_per_s;       // data-plane task notifications per second
+    uint32_t    cross_core_per_s;   // ... of which woke a task not pinned to the notifying core
+} route_engine_stats_t;
+
 // Initialize the routing engine
 esp_err_t route_engine_init(void);
 
 // Create a route (does not start it). Returns assigned route ID via route_id_out.
+// ESP_ERR_NOT_FOUND if a port is not registered, ESP_ERR_INVALID_ARG if a
+// merge lists a source twice or reads its own destination.
 esp_err_t route_create(const route_t *config, uint8_t *route_id_out);
 
 // Destroy a route (stops it first if running)
@@ -49,14 +169,50 @@ esp_err_t route_start(uint8_t route_id);
 // Stop data forwarding for a route
 esp_err_t route_stop(uint8_t route_id);
 
+// Change the destinations of a route.  A running clone or merge route
+// switches over without restarting its tasks: bytes already queued keep
+// flowing to the destinations that stay, and new ones join at the next
+// unsent byte.  A running bridge is restarted.
+esp_err_t route_set_destinations(uint8_t route_id, const uint8_t *dst_port_ids, uint8_t dst_count);
+
+// Current route table. Hold it briefly: publishing waits for old snapshots.
+const route_table_t *route_table_acquire(void);
+void route_table_release(const route_table_t *table);
+
+// Version of the current route table, to detect changes cheaply.
+uint32_t route_table_version(void);
+
 // Get all routes. Copies up to max_count routes into the array. Returns actual count.
 int route_get_all(route_t *routes, int max_count);
 
-// Get a single route by ID. Returns NULL if not found.
-route_t *route_get(uint8_t route_id);
+// Copy a single route by ID.
+esp_err_t route_get(uint8_t route_id, route_t *out);
 
 // Get count of active routes
 int route_active_count(void);
 
-// Reset byte counters for monitoring
-void route_reset_counters(uint8_t route_id);
+// Consistent snapshot of a route's counters.
+esp_err_t route_get_stats(uint8_t route_id, route_stats_t *out);
+
+// Forwarding latency per direction: from a chunk's arrival in the source
+// port's rx_ring to the end of its write to the destination(s).
+esp_err_t route_get_latency(uint8_t route_id, latency_summary_t *src_to_dst,
+                            latency_summary_t *dst_to_src);
+esp_err_t route_reset_latency(uint8_t route_id);
+
+// Per-source counters of a merge route, in source order. Returns the number
+// of sources copied into out[ROUTE_MERGE_MAX_SRC] via count.
+esp_err_t route_get_merge_stats(uint8_t route_id, route_merge_stats_t *out, int *count);
+
+// Elastic buffers of a route: one per destination in order, then for a
+// bridge the reverse direction's.  out has room for ROUTE_MAX_DEST + 1;
+// count is 0 if the route is unbuffered.
+esp_err_t route_get_elastic_stats(uint8_t route_id, elastic_stats_t *out, int *count);
+
+// Get data-plane task, wakeup and per-core statistics. Rates cover the
+// window since the previous call (at least 500 ms).
+void route_engine_get_stats(route_engine_stats_t *out);
+
+// Set the core placement policy. Applies to routes started afterwards.
+esp_err_t route_set_affinity(route_affinity_t policy);
+route_affinity_t route_get_affinity(void);
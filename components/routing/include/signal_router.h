@@ -1,9 +1,34 @@
 #pragma once
 
 #include "route.h"
+#include "latency_hist.h"
 
-// Start the signal routing task (polls signal states and applies mappings)
+// Monotonic counters since boot.
+typedef struct {
+    uint32_t applied;       // compiled mappings applied
+    uint32_t skipped;       // ... skipped because their input was unchanged
+    uint32_t compiled;      // times the route table was compiled
+} signal_router_stats_t;
+
+// Start the signal routing task. It sleeps until a port reports a signal
+// change (port_signals_changed()) or the route table changes, then applies
+// the mappings of the routes touching the changed ports.
 esp_err_t signal_router_init(void);
 
 // Stop the signal routing task
 void signal_router_stop(void);
+
+// Re-apply every mapping, e.g. after the route table changed.
+void signal_router_kick(void);
+
+// Time from a reported signal change to its mappings being applied.
+void signal_router_get_latency(latency_summary_t *out);
+void signal_router_reset_latency(void);
+
+void signal_router_get_stats(signal_router_stats_t *out);
+
+// Called from the router task after each pass with the ports whose signals
+// may have changed: those that reported a change and the destinations the
+// mappings drove.  It must not block.
+typedef void (*signal_listener_t)(uint32_t port_mask);
+void signal_router_set_listener(signal_listener_t cb);
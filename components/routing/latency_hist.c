@@ -0,0 +1,79 @@
+#include "latency_hist.h"
+#include <string.h>
+
+#define SUB     (1u << LATENCY_SUB_BITS)
+
+static int bucket_of(uint32_t us)
+{
+    if (us < SUB) return us;
+    int msb   = 31 - __builtin_clz(us);
+    int shift = msb - LATENCY_SUB_BITS;
+    int idx   = (shift + 1) * SUB + ((us >> shift) & (SUB - 1));
+    return idx < LATENCY_BUCKETS ? idx : LATENCY_BUCKETS - 1;
+}
+
+// Largest value that falls into bucket idx.
+static uint32_t bucket_upper(int idx)
+{
+    if (idx < (int)SUB) return idx;
+    int shift = idx / SUB - 1;
+    uint32_t mant = SUB + idx % SUB;
+    return ((mant + 1) << shift) - 1;
+}
+
+void latency_hist_record(latency_hist_t *h, uint32_t us)
+{
+    uint32_t req = __atomic_load_n(&h->reset_req, __ATOMIC_ACQUIRE);
+
+    seqcount_write_begin(&h->seq);
+    if (req != h->reset_done) {
+        h->count  = 0;
+        h->sum_us = 0;
+        h->max_us = 0;
+        memset(h->buckets, 0, sizeof(h->buckets));
+    }
+    h->buckets[bucket_of(us)]++;
+    h->count++;
+    h->sum_us += us;
+    if (us > h->max_us) h->max_us = us;
+    seqcount_write_end(&h->seq);
+
+    if (req != h->reset_done) __atomic_store_n(&h->reset_done, req, __ATOMIC_RELEASE);
+}
+
+void latency_hist_reset(latency_hist_t *h)
+{
+    __atomic_add_fetch(&h->reset_req, 1, __ATOMIC_RELEASE);
+}
+
+void latency_hist_summary(const latency_hist_t *h, latency_summary_t *out)
+{
+    latency_hist_t snap;
+    seqcount_read(&h->seq, &snap, h, sizeof(snap));
+
+    memset(out, 0, sizeof(*out));
+    if (__atomic_load_n(&h->reset_req, __ATOMIC_ACQUIRE) != snap.reset_done || snap.count == 0) {
+        return;
+    }
+
+    out->count   = snap.count;
+    out->mean_us = snap.sum_us / snap.count;
+    out->max_us  = snap.max_us;
+
+    // Rank of each percentile, rounded up so p999 of few samples is the max.
+    uint64_t want[3] = {
+        (snap.count * 500 + 999) / 1000,
+        (snap.count * 990 + 999) / 1000,
+        (snap.count * 999 + 999) / 1000,
+    };
+    uint32_t *dst[3] = { &out->p50_us, &out->p99_us, &out->p999_us };
+    uint64_t seen = 0;
+    int p = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && p < 3; i++) {
+        seen += snap.buckets[i];
+        while (p < 3 && seen >= want[p]) {
+            uint32_t v = bucket_upper(i);
+            *dst[p++] = v < snap.max_us ? v : snap.max_us;
+        }
+    }
+}
@@ -1,119 +1,409 @@
 #include "route.h"
+#include "signal_router.h"
 #include "port_registry.h"
+#include "buf_pool.h"
+#include "dp_notify.h"
+#include "port_tap.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
-#include "freertos/queue.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "route";
 
-#define FORWARD_BUF_SIZE    256
+#define FORWARD_BUF_SIZE    512     // one HS USB packet, largest drop-mode write
 #define FORWARD_STACK_SIZE  4096
+#define DISPATCH_STACK_SIZE 4096
+#define FLOW_RETRY_TICKS    1       // lossless retry while a destination is full
+#define ELASTIC_MAX_BYTES   (CONFIG_VUART_ROUTE_ELASTIC_MAX_KB * 1024)
+
+// Data-plane accounting for route_engine_get_stats().
+static volatile uint32_t dp_task_count;
+static volatile uint32_t dp_wakeups;
+
+#define DP_COUNT(var, delta)  __atomic_add_fetch(&(var), (delta), __ATOMIC_RELAXED)
 
 // ---------------------------------------------------------------------------
-// Private per-route runtime state (not exposed in route.h)
+// Core placement
+//
+// ROUTE_AFFINITY_AUTO pins a pump next to the driver task of its source port
+// and a forwarder next to that of its destination (TinyUSB for CDC, lwIP for
+// TCP).  USB-only and network-only routes then stay on one core, and a
+// USB <-> network bridge crosses cores once per direction.  Ports without a
+// home core (UART) defer to the other end of the route.
 // ---------------------------------------------------------------------------
 
+#ifdef CONFIG_VUART_ROUTE_AFFINITY_AUTO
+static route_affinity_t affinity_policy = ROUTE_AFFINITY_AUTO;
+#else
+static route_affinity_t affinity_policy = ROUTE_AFFINITY_NONE;
+#endif
+
+static BaseType_t plan_core(port_t *preferred, port_t *fallback)
+{
+    if (affinity_policy != ROUTE_AFFINITY_AUTO) return tskNO_AFFINITY;
+    if (preferred && preferred->home_core >= 0) return preferred->home_core;
+    if (fallback && fallback->home_core >= 0) return fallback->home_core;
+    return tskNO_AFFINITY;
+}
+
+// ---------------------------------------------------------------------------
+// Route table (read-copy-update)
+//
+// The control path edits routes[] under route_mutex, then publishes a copy
+// of it by swapping route_table_cur.  Readers pin the current copy with a
+// reference count and never block: if the pointer moved while they were
+// pinning, they unpin and retry.  A retired copy is only rewritten once
+// nobody holds it, so a snapshot stays intact for as long as it is held.
+// ---------------------------------------------------------------------------
+
+#define ROUTE_TABLE_POOL    3   // current, one still being read, one to fill
+
 typedef struct {
-    QueueHandle_t       fwd_src_queue;
-    QueueHandle_t       rev_src_queue;
-    SemaphoreHandle_t   done_sem;       // counting semaphore for task join
-} route_runtime_t;
+    route_table_t   t;          // first member: a route_table_t * is a table_slot_t *
+    uint32_t        refs;
+} table_slot_t;
 
-static route_runtime_t route_rt[ROUTE_MAX_COUNT];
+static table_slot_t  route_tables[ROUTE_TABLE_POOL];
+static table_slot_t *route_table_cur = &route_tables[0];
+static uint32_t      route_table_gen;
+
+const route_table_t *route_table_acquire(void)
+{
+    for (;;) {
+        table_slot_t *s = __atomic_load_n(&route_table_cur, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&s->refs, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&route_table_cur, __ATOMIC_SEQ_CST) == s) return &s->t;
+        __atomic_sub_fetch(&s->refs, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void route_table_release(const route_table_t *table)
+{
+    __atomic_sub_fetch(&((table_slot_t *)table)->refs, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t route_table_version(void)
+{
+    return __atomic_load_n(&route_table_gen, __ATOMIC_ACQUIRE);
+}
+
+static const route_t *route_table_find(const route_table_t *t, uint8_t route_id)
+{
+    for (int i = 0; i < t->count; i++) {
+        if (t->routes[i].id == route_id) return &t->routes[i];
+    }
+    return NULL;
+}
 
 // ---------------------------------------------------------------------------
 // Fan-out source reader
 //
-// FreeRTOS stream buffers support exactly ONE blocked reader.  When multiple
-// routes share the same source port each forward_task cannot call
-// xStreamBufferReceive directly -- only one would block successfully and the
-// second would assert (stream_buffer.c:976).
+// A port's rx_ring is single-consumer.  When multiple routes share the same
+// source port each forward_task cannot read it directly.
+//
+// Solution: one pump task per source port reads from port->rx_ring (the sole
+// reader) straight into a shared broadcast ring.  Every subscribing
+// forward_task owns a cursor into that ring and reads at its own pace, so a
+// read is written once no matter how many routes consume it.
+//
+// The pump never waits for subscribers.  It publishes in two steps: `claim`
+// is advanced before bytes are written into the ring and `head` after, so a
+// subscriber can tell whether the span it copied was overwritten underneath
+// it.  A subscriber that falls more than SRC_RING_SIZE bytes behind is
+// lapped: it resynchronises to the newest byte and the skipped span is
+// accounted as lost instead of being silently dropped chunk by chunk.
 //
-// Solution: one pump task per source port reads from port->rx_buf (the sole
-// reader) and fans the data out to per-route subscriber queues.  Each
-// forward_task reads from its own private queue instead of from the port.
+// Each published chunk carries the time its oldest byte reached the source
+// port's rx_ring, in a small broadcast ring of stamps next to the data, so
+// forwarders can measure ingress-to-egress latency.  A subscriber more than
+// SRC_STAMPS chunks behind skips the sample rather than guess.
+//
+// Lossless (ROUTE_FLOW_LOSSLESS) subscribers are the exception: the pump only
+// reads as much as the slowest of them has released (its credit).  With no
+// credit left the pump stops reading, port->rx_ring fills and the port driver
+// throttles its peer (USB NAK, UART RTS, TCP window).
 // ---------------------------------------------------------------------------
 
-#define SRC_READER_MAX   8   // max distinct source ports active simultaneously
-#define SRC_SUB_MAX      8   // max simultaneous routes sharing one source port
-#define SRC_SUB_Q_DEPTH  8   // depth of each per-route subscriber queue
-// TODO: consider static chunk pool if heap pressure appears under load (8MB PSRAM available)
+#define SRC_READER_MAX   8      // max distinct source ports active simultaneously
+#define SRC_SUB_MAX      8      // max simultaneous routes sharing one source port
+#define SRC_RING_SIZE    BUF_POOL_LARGE_SIZE    // per-source broadcast ring, power of two
+#define SRC_RING_MASK    (SRC_RING_SIZE - 1)
+#define SRC_STAMPS       64     // chunk ingress stamps kept per source, power of two
+#define SRC_STAMP_MASK   (SRC_STAMPS - 1)
 
-// A single heap-allocated chunk carried through subscriber queues.
-// route_stop() drains and frees any residual chunks after tasks exit.
-typedef struct {
-    uint8_t *data;
-    uint16_t len;
-} fanout_chunk_t;
+// A lossless route must be able to hold a full coalescing threshold.
+_Static_assert(ROUTE_COALESCE_MAX_BYTES <= SRC_RING_SIZE / 2,
+               "ROUTE_COALESCE_MAX_BYTES exceeds half the fan-out ring");
+_Static_assert(ROUTE_FRAME_MAX <= SRC_RING_SIZE / 2 && ROUTE_FRAME_MAX <= FORWARD_BUF_SIZE,
+               "ROUTE_FRAME_MAX exceeds the fan-out ring or forward buffer");
 
 typedef struct {
-    QueueHandle_t queue;
-    bool          active;
+    bool              active;
+    uint32_t          tail;         // next sequence number to read (owned by reader)
+    TaskHandle_t      waiter;       // reader task, notified when head advances
+    bool              lossless;     // holds the pump back instead of being lapped
+    uint32_t          stalls;       // counted by the pump, folded into route stats by the reader
+    uint32_t          stamp_idx;    // stamp covering tail (owned by reader)
 } src_sub_t;
 
 typedef struct {
     port_t           *src;
     volatile bool     running;
     int               ref_count;
+    int               lossless_count;
+    bool              stalled;      // pump is out of credit
+    bool              notifying;    // pump is inside src_notify()
+    uint8_t          *ring;
+    uint32_t          claim;        // end of the span the pump is writing
+    uint32_t          head;         // end of the span readers may consume
+    port_rx_stamp_t   stamps[SRC_STAMPS];   // ring offset at which a chunk starts, ingress time
+    uint32_t          stamp_claim;  // stamps being written, like claim
+    uint32_t          stamp_count;  // stamps published
     src_sub_t         subs[SRC_SUB_MAX];
-    SemaphoreHandle_t mutex;
+    SemaphoreHandle_t mutex;        // subscribe/unsubscribe only
     TaskHandle_t      task;
     SemaphoreHandle_t pump_done;    // signaled by pump task before exit
+    int               dispatcher;   // owning dispatcher (dispatcher mode)
+    bool              attached;     // pumped by its dispatcher (dispatcher mode)
 } src_reader_t;
 
 static src_reader_t       src_readers[SRC_READER_MAX];
 static SemaphoreHandle_t  src_reader_mutex;
 
-// Pump task: sole reader of port->rx_buf, fans data to all subscriber queues.
+#define SRC_PUMP_STALLED    (-1)
+
+// Ring space not yet released by the slowest lossless subscriber.  Lock-free:
+// a slot only turns active once its cursor is set, and one going away at
+// worst holds back this pass.
+static uint32_t src_credit(src_reader_t *sr, src_sub_t **slowest)
+{
+    uint32_t head = sr->head;
+    uint32_t used = 0;
+
+    *slowest = NULL;
+    for (int i = 0; i < SRC_SUB_MAX; i++) {
+        src_sub_t *sub = &sr->subs[i];
+        if (!__atomic_load_n(&sub->active, __ATOMIC_ACQUIRE) || !sub->lossless) continue;
+        uint32_t u = head - __atomic_load_n(&sub->tail, __ATOMIC_SEQ_CST);
+        if (u >= used) {
+            used = u;
+            *slowest = sub;
+        }
+    }
+    return SRC_RING_SIZE - used;
+}
+
+// Wake every subscriber waiting on the ring.  Lock-free, like src_credit();
+// src_sub_quiesce() keeps a waiter from being notified once it has gone.
+static void src_notify(src_reader_t *sr)
+{
+    __atomic_store_n(&sr->notifying, true, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < SRC_SUB_MAX; i++) {
+        src_sub_t *sub = &sr->subs[i];
+        if (!__atomic_load_n(&sub->active, __ATOMIC_ACQUIRE)) continue;
+        TaskHandle_t waiter = __atomic_load_n(&sub->waiter, __ATOMIC_SEQ_CST);
+        if (waiter) dp_notify(waiter);
+    }
+    __atomic_store_n(&sr->notifying, false, __ATOMIC_RELEASE);
+}
+
+#ifndef CONFIG_VUART_ROUTE_DISPATCHER
+// Stop notifying a subscriber's reader task, which is about to exit.
+static void src_sub_quiesce(src_reader_t *sr, src_sub_t *sub)
+{
+    __atomic_store_n(&sub->waiter, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&sr->notifying, __ATOMIC_SEQ_CST)) portYIELD();
+}
+#endif
+
+// One pump pass: read whatever the source has into the ring and publish it.
+// Returns the number of bytes published, or SRC_PUMP_STALLED when a lossless
+// subscriber has not released enough of the ring.
+static int src_pump_step(src_reader_t *sr, TickType_t timeout)
+{
+    // Read straight into the ring, never across the wrap point, at most one
+    // natural packet of the source port at a time.
+    uint32_t head = sr->head;
+    uint32_t off  = head & SRC_RING_MASK;
+    size_t   room = SRC_RING_SIZE - off;
+    size_t   pkt  = sr->src->packet_size ? sr->src->packet_size : PORT_PACKET_DEFAULT;
+    if (room > pkt) room = pkt;
+
+    if (sr->lossless_count) {
+        // Publish the stall before sampling the tails, so a subscriber that
+        // releases space concurrently is sure to see it and wake us.
+        bool was_stalled = sr->stalled;
+        __atomic_store_n(&sr->stalled, true, __ATOMIC_SEQ_CST);
+        src_sub_t *slowest;
+        uint32_t credit = src_credit(sr, &slowest);
+        if (credit == 0) {
+            if (!was_stalled && slowest) __atomic_add_fetch(&slowest->stalls, 1, __ATOMIC_RELAXED);
+            return SRC_PUMP_STALLED;
+        }
+        __atomic_store_n(&sr->stalled, false, __ATOMIC_SEQ_CST);
+        if (room > credit) room = credit;
+    }
+
+    __atomic_store_n(&sr->claim, head + room, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    uint32_t pos = port_rx_position(sr->src);
+    int n = sr->src->ops.read(sr->src, &sr->ring[off], room, timeout);
+    if (n <= 0) {
+        __atomic_store_n(&sr->claim, head, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    uint32_t idx = sr->stamp_count;
+    uint32_t us  = port_rx_ingress(sr->src, pos);
+    __atomic_store_n(&sr->stamp_claim, idx + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    sr->stamps[idx & SRC_STAMP_MASK] = (port_rx_stamp_t){
+        .seq = head,
+        .us  = us,
+    };
+    __atomic_store_n(&sr->stamp_count, idx + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&sr->claim, head + n, __ATOMIC_RELEASE);
+    __atomic_store_n(&sr->head,  head + n, __ATOMIC_RELEASE);
+
+    src_notify(sr);
+
+    if (port_tap_active(sr->src, PORT_TAP_RX)) {
+        port_iov_t iov = { &sr->ring[off], n };
+        port_tap_feed(sr->src, PORT_TAP_RX, us, &iov, 1, n);
+    }
+    return n;
+}
+
+#ifndef CONFIG_VUART_ROUTE_DISPATCHER
+// Pump task: sole reader of port->rx_ring, publishes into the broadcast ring.
 static void src_pump_task(void *arg)
 {
     src_reader_t *sr = (src_reader_t *)arg;
-    uint8_t buf[FORWARD_BUF_SIZE];
 
     ESP_LOGI(TAG, "Pump %s started", sr->src->name);
 
     while (sr->running) {
-        int n = sr->src->ops.read(sr->src, buf, sizeof(buf), pdMS_TO_TICKS(50));
-        if (n <= 0) continue;
-
-        xSemaphoreTake(sr->mutex, portMAX_DELAY);
-        for (int i = 0; i < SRC_SUB_MAX; i++) {
-            if (!sr->subs[i].active) continue;
-            fanout_chunk_t chunk = {
-                .data = malloc(n),
-                .len  = (uint16_t)n,
-            };
-            if (!chunk.data) continue;
-            memcpy(chunk.data, buf, n);
-            if (xQueueSend(sr->subs[i].queue, &chunk, 0) != pdTRUE) {
-                free(chunk.data); // subscriber queue full -- drop
-                ESP_LOGW(TAG, "Pump %s: sub %d queue full, dropped %d bytes",
-                         sr->src->name, i, n);
-            }
+        if (src_pump_step(sr, pdMS_TO_TICKS(50)) == SRC_PUMP_STALLED) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
         }
-        xSemaphoreGive(sr->mutex);
+        DP_COUNT(dp_wakeups, 1);
     }
 
     ESP_LOGI(TAG, "Pump %s stopped", sr->src->name);
+    DP_COUNT(dp_task_count, -1);
     xSemaphoreGive(sr->pump_done);
     vTaskDelete(NULL);
 }
+#endif
 
-// Subscribe to a source port.  Creates a pump task the first time.
-// Returns the subscriber queue to read from, or NULL on error.
-static QueueHandle_t src_subscribe(port_t *src)
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+static bool dispatch_attach_reader(src_reader_t *sr);
+#endif
+static void dispatch_kick(void);
+
+// Start pumping a source: a dedicated task, or its dispatcher.
+static bool src_pump_start(src_reader_t *sr)
 {
-    // Pre-allocate queue outside locks to avoid priority inversion (NB-7).
-    QueueHandle_t q = xQueueCreate(SRC_SUB_Q_DEPTH, sizeof(fanout_chunk_t));
-    if (!q) {
-        ESP_LOGE(TAG, "Failed to create subscriber queue");
-        return NULL;
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+    return dispatch_attach_reader(sr);
+#else
+    char name[PORT_NAME_MAX + 6]; // "pump_" + name + NUL
+    snprintf(name, sizeof(name), "pump_%s", sr->src->name);
+    if (xTaskCreatePinnedToCore(src_pump_task, name, FORWARD_STACK_SIZE, sr, 5, &sr->task,
+                                plan_core(sr->src, NULL)) != pdPASS) {
+        return false;
     }
+    DP_COUNT(dp_task_count, 1);
+    return true;
+#endif
+}
+
+// Copy up to len unread bytes for a subscriber out of the ring.
+// Returns the number of bytes copied; 0 if nothing is pending.  When the
+// subscriber has been lapped its cursor jumps to the newest byte and the
+// skipped span is added to *lost.
+static size_t src_ring_read(src_reader_t *sr, src_sub_t *sub, uint8_t *buf,
+                            size_t len, uint32_t *lost)
+{
+    uint32_t tail  = sub->tail;
+    uint32_t head  = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE);
+    uint32_t avail = head - tail;
+    if (avail == 0) return 0;
+
+    if (avail <= SRC_RING_SIZE) {
+        size_t n   = avail < len ? avail : len;
+        size_t off = tail & SRC_RING_MASK;
+        size_t first = SRC_RING_SIZE - off;
+        if (first > n) first = n;
+        memcpy(buf, &sr->ring[off], first);
+        memcpy(buf + first, sr->ring, n - first);
+
+        // Valid only if the pump has not started overwriting what we copied.
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t claim = __atomic_load_n(&sr->claim, __ATOMIC_ACQUIRE);
+        if (claim - tail <= SRC_RING_SIZE) {
+            sub->tail = tail + n;
+            return n;
+        }
+    }
+
+    // Lapped: resynchronise to the newest published byte.
+    head = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE);
+    *lost += head - tail;
+    sub->tail = head;
+    ESP_LOGW(TAG, "Pump %s: subscriber lapped, skipped %lu bytes",
+             sr->src->name, (unsigned long)(head - tail));
+    return 0;
+}
 
+// Describe len unread bytes of the ring from sequence seq, in at most two
+// segments (up to the wrap point, then from the start).
+static int src_ring_iov(const src_reader_t *sr, uint32_t seq, size_t len, port_iov_t iov[2])
+{
+    size_t off   = seq & SRC_RING_MASK;
+    size_t first = SRC_RING_SIZE - off;
+    if (len <= first) {
+        iov[0] = (port_iov_t){ &sr->ring[off], len };
+        return 1;
+    }
+    iov[0] = (port_iov_t){ &sr->ring[off], first };
+    iov[1] = (port_iov_t){ sr->ring, len - first };
+    return 2;
+}
+
+// Ingress time of the byte at fan-out sequence seq, which must not precede
+// the subscriber's previous lookup.  Returns false if its stamp is gone.
+static bool src_ingress(src_reader_t *sr, src_sub_t *sub, uint32_t seq, uint32_t *us)
+{
+    uint32_t count = __atomic_load_n(&sr->stamp_count, __ATOMIC_ACQUIRE);
+    uint32_t idx   = sub->stamp_idx;
+    if (idx == count) return false;
+    if (count - idx > SRC_STAMPS) idx = count - SRC_STAMPS;
+
+    while (idx + 1 != count &&
+           (int32_t)(sr->stamps[(idx + 1) & SRC_STAMP_MASK].seq - seq) <= 0) {
+        idx++;
+    }
+    port_rx_stamp_t s = sr->stamps[idx & SRC_STAMP_MASK];
+    sub->stamp_idx = idx;
+
+    // Valid only if the pump has not started overwriting the stamp.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&sr->stamp_claim, __ATOMIC_ACQUIRE) - idx > SRC_STAMPS) return false;
+    if ((int32_t)(s.seq - seq) > 0) return false;
+    *us = s.us;
+    return true;
+}
+
+// Subscribe to a source port.  Creates a pump task the first time.
+// Returns the subscriber slot to read from, or NULL on error.
+static src_sub_t *src_subscribe(port_t *src, bool lossless, src_reader_t **reader_out)
+{
     xSemaphoreTake(src_reader_mutex, portMAX_DELAY);
 
     // Find existing reader for this source, or allocate a new slot.
@@ -127,186 +417,1334 @@ static QueueHandle_t src_subscribe(port_t *src)
         }
         if (!sr) {
             xSemaphoreGive(src_reader_mutex);
-            vQueueDelete(q);
             ESP_LOGE(TAG, "No free src_reader slots");
             return NULL;
         }
         memset(sr, 0, sizeof(*sr));
         sr->src     = src;
         sr->running = true;
+        sr->ring    = buf_pool_take(SRC_RING_SIZE);
+        if (!sr->ring) {
+            sr->src = NULL;
+            xSemaphoreGive(src_reader_mutex);
+            ESP_LOGE(TAG, "Failed to allocate fan-out ring for %s", src->name);
+            return NULL;
+        }
         sr->mutex   = xSemaphoreCreateMutex();
         if (!sr->mutex) {
-            sr->src = NULL;
+            buf_pool_give(sr->ring);
+            memset(sr, 0, sizeof(*sr));
             xSemaphoreGive(src_reader_mutex);
-            vQueueDelete(q);
             ESP_LOGE(TAG, "Failed to create src_reader mutex");
             return NULL;
         }
         sr->pump_done = xSemaphoreCreateCounting(1, 0);
         if (!sr->pump_done) {
             vSemaphoreDelete(sr->mutex);
+            buf_pool_give(sr->ring);
             memset(sr, 0, sizeof(*sr));
             xSemaphoreGive(src_reader_mutex);
-            vQueueDelete(q);
             ESP_LOGE(TAG, "Failed to create pump_done semaphore");
             return NULL;
         }
-        char name[PORT_NAME_MAX + 6]; // "pump_" + name + NUL
-        snprintf(name, sizeof(name), "pump_%s", src->name);
-        BaseType_t ret = xTaskCreate(src_pump_task, name, FORWARD_STACK_SIZE, sr, 5, &sr->task);
-        if (ret != pdPASS) {
+        if (!src_pump_start(sr)) {
             vSemaphoreDelete(sr->pump_done);
             vSemaphoreDelete(sr->mutex);
+            buf_pool_give(sr->ring);
             memset(sr, 0, sizeof(*sr));
             xSemaphoreGive(src_reader_mutex);
-            vQueueDelete(q);
             ESP_LOGE(TAG, "Failed to create pump task for %s", src->name);
             return NULL;
         }
         ESP_LOGI(TAG, "Created pump for %s", src->name);
     }
 
-    // Find a free subscriber slot and assign the pre-allocated queue.
+    // Find a free subscriber slot; new subscribers only see data published
+    // from now on.  The pump reads slots without the mutex, so a slot is
+    // filled in before it is marked active.
     xSemaphoreTake(sr->mutex, portMAX_DELAY);
-    bool found = false;
+    src_sub_t *sub = NULL;
     for (int i = 0; i < SRC_SUB_MAX; i++) {
         if (!sr->subs[i].active) {
-            sr->subs[i].queue  = q;
-            sr->subs[i].active = true;
+            sub = &sr->subs[i];
+            sub->waiter    = NULL;
+            sub->stalls    = 0;
+            sub->tail      = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE);
+            sub->stamp_idx = __atomic_load_n(&sr->stamp_count, __ATOMIC_ACQUIRE);
+            sub->lossless  = lossless;
+            __atomic_store_n(&sub->active, true, __ATOMIC_RELEASE);
             sr->ref_count++;
-            found = true;
+            if (lossless) sr->lossless_count++;
             break;
         }
     }
     xSemaphoreGive(sr->mutex);
     xSemaphoreGive(src_reader_mutex);
 
-    if (!found) {
-        vQueueDelete(q);
-        ESP_LOGE(TAG, "Too many subscribers on %s", src->name);
-        return NULL;
+    if (!sub) {
+        ESP_LOGE(TAG, "Too many subscribers on %s", src->name);
+        return NULL;
+    }
+    if (reader_out) *reader_out = sr;
+    return sub;
+}
+
+// Release a subscriber slot.  The reading forward_task must have exited.
+// Stops and destroys the pump task when the last subscriber is removed.
+static void src_unsubscribe(port_t *src, src_sub_t *sub)
+{
+    if (!src || !sub) return;
+
+    xSemaphoreTake(src_reader_mutex, portMAX_DELAY);
+
+    for (int i = 0; i < SRC_READER_MAX; i++) {
+        src_reader_t *sr = &src_readers[i];
+        if (sr->src != src) continue;
+
+        xSemaphoreTake(sr->mutex, portMAX_DELAY);
+        if (sub->active) {
+            __atomic_store_n(&sub->active, false, __ATOMIC_RELEASE);
+            sub->waiter = NULL;
+            sr->ref_count--;
+            if (sub->lossless) sr->lossless_count--;
+        }
+        bool stop = (sr->ref_count == 0);
+        if (stop) sr->running = false;
+        xSemaphoreGive(sr->mutex);
+
+        if (stop) {
+            // Release global mutex while waiting for pump task to exit.
+            xSemaphoreGive(src_reader_mutex);
+            dispatch_kick();
+            if (xSemaphoreTake(sr->pump_done, pdMS_TO_TICKS(1000)) != pdTRUE) {
+                ESP_LOGW(TAG, "Pump %s did not exit in time", src->name);
+            }
+            xSemaphoreTake(src_reader_mutex, portMAX_DELAY);
+
+            // Re-check: a new subscriber may have raced in while we waited (NB-3).
+            xSemaphoreTake(sr->mutex, portMAX_DELAY);
+            if (sr->ref_count == 0) {
+                xSemaphoreGive(sr->mutex);
+                vSemaphoreDelete(sr->mutex);
+                vSemaphoreDelete(sr->pump_done);
+                buf_pool_give(sr->ring);
+                sr->src       = NULL;
+                sr->task      = NULL;
+                sr->pump_done = NULL;
+                sr->mutex     = NULL;
+                sr->ring      = NULL;
+                ESP_LOGI(TAG, "Pump for %s destroyed", src->name);
+            } else {
+                // A new subscriber arrived while pump was stopping -- restart it.
+                sr->running = true;
+                if (!src_pump_start(sr)) {
+                    ESP_LOGE(TAG, "Failed to restart pump for %s", src->name);
+                }
+                xSemaphoreGive(sr->mutex);
+                ESP_LOGW(TAG, "Pump for %s restarted (subscriber raced in)", src->name);
+            }
+        }
+        break;
+    }
+
+    xSemaphoreGive(src_reader_mutex);
+}
+
+// ---------------------------------------------------------------------------
+// Forwarding task
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    port_t            *src;
+    src_reader_t      *reader;      // fan-out ring of the source port
+    src_sub_t         *sub;         // private cursor from src_subscribe()
+    port_t            *dst[ROUTE_MAX_DEST];
+    int                dst_count;
+    volatile bool     *running;
+    seqcount_t        *stats_seq;   // this task is the only writer
+    route_dir_stats_t *stats;
+    latency_hist_t    *latency;     // ingress-to-egress, this task is the only writer
+    SemaphoreHandle_t  done_sem;    // signaled before task exit
+    bool               lossless;
+    size_t             dst_sent[ROUTE_MAX_DEST];  // lossless: accepted past sub->tail
+    uint16_t           coalesce_bytes;
+    uint32_t           coalesce_us;
+    bool               holding;     // coalescing or framing: data pending since pending_since
+    int64_t            pending_since;
+    int64_t            hold_until;  // ... and held until then at most
+    route_framing_t    framing;
+    uint8_t            frame_delim[ROUTE_FRAME_DELIM_MAX];
+    uint8_t            frame_delim_len;
+    uint16_t           frame_len;
+    uint16_t           frame_gap;   // tenths of a character time
+    uint32_t           frame_scanned;   // delimiter search resumes here, past sub->tail
+    size_t             frame_pending;   // lossless: frame some destinations still lack
+    bool               frame_partial;
+    elastic_buf_t     *elastic[ROUTE_MAX_DEST];   // per destination, all NULL if unbuffered
+    elastic_buf_t     *elastic_store;   // the route's buffers, elastic[i] is &elastic_store[i]
+    uint32_t           elastic_bytes;
+    bool               elastic_drop_old;
+    uint8_t            route_id;
+    bool               follow_dests;    // picks up route_set_destinations() while running
+    uint32_t           table_version;   // route table last checked for that
+    struct merge_state *merge;      // ROUTE_TYPE_MERGE arbiter, NULL otherwise
+} forward_ctx_t;
+
+// ---------------------------------------------------------------------------
+// Merge arbiter
+//
+// A merge route has one forwarder reading N sources, each through its own
+// fan-out subscription, and writing one destination.  The destination is
+// granted to one source at a time and only changes hands at a frame
+// boundary (per route_arbitration_t), so frames from different sources
+// never interleave.  Turns go round-robin among sources with data pending;
+// a source's weight is the number of frames it may send per turn.  A source
+// that stays mid-frame for ROUTE_MERGE_TURN_MAX_US while others wait loses
+// its turn (counted as forced).
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    port_t             *src;
+    src_reader_t       *reader;
+    src_sub_t          *sub;
+    uint8_t             weight;
+} merge_src_t;
+
+typedef struct merge_state {
+    merge_src_t          in[ROUTE_MERGE_MAX_SRC];  // in[0] is the forwarder's own src/sub
+    int                  count;
+    route_arbitration_t  mode;
+    uint8_t              delimiter;
+    uint32_t             idle_us;
+    int                  cur;           // source holding the destination
+    bool                 mid_frame;
+    uint8_t              frames_left;   // frames cur may still send this turn
+    int64_t              turn_start;
+    int64_t              last_data;     // cur last had data
+    seqcount_t          *stats_seq;     // arbiter is the only writer
+    route_merge_stats_t *stats;
+} merge_state_t;
+
+// Coalescing, like an FTDI latency timer: hold back small amounts of data
+// until coalesce_bytes have accumulated or coalesce_us have passed since the
+// first of them arrived.  Returns true while the data should be held.
+static bool forward_hold(forward_ctx_t *ctx)
+{
+    if (!ctx->coalesce_bytes) return false;
+
+    uint32_t avail = __atomic_load_n(&ctx->reader->head, __ATOMIC_ACQUIRE) - ctx->sub->tail;
+    if (avail == 0 || avail >= ctx->coalesce_bytes) {
+        ctx->holding = false;
+        return false;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (!ctx->holding) {
+        ctx->holding       = true;
+        ctx->pending_since = now;
+        ctx->hold_until    = now + ctx->coalesce_us;
+    }
+    if (now < ctx->hold_until) return true;
+
+    ctx->holding = false;
+    return false;
+}
+
+// Add one step's worth of counts, plus the stalls the pump has tallied for
+// this subscriber, to the route direction's monotonic counters.
+static void forward_account(forward_ctx_t *ctx, const route_dir_stats_t *d)
+{
+    uint32_t stalls = __atomic_exchange_n(&ctx->sub->stalls, 0, __ATOMIC_RELAXED);
+    if (ctx->merge) {
+        for (int i = 1; i < ctx->merge->count; i++) {
+            stalls += __atomic_exchange_n(&ctx->merge->in[i].sub->stalls, 0, __ATOMIC_RELAXED);
+        }
+    }
+    if (!d->chunks && !d->writes && !d->lost && !stalls) return;
+
+    route_dir_stats_t *s = ctx->stats;
+    seqcount_write_begin(ctx->stats_seq);
+    s->bytes        += d->bytes;
+    s->chunks       += d->chunks;
+    s->writes       += d->writes;
+    s->short_writes += d->short_writes;
+    s->lost         += d->lost;
+    s->overruns     += d->overruns;
+    s->stalls       += stalls;
+    s->frames       += d->frames;
+    s->partial_frames += d->partial_frames;
+    seqcount_write_end(ctx->stats_seq);
+}
+
+// Drop mode: copy out of the ring, write once to each destination and count
+// whatever a destination did not accept as lost.
+static bool forward_step_drop(forward_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    route_dir_stats_t d = {0};
+    uint32_t skipped = 0;
+    size_t n = src_ring_read(ctx->reader, ctx->sub, buf, len, &skipped);
+    if (skipped) {
+        d.lost = skipped;
+        d.overruns = 1;
+    }
+    if (n == 0) {
+        forward_account(ctx, &d);
+        return skipped > 0;
+    }
+    uint32_t ingress;
+    bool stamped = src_ingress(ctx->reader, ctx->sub, ctx->sub->tail - n, &ingress);
+
+    for (int i = 0; i < ctx->dst_count; i++) {
+        int w = 0;
+        if (ctx->dst[i] && ctx->dst[i]->state >= PORT_STATE_READY) {
+            w = port_write(ctx->dst[i], buf, n);
+            d.writes++;
+        }
+        if (w < (int)n) {
+            d.lost += n - (w > 0 ? w : 0);
+            d.short_writes++;
+        }
+    }
+    d.bytes  = n;
+    d.chunks = 1;
+    forward_account(ctx, &d);
+    if (stamped) latency_hist_record(ctx->latency, (uint32_t)esp_timer_get_time() - ingress);
+    return true;
+}
+
+// Lossless mode: write straight out of the ring and release only what every
+// destination has accepted, so a slow destination holds the cursor -- and
+// through the pump's credit, the source port -- instead of losing data.
+// Everything pending goes to a destination in one gather write, even across
+// the wrap point.
+static bool forward_step_lossless(forward_ctx_t *ctx)
+{
+    src_reader_t *sr = ctx->reader;
+    route_dir_stats_t d = {0};
+    uint32_t tail = ctx->sub->tail;
+    uint32_t head = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        forward_account(ctx, &d);
+        return false;
+    }
+
+    size_t span = head - tail;
+
+    bool   moved = false;
+    size_t done  = span;
+    for (int i = 0; i < ctx->dst_count; i++) {
+        port_t *dst  = ctx->dst[i];
+        size_t  sent = dst ? ctx->dst_sent[i] : span;
+        if (sent < span && dst->state >= PORT_STATE_READY) {
+            port_iov_t iov[2];
+            int cnt = src_ring_iov(sr, tail + sent, span - sent, iov);
+            int w = port_writev(dst, iov, cnt);
+            d.writes++;
+            if (w < (int)(span - sent)) d.short_writes++;
+            if (w > 0) {
+                sent += w;
+                ctx->dst_sent[i] = sent;
+                moved = true;
+            }
+        }
+        if (sent < done) done = sent;
+    }
+    if (done == 0) {
+        forward_account(ctx, &d);
+        return moved;
+    }
+
+    for (int i = 0; i < ctx->dst_count; i++) {
+        if (ctx->dst[i]) ctx->dst_sent[i] -= done;
+    }
+    // Sample before releasing the span, while its stamp is still protected.
+    uint32_t ingress;
+    if (src_ingress(sr, ctx->sub, tail, &ingress)) {
+        latency_hist_record(ctx->latency, (uint32_t)esp_timer_get_time() - ingress);
+    }
+    __atomic_store_n(&ctx->sub->tail, tail + done, __ATOMIC_SEQ_CST);
+    d.bytes  = done;
+    d.chunks = 1;
+    forward_account(ctx, &d);
+
+    if (__atomic_load_n(&sr->stalled, __ATOMIC_SEQ_CST) && sr->task) {
+        dp_notify(sr->task);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Framing
+//
+// A framed route forwards whole frames, one destination write each, so a
+// packet-oriented destination (a TCP segment, a USB transfer) carries
+// exactly one frame.  Bytes wait in the fan-out ring until their frame
+// ends: after the delimiter sequence, after a fixed length, or once the
+// source has been silent for frame_gap character times at its current line
+// coding.  Silence is only visible between fan-out chunks.  A frame that
+// reaches ROUTE_FRAME_MAX, or is still open ROUTE_FRAME_STALE_US after its
+// first byte, is forwarded as it stands and counted as partial.
+// ---------------------------------------------------------------------------
+
+// One character (start, data, parity and stop bits) at the port's line
+// coding, in tenths of a microsecond.
+static uint32_t line_char_time(const port_t *port)
+{
+    const port_line_coding_t *lc = &port->line_coding;
+    uint32_t baud = lc->baud_rate ? lc->baud_rate : 115200;
+    uint32_t data = lc->data_bits >= 5 && lc->data_bits <= 8 ? lc->data_bits : 8;
+    uint32_t half_bits = 2 * (1 + data + (lc->parity ? 1 : 0)) + 2 + lc->stop_bits;
+    return (uint32_t)((uint64_t)half_bits * 5000000 / baud);
+}
+
+// Idle-gap end of the frame starting at tail, or 0 while the source may
+// still be sending it (hold_until is then the earliest it can end).
+static size_t frame_idle_end(forward_ctx_t *ctx, uint32_t tail, uint32_t avail, int64_t now)
+{
+    src_reader_t *sr = ctx->reader;
+    uint32_t char_time = line_char_time(ctx->src);
+    uint32_t gap = (uint32_t)((uint64_t)char_time * ctx->frame_gap / 100);
+    uint32_t prev;
+    if (!src_ingress(sr, ctx->sub, tail, &prev)) return avail;
+
+    // A chunk is stamped once it has landed, so the time it took to arrive
+    // does not count as silence before it.
+    uint32_t first = ctx->sub->stamp_idx + 1;
+    uint32_t count = __atomic_load_n(&sr->stamp_count, __ATOMIC_ACQUIRE);
+    uint32_t end = 0;
+    for (uint32_t j = first; j != count; j++) {
+        port_rx_stamp_t s = sr->stamps[j & SRC_STAMP_MASK];
+        uint32_t off = s.seq - tail;
+        if (off >= avail) break;
+        uint32_t next = j + 1 != count ? sr->stamps[(j + 1) & SRC_STAMP_MASK].seq - tail : avail;
+        if (next > avail) next = avail;
+        uint32_t busy = (uint32_t)((uint64_t)(next - off) * char_time / 10);
+        if (s.us - prev >= gap + busy) {
+            end = off;
+            break;
+        }
+        prev = s.us;
+    }
+
+    // Stamps the pump has started overwriting tell nothing; take it all.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&sr->stamp_claim, __ATOMIC_ACQUIRE) - first >= SRC_STAMPS) return avail;
+    if (end) return end;
+
+    uint32_t quiet = (uint32_t)now - prev;
+    if (quiet >= gap) return avail;
+    ctx->hold_until = now + (gap - quiet);
+    return 0;
+}
+
+// Length of the complete frame at the start of the avail bytes past tail,
+// or 0 if it has not ended yet.
+static size_t frame_end(forward_ctx_t *ctx, uint32_t tail, uint32_t avail, int64_t now)
+{
+    switch (ctx->framing) {
+    case ROUTE_FRAME_DELIMITER: {
+        // In drop mode this may scan bytes being overwritten; the read
+        // then detects the overrun and discards them.
+        const uint8_t *ring = ctx->reader->ring;
+        uint32_t n     = ctx->frame_delim_len;
+        uint32_t limit = avail < ROUTE_FRAME_MAX ? avail : ROUTE_FRAME_MAX;
+        uint32_t i     = ctx->frame_scanned;
+        for (; i + n <= limit; i++) {
+            uint32_t k = 0;
+            while (k < n && ring[(tail + i + k) & SRC_RING_MASK] == ctx->frame_delim[k]) k++;
+            if (k == n) return i + n;
+        }
+        ctx->frame_scanned = i;
+        return 0;
+    }
+    case ROUTE_FRAME_FIXED:
+        return avail >= ctx->frame_len ? ctx->frame_len : 0;
+    case ROUTE_FRAME_IDLE:
+        return frame_idle_end(ctx, tail, avail, now);
+    default:
+        return avail;
+    }
+}
+
+// Forward the next complete frame to every destination in one write.
+static bool forward_step_frame(forward_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    src_reader_t *sr = ctx->reader;
+    route_dir_stats_t d = {0};
+    int64_t  now   = esp_timer_get_time();
+    uint32_t tail  = ctx->sub->tail;
+    uint32_t avail = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE) - tail;
+    if (avail == 0) {
+        ctx->holding = false;
+        forward_account(ctx, &d);
+        return false;
+    }
+
+    // A lapped drop-mode subscriber has no frame to find; the read below
+    // resynchronises it.
+    size_t flen = ctx->frame_pending;
+    if (!flen && avail <= SRC_RING_SIZE) {
+        ctx->frame_partial = false;
+        flen = frame_end(ctx, tail, avail, now);
+        if (!flen && avail < ROUTE_FRAME_MAX) {
+            if (!ctx->holding) {
+                ctx->holding       = true;
+                ctx->pending_since = now;
+            }
+            int64_t stale = ctx->pending_since + ROUTE_FRAME_STALE_US;
+            if (now < stale) {
+                if (ctx->framing != ROUTE_FRAME_IDLE || ctx->hold_until > stale) ctx->hold_until = stale;
+                forward_account(ctx, &d);
+                return false;
+            }
+        }
+        if (!flen || flen > ROUTE_FRAME_MAX) {
+            flen = avail < ROUTE_FRAME_MAX ? avail : ROUTE_FRAME_MAX;
+            ctx->frame_partial = true;
+        }
+    }
+    ctx->holding = false;
+
+    uint32_t ingress;
+    bool stamped;
+
+    if (!ctx->lossless) {
+        uint32_t skipped = 0;
+        size_t n = src_ring_read(sr, ctx->sub, buf, flen ? flen : len, &skipped);
+        ctx->frame_scanned = 0;
+        if (skipped) {
+            d.lost = skipped;
+            d.overruns = 1;
+        }
+        if (n == 0) {
+            forward_account(ctx, &d);
+            return skipped > 0;
+        }
+        stamped = src_ingress(sr, ctx->sub, tail, &ingress);
+
+        for (int i = 0; i < ctx->dst_count; i++) {
+            int w = 0;
+            if (ctx->dst[i] && ctx->dst[i]->state >= PORT_STATE_READY) {
+                w = port_write(ctx->dst[i], buf, n);
+                d.writes++;
+            }
+            if (w < (int)n) {
+                d.lost += n - (w > 0 ? w : 0);
+                d.short_writes++;
+            }
+        }
+        d.bytes = n;
+    } else {
+        // The frame stays in the ring until every destination has all of
+        // it, and goes out in one gather write even across the wrap point.
+        bool   moved = false;
+        size_t done  = flen;
+        for (int i = 0; i < ctx->dst_count; i++) {
+            port_t *dst  = ctx->dst[i];
+            size_t  sent = dst ? ctx->dst_sent[i] : flen;
+            if (sent < flen && dst->state >= PORT_STATE_READY) {
+                port_iov_t iov[2];
+                int cnt = src_ring_iov(sr, tail + sent, flen - sent, iov);
+                int w = port_writev(dst, iov, cnt);
+                d.writes++;
+                if (w < (int)(flen - sent)) d.short_writes++;
+                if (w > 0) {
+                    sent += w;
+                    ctx->dst_sent[i] = sent;
+                    moved = true;
+                }
+            }
+            if (sent < done) done = sent;
+        }
+        if (done < flen) {
+            ctx->frame_pending = flen;
+            forward_account(ctx, &d);
+            return moved;
+        }
+
+        memset(ctx->dst_sent, 0, sizeof(ctx->dst_sent));
+        ctx->frame_pending = 0;
+        ctx->frame_scanned = 0;
+        // Sample before releasing the frame, while its stamp is still protected.
+        stamped = src_ingress(sr, ctx->sub, tail, &ingress);
+        __atomic_store_n(&ctx->sub->tail, tail + flen, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sr->stalled, __ATOMIC_SEQ_CST) && sr->task) {
+            dp_notify(sr->task);
+        }
+        d.bytes = flen;
+    }
+
+    d.chunks = 1;
+    d.frames = 1;
+    d.partial_frames = ctx->frame_partial;
+    forward_account(ctx, &d);
+    if (stamped) latency_hist_record(ctx->latency, (uint32_t)esp_timer_get_time() - ingress);
+    return true;
+}
+
+static void frame_configure(forward_ctx_t *ctx, const route_t *r)
+{
+    ctx->framing         = r->framing;
+    ctx->frame_delim_len = r->frame_delim_len;
+    ctx->frame_len       = r->frame_len;
+    ctx->frame_gap       = r->frame_gap;
+    memcpy(ctx->frame_delim, r->frame_delim, sizeof(ctx->frame_delim));
+}
+
+// ---------------------------------------------------------------------------
+// Elastic buffering
+//
+// New data goes straight to a destination whose elastic buffer is empty, as
+// far as its pacer allows; the rest is parked in the buffer and drained on
+// later steps, oldest first.  UART destinations are paced at their line
+// rate, so uart_write_bytes() never blocks and one slow UART cannot hold up
+// the other destinations of a clone route.  A lossless route consumes from
+// the fan-out ring only what every buffer can take.  Parked bytes are not
+// latency-sampled: their delay is the buffer's fill over its rate.
+// ---------------------------------------------------------------------------
+
+static void elastic_pace(elastic_buf_t *e, const port_t *dst)
+{
+    elastic_buf_set_rate(e, dst->type == PORT_TYPE_UART ? 10000000 / line_char_time(dst) : 0);
+}
+
+// Write to dst as much of data as the pacer allows. Returns bytes accepted.
+static size_t elastic_write(elastic_buf_t *e, port_t *dst, const uint8_t *data, size_t len,
+                            int64_t now, route_dir_stats_t *d)
+{
+    uint32_t tokens = elastic_buf_tokens(e, now);
+    if (len > tokens) len = tokens;
+    if (len == 0) return 0;
+
+    int w = port_write(dst, data, len);
+    d->writes++;
+    if (w < (int)len) d->short_writes++;
+    if (w <= 0) return 0;
+    elastic_buf_spend(e, w);
+    return w;
+}
+
+// Hand the destination as much of its backlog as the pacer allows, in one
+// gather write.
+static bool elastic_drain(elastic_buf_t *e, port_t *dst, int64_t now, route_dir_stats_t *d)
+{
+    port_iov_t iov[2];
+    int cnt = elastic_buf_iov(e, elastic_buf_tokens(e, now), iov);
+    size_t len = iov[0].len + (cnt > 1 ? iov[1].len : 0);
+    if (len == 0) return false;
+
+    int w = port_writev(dst, iov, cnt);
+    d->writes++;
+    if (w < (int)len) d->short_writes++;
+    if (w <= 0) return false;
+    elastic_buf_spend(e, w);
+    elastic_buf_consume(e, w);
+    return true;
+}
+
+static bool forward_step_elastic(forward_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    src_reader_t *sr = ctx->reader;
+    route_dir_stats_t d = {0};
+    int64_t now   = esp_timer_get_time();
+    bool    moved = false;
+
+    for (int i = 0; i < ctx->dst_count; i++) {
+        port_t *dst = ctx->dst[i];
+        if (!dst || dst->state < PORT_STATE_READY) continue;
+        elastic_pace(ctx->elastic[i], dst);
+        if (elastic_buf_fill(ctx->elastic[i])) moved |= elastic_drain(ctx->elastic[i], dst, now, &d);
+    }
+
+    uint32_t tail = ctx->sub->tail;
+    const uint8_t *data;
+    size_t n;
+    if (ctx->lossless) {
+        size_t off = tail & SRC_RING_MASK;
+        n = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE) - tail;
+        if (n > SRC_RING_SIZE - off) n = SRC_RING_SIZE - off;
+        for (int i = 0; i < ctx->dst_count; i++) {
+            uint32_t space = elastic_buf_space(ctx->elastic[i]);
+            if (ctx->dst[i] && n > space) n = space;
+        }
+        data = &sr->ring[off];
+    } else {
+        uint32_t skipped = 0;
+        n = src_ring_read(sr, ctx->sub, buf, len, &skipped);
+        if (skipped) {
+            d.lost = skipped;
+            d.overruns = 1;
+            moved = true;
+        }
+        data = buf;
+    }
+    if (n == 0) {
+        forward_account(ctx, &d);
+        return moved;
+    }
+
+    uint32_t ingress;
+    bool stamped = src_ingress(sr, ctx->sub, tail, &ingress);
+    bool parked  = false;
+    for (int i = 0; i < ctx->dst_count; i++) {
+        port_t *dst = ctx->dst[i];
+        elastic_buf_t *e = ctx->elastic[i];
+        if (!dst) continue;
+        size_t w = 0;
+        if (dst->state >= PORT_STATE_READY && elastic_buf_fill(e) == 0) {
+            w = elastic_write(e, dst, data, n, now, &d);
+        }
+        if (w < n) {
+            d.lost += elastic_buf_put(e, data + w, n - w, ctx->elastic_drop_old);
+            parked = true;
+        }
+    }
+
+    if (ctx->lossless) {
+        __atomic_store_n(&ctx->sub->tail, tail + n, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sr->stalled, __ATOMIC_SEQ_CST) && sr->task) {
+            dp_notify(sr->task);
+        }
+    }
+    d.bytes  = n;
+    d.chunks = 1;
+    forward_account(ctx, &d);
+    if (stamped && !parked) latency_hist_record(ctx->latency, (uint32_t)esp_timer_get_time() - ingress);
+    return true;
+}
+
+// Give each destination of a forwarder an elastic buffer, or none of them
+// if PSRAM runs out.
+static void elastic_attach(forward_ctx_t *ctx, const route_t *r, elastic_buf_t *bufs)
+{
+    if (!r->elastic_bytes) return;
+    for (int i = 0; i < ctx->dst_count; i++) {
+        if (elastic_buf_init(&bufs[i], r->elastic_bytes) != ESP_OK) {
+            ESP_LOGW(TAG, "Route %d: no PSRAM for elastic buffers, running unbuffered", r->id);
+            for (int j = 0; j < i; j++) {
+                elastic_buf_free(&bufs[j]);
+                ctx->elastic[j] = NULL;
+            }
+            return;
+        }
+        ctx->elastic[i] = &bufs[i];
+    }
+    ctx->elastic_store    = bufs;
+    ctx->elastic_bytes    = r->elastic_bytes;
+    ctx->elastic_drop_old = r->elastic_overflow == ROUTE_OVERFLOW_DROP_OLD;
+}
+
+// When a forwarder with parked bytes can next write some of them.
+static TickType_t elastic_idle_ticks(forward_ctx_t *ctx, TickType_t idle)
+{
+    for (int i = 0; i < ctx->dst_count; i++) {
+        elastic_buf_t *e = ctx->elastic[i];
+        uint32_t fill = elastic_buf_fill(e);
+        if (!fill) continue;
+        int64_t wait = elastic_buf_wait_us(e, fill);
+        TickType_t t = wait > 0 ? pdMS_TO_TICKS((wait + 999) / 1000) : FLOW_RETRY_TICKS;
+        if (t < 1) t = 1;
+        if (t < idle) idle = t;
+    }
+    return idle;
+}
+
+static bool merge_pending(const merge_src_t *in)
+{
+    return __atomic_load_n(&in->reader->head, __ATOMIC_ACQUIRE) != in->sub->tail;
+}
+
+static bool merge_others_pending(const merge_state_t *m)
+{
+    for (int i = 0; i < m->count; i++) {
+        if (i != m->cur && merge_pending(&m->in[i])) return true;
+    }
+    return false;
+}
+
+static void merge_account(merge_state_t *m, int src, size_t bytes, size_t lost,
+                          bool frame, bool forced)
+{
+    route_merge_stats_t *s = &m->stats[src];
+    seqcount_write_begin(m->stats_seq);
+    s->bytes  += bytes;
+    s->lost   += lost;
+    s->frames += frame;
+    s->forced += forced;
+    seqcount_write_end(m->stats_seq);
+}
+
+static void merge_frame_done(merge_state_t *m)
+{
+    m->mid_frame = false;
+    if (m->frames_left) m->frames_left--;
+    merge_account(m, m->cur, 0, 0, true, false);
+}
+
+// Decide which source to serve.  Returns false if there is nothing to do
+// now: no source has data, or the current one is mid-frame and silent.
+static bool merge_pick(merge_state_t *m, int64_t now)
+{
+    if (m->mid_frame && now - m->turn_start >= ROUTE_MERGE_TURN_MAX_US && merge_others_pending(m)) {
+        m->mid_frame   = false;
+        m->frames_left = 0;
+        merge_account(m, m->cur, 0, 0, false, true);
+    }
+    if (m->mid_frame) {
+        if (merge_pending(&m->in[m->cur])) return true;
+        if (m->mode != ROUTE_ARB_IDLE_GAP || now - m->last_data < m->idle_us) return false;
+        merge_frame_done(m);
+    }
+
+    if (m->frames_left > 0 && merge_pending(&m->in[m->cur])) return true;
+    for (int k = 1; k <= m->count; k++) {
+        int i = (m->cur + k) % m->count;
+        if (merge_pending(&m->in[i])) {
+            m->cur         = i;
+            m->frames_left = m->in[i].weight;
+            m->turn_start  = now;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Forward part of the current source's frame, never past its end.
+static bool merge_step(forward_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    merge_state_t *m = ctx->merge;
+    route_dir_stats_t d = {0};
+    int64_t now = esp_timer_get_time();
+
+    if (!merge_pick(m, now)) {
+        forward_account(ctx, &d);
+        return false;
+    }
+
+    merge_src_t  *in  = &m->in[m->cur];
+    src_reader_t *sr  = in->reader;
+    port_t       *dst = ctx->dst[0];
+    uint32_t tail = in->sub->tail;
+    uint32_t head = __atomic_load_n(&sr->head, __ATOMIC_ACQUIRE);
+    size_t   off  = tail & SRC_RING_MASK;
+    size_t   n    = head - tail;
+    if (n > SRC_RING_SIZE - off) n = SRC_RING_SIZE - off;
+    if (n > len) n = len;
+
+    bool frame_end = m->mode == ROUTE_ARB_BYTE;
+    if (m->mode == ROUTE_ARB_DELIMITER) {
+        // In drop mode this may scan bytes being overwritten; the read
+        // below then detects the overrun and discards them.
+        const uint8_t *p = memchr(&sr->ring[off], m->delimiter, n);
+        if (p) {
+            n = p - &sr->ring[off] + 1;
+            frame_end = true;
+        }
+    }
+
+    uint32_t ingress;
+    bool stamped = src_ingress(sr, in->sub, tail, &ingress);
+    size_t done, lost = 0;
+
+    if (ctx->lossless) {
+        int w = 0;
+        if (dst && dst->state >= PORT_STATE_READY) {
+            w = port_write(dst, &sr->ring[off], n);
+            d.writes++;
+            if (w < (int)n) d.short_writes++;
+        }
+        done = w > 0 ? w : 0;
+        if (done < n) frame_end = false;
+        if (done == 0) {
+            forward_account(ctx, &d);
+            return false;
+        }
+        __atomic_store_n(&in->sub->tail, tail + done, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sr->stalled, __ATOMIC_SEQ_CST) && sr->task) {
+            dp_notify(sr->task);
+        }
+    } else {
+        uint32_t skipped = 0;
+        done = src_ring_read(sr, in->sub, buf, n, &skipped);
+        if (skipped) {
+            // Overrun: the frame is torn anyway, let the next source in.
+            d.lost     = skipped;
+            d.overruns = 1;
+            lost       = skipped;
+            m->mid_frame   = false;
+            m->frames_left = 0;
+        }
+        if (done == 0) {
+            if (lost) merge_account(m, m->cur, 0, lost, false, false);
+            forward_account(ctx, &d);
+            return skipped > 0;
+        }
+        int w = 0;
+        if (dst && dst->state >= PORT_STATE_READY) {
+            w = port_write(dst, buf, done);
+            d.writes++;
+        }
+        if (w < (int)done) {
+            d.short_writes++;
+            lost += done - (w > 0 ? w : 0);
+            d.lost += done - (w > 0 ? w : 0);
+        }
+    }
+
+    d.bytes  = done;
+    d.chunks = 1;
+    forward_account(ctx, &d);
+    merge_account(m, m->cur, done, lost, false, false);
+    if (stamped) latency_hist_record(ctx->latency, (uint32_t)esp_timer_get_time() - ingress);
+
+    m->last_data = now;
+    if (frame_end) {
+        merge_frame_done(m);
+    } else {
+        m->mid_frame = true;
+    }
+    return true;
+}
+
+// When the arbiter must look again without being notified: at the end of
+// an idle gap, when the current turn may be cut, or soon if a lossless
+// destination is refusing data.
+static TickType_t merge_idle_ticks(forward_ctx_t *ctx, TickType_t idle)
+{
+    merge_state_t *m = ctx->merge;
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = INT64_MAX;
+
+    if (m->mid_frame) {
+        if (m->mode == ROUTE_ARB_IDLE_GAP) deadline = m->last_data + m->idle_us;
+        if (merge_others_pending(m) && m->turn_start + ROUTE_MERGE_TURN_MAX_US < deadline) {
+            deadline = m->turn_start + ROUTE_MERGE_TURN_MAX_US;
+        }
+    }
+    if (deadline != INT64_MAX) {
+        int64_t left = deadline - now;
+        TickType_t t = left > 0 ? pdMS_TO_TICKS((left + 999) / 1000) : 0;
+        if (t < 1) t = 1;
+        if (t < idle) idle = t;
+    }
+    if (ctx->lossless && FLOW_RETRY_TICKS < idle) {
+        for (int i = 0; i < m->count; i++) {
+            if (merge_pending(&m->in[i])) return FLOW_RETRY_TICKS;
+        }
+    }
+    return idle;
+}
+
+// ---------------------------------------------------------------------------
+// Live destination changes
+//
+// A forwarder that follows its route compares the route table version
+// before each step and, when it moved, re-reads its destinations from a
+// snapshot.  Destinations that stay keep their place in the stream
+// (lossless sent offsets, elastic backlog); new ones start at the
+// forwarder's cursor; bytes parked for a removed one are counted as lost.
+// ---------------------------------------------------------------------------
+
+// Rebuild the elastic buffers for the new destination order: from[j] is
+// the old index destination j keeps, or -1 for a new one.  Falls back to
+// unbuffered if PSRAM runs out, like elastic_attach().
+static void elastic_remap(forward_ctx_t *ctx, const int *from, const bool *kept, int count,
+                          route_dir_stats_t *d)
+{
+    elastic_buf_t old[ROUTE_MAX_DEST];
+    elastic_buf_t *store = ctx->elastic_store;
+    memcpy(old, store, sizeof(old));
+    for (int i = 0; i < ctx->dst_count; i++) {
+        if (kept[i]) continue;
+        d->lost += elastic_buf_fill(&old[i]);
+        elastic_buf_free(&old[i]);
+    }
+
+    bool ok = true;
+    for (int j = 0; j < ROUTE_MAX_DEST; j++) {
+        if (j < count && from[j] >= 0) {
+            store[j] = old[from[j]];
+        } else {
+            memset(&store[j], 0, sizeof(store[j]));
+            if (j < count && ok) ok = elastic_buf_init(&store[j], ctx->elastic_bytes) == ESP_OK;
+        }
+    }
+
+    for (int j = 0; j < ROUTE_MAX_DEST; j++) {
+        ctx->elastic[j] = ok && j < count ? &store[j] : NULL;
+        if (!ok && store[j].buf) {
+            d->lost += elastic_buf_fill(&store[j]);
+            elastic_buf_free(&store[j]);
+        }
+    }
+    if (!ok) ESP_LOGW(TAG, "Route %d: no PSRAM for elastic buffers, running unbuffered", ctx->route_id);
+}
+
+static void forward_set_dests(forward_ctx_t *ctx, const route_t *r)
+{
+    port_t *dst[ROUTE_MAX_DEST]  = {0};
+    size_t  sent[ROUTE_MAX_DEST] = {0};
+    int     from[ROUTE_MAX_DEST];
+    bool    kept[ROUTE_MAX_DEST] = {0};
+    bool    changed = r->dst_count != ctx->dst_count;
+
+    for (int j = 0; j < r->dst_count; j++) {
+        dst[j]  = port_registry_get(r->dst_port_ids[j]);
+        from[j] = -1;
+        for (int i = 0; i < ctx->dst_count; i++) {
+            if (!kept[i] && ctx->dst[i] == dst[j]) {
+                from[j] = i;
+                kept[i] = true;
+                sent[j] = ctx->dst_sent[i];
+                break;
+            }
+        }
+        if (from[j] != j) changed = true;
+    }
+    if (!changed) return;
+
+    route_dir_stats_t d = {0};
+    if (ctx->elastic[0]) elastic_remap(ctx, from, kept, r->dst_count, &d);
+    memcpy(ctx->dst, dst, sizeof(ctx->dst));
+    memcpy(ctx->dst_sent, sent, sizeof(ctx->dst_sent));
+    ctx->dst_count = r->dst_count;
+    forward_account(ctx, &d);
+    ESP_LOGI(TAG, "Route %d: forwarding %s -> %d dest(s)", ctx->route_id, ctx->src->name, ctx->dst_count);
+}
+
+static void forward_reload(forward_ctx_t *ctx)
+{
+    const route_table_t *t = route_table_acquire();
+    ctx->table_version = t->version;
+    const route_t *r = route_table_find(t, ctx->route_id);
+    if (r) forward_set_dests(ctx, r);
+    route_table_release(t);
+}
+
+// Forward whatever is pending for one route direction.
+// Returns true if the cursor moved (data forwarded or skipped).
+static bool forward_step(forward_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    if (ctx->follow_dests && ctx->table_version != route_table_version()) forward_reload(ctx);
+    if (ctx->merge) return merge_step(ctx, buf, len);
+    if (ctx->framing != ROUTE_FRAME_NONE) return forward_step_frame(ctx, buf, len);
+    if (forward_hold(ctx)) return false;
+    if (ctx->elastic[0]) return forward_step_elastic(ctx, buf, len);
+    if (ctx->lossless) return forward_step_lossless(ctx);
+    return forward_step_drop(ctx, buf, len);
+}
+
+// How long a forwarder that made no progress may sleep before it has to
+// look again without being notified: until its coalescing or framing
+// deadline, until its pacer lets parked bytes out, or a tick if a lossless
+// destination refused data.  Otherwise `idle`.
+static TickType_t forward_idle_ticks(forward_ctx_t *ctx, TickType_t idle)
+{
+    if (ctx->merge) return merge_idle_ticks(ctx, idle);
+    if (ctx->holding) {
+        int64_t left = ctx->hold_until - esp_timer_get_time();
+        TickType_t t = left > 0 ? pdMS_TO_TICKS((left + 999) / 1000) : 0;
+        return t > 0 ? t : 1;
+    }
+    if (ctx->elastic[0]) idle = elastic_idle_ticks(ctx, idle);
+    if (ctx->lossless &&
+        ctx->sub->tail != __atomic_load_n(&ctx->reader->head, __ATOMIC_ACQUIRE)) {
+        return FLOW_RETRY_TICKS;
+    }
+    return idle;
+}
+
+// Release a stopped forwarder and signal the route's join semaphore.
+static void forward_exit(forward_ctx_t *ctx)
+{
+    route_dir_stats_t none = {0};
+    forward_account(ctx, &none);   // fold stalls still pending
+
+    ESP_LOGI(TAG, "Forwarding %s stopped", ctx->src->name);
+    SemaphoreHandle_t done = ctx->done_sem;
+    free(ctx->merge);
+    free(ctx);
+    xSemaphoreGive(done);
+}
+
+#ifndef CONFIG_VUART_ROUTE_DISPATCHER
+static void forward_task(void *arg)
+{
+    forward_ctx_t *ctx = (forward_ctx_t *)arg;
+    uint8_t buf[FORWARD_BUF_SIZE];
+
+    ctx->sub->waiter = xTaskGetCurrentTaskHandle();
+    if (ctx->merge) {
+        for (int i = 1; i < ctx->merge->count; i++) {
+            ctx->merge->in[i].sub->waiter = ctx->sub->waiter;
+        }
+    }
+    ESP_LOGI(TAG, "Forwarding %s -> %d dest(s) started", ctx->src->name, ctx->dst_count);
+
+    while (*ctx->running) {
+        if (!forward_step(ctx, buf, sizeof(buf))) {
+            ulTaskNotifyTake(pdTRUE, forward_idle_ticks(ctx, pdMS_TO_TICKS(50)));
+            DP_COUNT(dp_wakeups, 1);
+        }
+    }
+
+    src_sub_quiesce(ctx->reader, ctx->sub);
+    if (ctx->merge) {
+        for (int i = 1; i < ctx->merge->count; i++) {
+            src_sub_quiesce(ctx->merge->in[i].reader, ctx->merge->in[i].sub);
+        }
+    }
+    DP_COUNT(dp_task_count, -1);
+    forward_exit(ctx);
+    vTaskDelete(NULL);
+}
+#endif
+
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+static bool dispatch_add_forward(forward_ctx_t *ctx);
+#endif
+
+#ifndef CONFIG_VUART_ROUTE_DISPATCHER
+// A forwarder belongs next to its destinations, if they share a home core.
+static BaseType_t plan_forward_core(forward_ctx_t *ctx)
+{
+    port_t *dst = ctx->dst[0];
+    for (int i = 1; i < ctx->dst_count && dst; i++) {
+        if (!ctx->dst[i] || ctx->dst[i]->home_core != dst->home_core) dst = NULL;
+    }
+    return plan_core(dst, ctx->src);
+}
+#endif
+
+// Start a forwarder: a dedicated task, or the dispatcher owning its source.
+static bool forward_start(forward_ctx_t *ctx, const char *name, TaskHandle_t *handle)
+{
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+    (void)name;
+    *handle = NULL;
+    return dispatch_add_forward(ctx);
+#else
+    if (xTaskCreatePinnedToCore(forward_task, name, FORWARD_STACK_SIZE, ctx, 5, handle,
+                                plan_forward_core(ctx)) != pdPASS) {
+        return false;
+    }
+    DP_COUNT(dp_task_count, 1);
+    return true;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Data-plane dispatcher (CONFIG_VUART_ROUTE_DISPATCHER)
+//
+// Instead of one task per pump and per route direction, DISPATCH_COUNT
+// tasks run the same pump and forward steps to completion.  Each source
+// port is owned by one dispatcher, together with every forwarder reading
+// from it.  A dispatcher sleeps on its task notification with no timeout:
+// port_rx_push() on an owned source wakes it, and so does dispatch_kick()
+// when routes start or stop.
+// ---------------------------------------------------------------------------
+
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+
+#define DISPATCH_COUNT      CONFIG_VUART_ROUTE_DISPATCHER_COUNT
+#define DISPATCH_FWD_MAX    (ROUTE_MAX_COUNT * 2)
+
+typedef struct {
+    TaskHandle_t    task;
+    forward_ctx_t  *fwd[DISPATCH_FWD_MAX];
+} dispatcher_t;
+
+static dispatcher_t dispatchers[DISPATCH_COUNT];
+static portMUX_TYPE dispatch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void dispatch_kick(void)
+{
+    for (int i = 0; i < DISPATCH_COUNT; i++) {
+        if (dispatchers[i].task) xTaskNotifyGive(dispatchers[i].task);
     }
-    return q;
 }
 
-// Unsubscribe a queue from its source.  Drains leftover chunks.
-// Stops and destroys the pump task when the last subscriber is removed.
-static void src_unsubscribe(port_t *src, QueueHandle_t q)
+static void dispatcher_task(void *arg)
 {
-    if (!src || !q) return;
+    dispatcher_t *d = (dispatcher_t *)arg;
+    int idx = d - dispatchers;
+    uint8_t buf[FORWARD_BUF_SIZE];
 
-    xSemaphoreTake(src_reader_mutex, portMAX_DELAY);
+    ESP_LOGI(TAG, "Dispatcher %d started", idx);
+
+    for (;;) {
+        bool progress;
+        TickType_t wait;
+        do {
+            progress = false;
+            wait     = portMAX_DELAY;
+
+            for (int i = 0; i < SRC_READER_MAX; i++) {
+                src_reader_t *sr = &src_readers[i];
+                if (!__atomic_load_n(&sr->attached, __ATOMIC_ACQUIRE)) continue;
+                if (sr->dispatcher != idx) continue;
+                if (!sr->running) {
+                    sr->src->rx_notify = NULL;
+                    __atomic_store_n(&sr->attached, false, __ATOMIC_RELEASE);
+                    xSemaphoreGive(sr->pump_done);
+                    continue;
+                }
+                if (src_pump_step(sr, 0) > 0) progress = true;
+            }
 
-    for (int i = 0; i < SRC_READER_MAX; i++) {
-        src_reader_t *sr = &src_readers[i];
-        if (sr->src != src) continue;
+            for (int i = 0; i < DISPATCH_FWD_MAX; i++) {
+                forward_ctx_t *ctx = __atomic_load_n(&d->fwd[i], __ATOMIC_ACQUIRE);
+                if (!ctx) continue;
+                if (!*ctx->running) {
+                    __atomic_store_n(&d->fwd[i], NULL, __ATOMIC_RELEASE);
+                    forward_exit(ctx);
+                    continue;
+                }
+                if (forward_step(ctx, buf, sizeof(buf))) {
+                    progress = true;
+                } else {
+                    TickType_t t = forward_idle_ticks(ctx, portMAX_DELAY);
+                    if (t < wait) wait = t;
+                }
+            }
+        } while (progress);
 
-        xSemaphoreTake(sr->mutex, portMAX_DELAY);
-        for (int j = 0; j < SRC_SUB_MAX; j++) {
-            if (!sr->subs[j].active || sr->subs[j].queue != q) continue;
-            // Drain residual chunks before deleting.
-            fanout_chunk_t chunk;
-            while (xQueueReceive(q, &chunk, 0) == pdTRUE) free(chunk.data);
-            vQueueDelete(q);
-            sr->subs[j].queue  = NULL;
-            sr->subs[j].active = false;
-            sr->ref_count--;
-            break;
-        }
-        bool stop = (sr->ref_count == 0);
-        if (stop) sr->running = false;
-        xSemaphoreGive(sr->mutex);
+        ulTaskNotifyTake(pdTRUE, wait);
+        DP_COUNT(dp_wakeups, 1);
+    }
+}
 
-        if (stop) {
-            // Release global mutex while waiting for pump task to exit.
-            xSemaphoreGive(src_reader_mutex);
-            if (xSemaphoreTake(sr->pump_done, pdMS_TO_TICKS(1000)) != pdTRUE) {
-                ESP_LOGW(TAG, "Pump %s did not exit in time", src->name);
-            }
-            xSemaphoreTake(src_reader_mutex, portMAX_DELAY);
+// With one dispatcher per core, a source goes to the dispatcher on its
+// planned core; otherwise sources are spread round-robin.
+static bool dispatch_attach_reader(src_reader_t *sr)
+{
+    BaseType_t core = plan_core(sr->src, NULL);
+    if (DISPATCH_COUNT > 1 && core != tskNO_AFFINITY) {
+        sr->dispatcher = core;
+    } else {
+        sr->dispatcher = (int)(sr - src_readers) % DISPATCH_COUNT;
+    }
+    sr->src->rx_notify = dispatchers[sr->dispatcher].task;
+    sr->task = dispatchers[sr->dispatcher].task;   // woken when lossless credit returns
+    __atomic_store_n(&sr->attached, true, __ATOMIC_RELEASE);
+    dispatch_kick();
+    return true;
+}
 
-            // Re-check: a new subscriber may have raced in while we waited (NB-3).
-            xSemaphoreTake(sr->mutex, portMAX_DELAY);
-            if (sr->ref_count == 0) {
-                xSemaphoreGive(sr->mutex);
-                vSemaphoreDelete(sr->mutex);
-                vSemaphoreDelete(sr->pump_done);
-                sr->src       = NULL;
-                sr->task      = NULL;
-                sr->pump_done = NULL;
-                sr->mutex     = NULL;
-                ESP_LOGI(TAG, "Pump for %s destroyed", src->name);
-            } else {
-                // A new subscriber arrived while pump was stopping -- restart it.
-                sr->running = true;
-                char name[PORT_NAME_MAX + 6];
-                snprintf(name, sizeof(name), "pump_%s", src->name);
-                BaseType_t ret = xTaskCreate(src_pump_task, name, FORWARD_STACK_SIZE,
-                                             sr, 5, &sr->task);
-                if (ret != pdPASS) {
-                    ESP_LOGE(TAG, "Failed to restart pump for %s", src->name);
-                }
-                xSemaphoreGive(sr->mutex);
-                ESP_LOGW(TAG, "Pump for %s restarted (subscriber raced in)", src->name);
+static bool dispatch_add_forward(forward_ctx_t *ctx)
+{
+    dispatcher_t *d = &dispatchers[ctx->reader->dispatcher];
+    bool added = false;
+
+    // Merge sources pumped by another dispatcher must wake this one.
+    if (ctx->merge) {
+        for (int i = 1; i < ctx->merge->count; i++) {
+            if (ctx->merge->in[i].reader->dispatcher != ctx->reader->dispatcher) {
+                ctx->merge->in[i].sub->waiter = d->task;
             }
         }
-        break;
     }
 
-    xSemaphoreGive(src_reader_mutex);
+    taskENTER_CRITICAL(&dispatch_lock);
+    for (int i = 0; i < DISPATCH_FWD_MAX; i++) {
+        if (!d->fwd[i]) {
+            __atomic_store_n(&d->fwd[i], ctx, __ATOMIC_RELEASE);
+            added = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&dispatch_lock);
+
+    if (added) {
+        ESP_LOGI(TAG, "Forwarding %s -> %d dest(s) started", ctx->src->name, ctx->dst_count);
+        xTaskNotifyGive(d->task);
+    }
+    return added;
+}
+
+static esp_err_t dispatch_init(void)
+{
+    memset(dispatchers, 0, sizeof(dispatchers));
+    for (int i = 0; i < DISPATCH_COUNT; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "dispatch_%d", i);
+        BaseType_t core = DISPATCH_COUNT > 1 ? i : tskNO_AFFINITY;
+        if (xTaskCreatePinnedToCore(dispatcher_task, name, DISPATCH_STACK_SIZE, &dispatchers[i],
+                                    5, &dispatchers[i].task, core) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create dispatcher %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+        DP_COUNT(dp_task_count, 1);
+    }
+    return ESP_OK;
 }
 
+#else
+
+static void dispatch_kick(void) {}
+
+#endif // CONFIG_VUART_ROUTE_DISPATCHER
+
 // ---------------------------------------------------------------------------
-// Forwarding task
+// Private per-route runtime state (not exposed in route.h)
 // ---------------------------------------------------------------------------
 
 typedef struct {
-    port_t            *src;
-    QueueHandle_t      src_queue;   // private subscriber queue from src_subscribe()
-    port_t            *dst[ROUTE_MAX_DEST];
-    int                dst_count;
-    volatile bool     *running;
-    volatile uint32_t *bytes_counter;
-    SemaphoreHandle_t  done_sem;    // signaled before task exit
-} forward_ctx_t;
-
-static void forward_task(void *arg)
-{
-    forward_ctx_t *ctx = (forward_ctx_t *)arg;
-    fanout_chunk_t chunk;
+    src_sub_t          *fwd_sub;
+    src_sub_t          *rev_sub;
+    SemaphoreHandle_t   done_sem;       // counting semaphore for task join
+    seqcount_t          stats_seq[2];   // [0] src->dst, [1] dst->src
+    route_dir_stats_t   stats[2];       // monotonic since route_create()
+    latency_hist_t      latency[2];
+    src_sub_t          *merge_subs[ROUTE_MERGE_MAX_SRC - 1];   // extra merge sources
+    port_t             *merge_ports[ROUTE_MERGE_MAX_SRC - 1];
+    seqcount_t          merge_seq;
+    route_merge_stats_t merge_stats[ROUTE_MERGE_MAX_SRC];
+    elastic_buf_t       elastic[ROUTE_MAX_DEST + 1];    // destinations, then the reverse direction
+} route_runtime_t;
 
-    ESP_LOGI(TAG, "Forwarding %s -> %d dest(s) started", ctx->src->name, ctx->dst_count);
+static route_runtime_t route_rt[ROUTE_MAX_COUNT];
 
-    while (*ctx->running) {
-        if (xQueueReceive(ctx->src_queue, &chunk, pdMS_TO_TICKS(50)) != pdTRUE) continue;
-        for (int i = 0; i < ctx->dst_count; i++) {
-            if (ctx->dst[i] && ctx->dst[i]->state >= PORT_STATE_READY) {
-                ctx->dst[i]->ops.write(ctx->dst[i], chunk.data, chunk.len,
-                                       pdMS_TO_TICKS(100));
-            }
-        }
-        *ctx->bytes_counter += chunk.len;
-        free(chunk.data);
+static void elastic_release(int slot)
+{
+    for (int i = 0; i < ROUTE_MAX_DEST + 1; i++) {
+        if (route_rt[slot].elastic[i].buf) elastic_buf_free(&route_rt[slot].elastic[i]);
     }
-
-    // Drain any chunks the pump pushed after we stopped.
-    while (xQueueReceive(ctx->src_queue, &chunk, 0) == pdTRUE) free(chunk.data);
-
-    ESP_LOGI(TAG, "Forwarding %s stopped", ctx->src->name);
-    SemaphoreHandle_t done = ctx->done_sem;
-    free(ctx);
-    xSemaphoreGive(done);
-    vTaskDelete(NULL);
 }
 
 // ---------------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------------
 
-static route_t           routes[ROUTE_MAX_COUNT];
+static route_t           routes[ROUTE_MAX_COUNT];     // working copy, under route_mutex
 static SemaphoreHandle_t route_mutex;
 static uint8_t           next_route_id = 0;
 
+// Publish routes[] as the new route table. Called with route_mutex held.
+static void route_table_publish(void)
+{
+    table_slot_t *cur  = route_table_cur;
+    table_slot_t *next = NULL;
+    for (;;) {
+        for (int i = 0; i < ROUTE_TABLE_POOL && !next; i++) {
+            table_slot_t *s = &route_tables[i];
+            if (s != cur && __atomic_load_n(&s->refs, __ATOMIC_SEQ_CST) == 0) next = s;
+        }
+        if (next) break;
+        vTaskDelay(1);  // both spare copies still pinned by readers
+    }
+
+    int n = 0;
+    for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
+        if (routes[i].active || routes[i].task_count > 0) next->t.routes[n++] = routes[i];
+    }
+    next->t.count   = n;
+    next->t.version = cur->t.version + 1;
+    __atomic_store_n(&route_table_cur, next, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&route_table_gen, next->t.version, __ATOMIC_RELEASE);
+    signal_router_kick();
+}
+
 esp_err_t route_engine_init(void)
 {
     route_mutex      = xSemaphoreCreateMutex();
@@ -319,7 +1757,44 @@ esp_err_t route_engine_init(void)
     memset(route_rt,    0, sizeof(route_rt));
     memset(src_readers, 0, sizeof(src_readers));
     next_route_id = 0;
+    route_table_publish();
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+    esp_err_t ret = dispatch_init();
+    if (ret != ESP_OK) return ret;
+    ESP_LOGI(TAG, "Route engine initialized (max %d routes, %d dispatcher(s))",
+             ROUTE_MAX_COUNT, DISPATCH_COUNT);
+#else
     ESP_LOGI(TAG, "Route engine initialized (max %d routes)", ROUTE_MAX_COUNT);
+#endif
+    return ESP_OK;
+}
+
+// A merge must read each of its sources once, all of them registered, and
+// never its own destination, or it would emit bytes twice or feed its
+// output back in.
+static esp_err_t merge_check_sources(const route_t *r)
+{
+    uint8_t ids[ROUTE_MERGE_MAX_SRC];
+    int n = 1 + (r->merge_src_count < ROUTE_MERGE_MAX_SRC - 1 ? r->merge_src_count : ROUTE_MERGE_MAX_SRC - 1);
+
+    ids[0] = r->src_port_id;
+    memcpy(&ids[1], r->merge_src_ids, n - 1);
+    for (int i = 0; i < n; i++) {
+        if (!port_registry_get(ids[i])) {
+            ESP_LOGE(TAG, "Merge source port %d not found", ids[i]);
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (r->dst_count > 0 && ids[i] == r->dst_port_ids[0]) {
+            ESP_LOGE(TAG, "Merge source port %d is also its destination", ids[i]);
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (int j = 0; j < i; j++) {
+            if (ids[j] == ids[i]) {
+                ESP_LOGE(TAG, "Merge source port %d listed twice", ids[i]);
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
     return ESP_OK;
 }
 
@@ -353,13 +1828,49 @@ esp_err_t route_create(const route_t *config, uint8_t *route_id_out)
             return ESP_ERR_NOT_FOUND;
         }
     }
+    if (config->type == ROUTE_TYPE_MERGE) {
+        esp_err_t err = merge_check_sources(config);
+        if (err != ESP_OK) {
+            xSemaphoreGive(route_mutex);
+            return err;
+        }
+    }
 
     routes[slot] = *config;
     routes[slot].id                  = next_route_id++;
     routes[slot].active              = true;
     routes[slot].task_count          = 0;
-    routes[slot].bytes_fwd_src_to_dst = 0;
-    routes[slot].bytes_fwd_dst_to_src = 0;
+    if (routes[slot].coalesce_bytes > ROUTE_COALESCE_MAX_BYTES) {
+        routes[slot].coalesce_bytes = ROUTE_COALESCE_MAX_BYTES;
+    }
+    if (routes[slot].coalesce_us > ROUTE_COALESCE_MAX_US) {
+        routes[slot].coalesce_us = ROUTE_COALESCE_MAX_US;
+    }
+    if (routes[slot].type == ROUTE_TYPE_MERGE) {
+        route_t *m = &routes[slot];
+        if (m->dst_count > 1) m->dst_count = 1;
+        if (m->merge_src_count > ROUTE_MERGE_MAX_SRC - 1) m->merge_src_count = ROUTE_MERGE_MAX_SRC - 1;
+        if (m->arbitration > ROUTE_ARB_IDLE_GAP) m->arbitration = ROUTE_ARB_BYTE;
+        if (m->arb_idle_us == 0) m->arb_idle_us = ROUTE_MERGE_IDLE_DEFAULT_US;
+        if (m->arb_idle_us > ROUTE_MERGE_IDLE_MAX_US) m->arb_idle_us = ROUTE_MERGE_IDLE_MAX_US;
+        for (int i = 0; i < ROUTE_MERGE_MAX_SRC; i++) {
+            if (m->merge_weights[i] == 0) m->merge_weights[i] = 1;
+        }
+        m->framing = ROUTE_FRAME_NONE;
+    }
+    {
+        route_t *f = &routes[slot];
+        if (f->framing > ROUTE_FRAME_IDLE) f->framing = ROUTE_FRAME_NONE;
+        if (f->frame_delim_len > ROUTE_FRAME_DELIM_MAX) f->frame_delim_len = ROUTE_FRAME_DELIM_MAX;
+        if (f->framing == ROUTE_FRAME_DELIMITER && f->frame_delim_len == 0) f->framing = ROUTE_FRAME_NONE;
+        if (f->frame_len > ROUTE_FRAME_MAX) f->frame_len = ROUTE_FRAME_MAX;
+        if (f->framing == ROUTE_FRAME_FIXED && f->frame_len == 0) f->framing = ROUTE_FRAME_NONE;
+        if (f->frame_gap == 0) f->frame_gap = ROUTE_FRAME_GAP_DEFAULT;
+        if (f->frame_gap > ROUTE_FRAME_GAP_MAX) f->frame_gap = ROUTE_FRAME_GAP_MAX;
+        if (f->type == ROUTE_TYPE_MERGE || f->framing != ROUTE_FRAME_NONE) f->elastic_bytes = 0;
+        if (f->elastic_bytes > ELASTIC_MAX_BYTES) f->elastic_bytes = ELASTIC_MAX_BYTES;
+        if (f->elastic_overflow > ROUTE_OVERFLOW_DROP_OLD) f->elastic_overflow = ROUTE_OVERFLOW_DROP_NEW;
+    }
     memset(routes[slot].task_handles, 0, sizeof(routes[slot].task_handles));
     memset(&route_rt[slot], 0, sizeof(route_rt[slot]));
 
@@ -381,10 +1892,67 @@ esp_err_t route_create(const route_t *config, uint8_t *route_id_out)
     ESP_LOGI(TAG, "Route %d created: type=%d src=%d dst_count=%d",
              routes[slot].id, config->type, config->src_port_id, config->dst_count);
 
+    route_table_publish();
     xSemaphoreGive(route_mutex);
     return ESP_OK;
 }
 
+// Release the extra sources of a merge route.  Called without route_mutex.
+static void merge_detach(int slot)
+{
+    for (int i = 0; i < ROUTE_MERGE_MAX_SRC - 1; i++) {
+        src_sub_t *sub = route_rt[slot].merge_subs[i];
+        port_t *port   = route_rt[slot].merge_ports[i];
+        route_rt[slot].merge_subs[i]  = NULL;
+        route_rt[slot].merge_ports[i] = NULL;
+        src_unsubscribe(port, sub);
+    }
+}
+
+// Set up the arbiter of a merge route whose forwarder already reads its
+// first source, subscribing to the others.  Called with route_mutex held;
+// releases it around each subscription like route_start().
+static bool merge_attach(forward_ctx_t *ctx, route_t *r, int slot)
+{
+    merge_state_t *m = calloc(1, sizeof(merge_state_t));
+    if (!m) return false;
+
+    m->in[0]     = (merge_src_t){ ctx->src, ctx->reader, ctx->sub, r->merge_weights[0] };
+    m->count     = 1;
+    m->mode      = r->arbitration;
+    m->delimiter = r->arb_delimiter;
+    m->idle_us   = r->arb_idle_us;
+    m->stats_seq = &route_rt[slot].merge_seq;
+    m->stats     = route_rt[slot].merge_stats;
+
+    for (int i = 0; i < r->merge_src_count; i++) {
+        port_t *src = port_registry_get(r->merge_src_ids[i]);
+        if (!src) continue;
+        if (src->state == PORT_STATE_DISABLED && src->ops.open) src->ops.open(src);
+
+        merge_src_t *in = &m->in[m->count];
+        xSemaphoreGive(route_mutex);
+        in->sub = src_subscribe(src, ctx->lossless, &in->reader);
+        xSemaphoreTake(route_mutex, portMAX_DELAY);
+        if (!in->sub) {
+            xSemaphoreGive(route_mutex);
+            merge_detach(slot);
+            xSemaphoreTake(route_mutex, portMAX_DELAY);
+            free(m);
+            return false;
+        }
+        in->src    = src;
+        in->weight = r->merge_weights[i + 1];
+        route_rt[slot].merge_subs[m->count - 1]  = in->sub;
+        route_rt[slot].merge_ports[m->count - 1] = src;
+        m->count++;
+    }
+
+    ctx->merge = m;
+    ESP_LOGI(TAG, "Merge route %d: %d source(s), arbitration %d", r->id, m->count, m->mode);
+    return true;
+}
+
 esp_err_t route_start(uint8_t route_id)
 {
     xSemaphoreTake(route_mutex, portMAX_DELAY);
@@ -443,14 +2011,23 @@ esp_err_t route_start(uint8_t route_id)
             }
         }
         ctx->running       = &r->active;
-        ctx->bytes_counter = &r->bytes_fwd_src_to_dst;
+        ctx->stats_seq     = &route_rt[slot].stats_seq[0];
+        ctx->stats         = &route_rt[slot].stats[0];
+        ctx->latency       = &route_rt[slot].latency[0];
         ctx->done_sem      = route_rt[slot].done_sem;
+        ctx->lossless      = r->flow == ROUTE_FLOW_LOSSLESS;
+        ctx->coalesce_bytes = r->coalesce_bytes;
+        ctx->coalesce_us    = r->coalesce_us;
+        ctx->route_id       = route_id;
+        ctx->follow_dests   = r->type != ROUTE_TYPE_BRIDGE;
+        ctx->table_version  = route_table_version();
+        frame_configure(ctx, r);
 
         // Subscribe to source fan-out (safe for multiple routes on same port).
         xSemaphoreGive(route_mutex);
-        QueueHandle_t q = src_subscribe(src);
+        src_sub_t *sub = src_subscribe(src, ctx->lossless, &ctx->reader);
         xSemaphoreTake(route_mutex, portMAX_DELAY);
-        if (!q) {
+        if (!sub) {
             free(ctx);
             vSemaphoreDelete(route_rt[slot].done_sem);
             route_rt[slot].done_sem = NULL;
@@ -458,17 +2035,30 @@ esp_err_t route_start(uint8_t route_id)
             return ESP_ERR_NO_MEM;
         }
 
-        ctx->src_queue              = q;
-        route_rt[slot].fwd_src_queue = q;
+        ctx->sub               = sub;
+        route_rt[slot].fwd_sub = sub;
+
+        if (r->type == ROUTE_TYPE_MERGE && !merge_attach(ctx, r, slot)) {
+            route_rt[slot].fwd_sub = NULL;
+            xSemaphoreGive(route_mutex);
+            src_unsubscribe(src, sub);
+            free(ctx);
+            vSemaphoreDelete(route_rt[slot].done_sem);
+            route_rt[slot].done_sem = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+
+        elastic_attach(ctx, r, &route_rt[slot].elastic[0]);
 
         char name[16];
         snprintf(name, sizeof(name), "fwd_%d_ab", route_id);
-        BaseType_t ret = xTaskCreate(forward_task, name, FORWARD_STACK_SIZE,
-                                     ctx, 5, &r->task_handles[0]);
-        if (ret != pdPASS) {
-            route_rt[slot].fwd_src_queue = NULL;
+        if (!forward_start(ctx, name, &r->task_handles[0])) {
+            route_rt[slot].fwd_sub = NULL;
             xSemaphoreGive(route_mutex);
-            src_unsubscribe(src, q);
+            src_unsubscribe(src, sub);
+            merge_detach(slot);
+            elastic_release(slot);
+            free(ctx->merge);
             free(ctx);
             vSemaphoreDelete(route_rt[slot].done_sem);
             route_rt[slot].done_sem = NULL;
@@ -488,25 +2078,31 @@ esp_err_t route_start(uint8_t route_id)
             ctx->dst[0]    = src;
             ctx->dst_count = 1;
             ctx->running       = &r->active;
-            ctx->bytes_counter = &r->bytes_fwd_dst_to_src;
+            ctx->stats_seq     = &route_rt[slot].stats_seq[1];
+            ctx->stats         = &route_rt[slot].stats[1];
+            ctx->latency       = &route_rt[slot].latency[1];
             ctx->done_sem      = route_rt[slot].done_sem;
+            ctx->lossless      = r->flow == ROUTE_FLOW_LOSSLESS;
+            ctx->coalesce_bytes = r->coalesce_bytes;
+            ctx->coalesce_us    = r->coalesce_us;
+            ctx->route_id       = route_id;
+            frame_configure(ctx, r);
 
             xSemaphoreGive(route_mutex);
-            QueueHandle_t q = src_subscribe(dst0);
+            src_sub_t *sub = src_subscribe(dst0, ctx->lossless, &ctx->reader);
             xSemaphoreTake(route_mutex, portMAX_DELAY);
-            if (!q) { free(ctx); goto rollback_fwd; }
+            if (!sub) { free(ctx); goto rollback_fwd; }
 
-            ctx->src_queue              = q;
-            route_rt[slot].rev_src_queue = q;
+            ctx->sub               = sub;
+            route_rt[slot].rev_sub = sub;
+            elastic_attach(ctx, r, &route_rt[slot].elastic[ROUTE_MAX_DEST]);
 
             char name[16];
             snprintf(name, sizeof(name), "fwd_%d_ba", route_id);
-            BaseType_t ret = xTaskCreate(forward_task, name, FORWARD_STACK_SIZE,
-                                         ctx, 5, &r->task_handles[1]);
-            if (ret != pdPASS) {
-                route_rt[slot].rev_src_queue = NULL;
+            if (!forward_start(ctx, name, &r->task_handles[1])) {
+                route_rt[slot].rev_sub = NULL;
                 xSemaphoreGive(route_mutex);
-                src_unsubscribe(dst0, q);
+                src_unsubscribe(dst0, sub);
                 xSemaphoreTake(route_mutex, portMAX_DELAY);
                 free(ctx);
                 goto rollback_fwd;
@@ -516,24 +2112,28 @@ esp_err_t route_start(uint8_t route_id)
     }
 
     ESP_LOGI(TAG, "Route %d started: type=%d, %d task(s)", route_id, r->type, r->task_count);
+    route_table_publish();
     xSemaphoreGive(route_mutex);
     return ESP_OK;
 
 rollback_fwd:
     // Roll back the already-running forward task.
     r->active = false;
+    dispatch_kick();
     {
-        QueueHandle_t fwd_q = route_rt[slot].fwd_src_queue;
-        route_rt[slot].fwd_src_queue = NULL;
+        src_sub_t *fwd_sub = route_rt[slot].fwd_sub;
+        route_rt[slot].fwd_sub = NULL;
         xSemaphoreGive(route_mutex);
         xSemaphoreTake(route_rt[slot].done_sem, pdMS_TO_TICKS(1000));
-        src_unsubscribe(src, fwd_q);
+        src_unsubscribe(src, fwd_sub);
         xSemaphoreTake(route_mutex, portMAX_DELAY);
+        elastic_release(slot);
     }
     r->task_count = 0;
     memset(r->task_handles, 0, sizeof(r->task_handles));
     vSemaphoreDelete(route_rt[slot].done_sem);
     route_rt[slot].done_sem = NULL;
+    route_table_publish();
     xSemaphoreGive(route_mutex);
     return ESP_ERR_NO_MEM;
 }
@@ -558,17 +2158,18 @@ esp_err_t route_stop(uint8_t route_id)
 
     // Signal tasks to stop (they check r->active in their loop).
     r->active = false;
+    dispatch_kick();
 
     // Collect info needed for cleanup while holding mutex.
     int tc = r->task_count;
     port_t *src  = port_registry_get(r->src_port_id);
     port_t *dst0 = (r->type == ROUTE_TYPE_BRIDGE && r->dst_count > 0)
                    ? port_registry_get(r->dst_port_ids[0]) : NULL;
-    QueueHandle_t fwd_q = route_rt[slot].fwd_src_queue;
-    QueueHandle_t rev_q = route_rt[slot].rev_src_queue;
+    src_sub_t *fwd_sub = route_rt[slot].fwd_sub;
+    src_sub_t *rev_sub = route_rt[slot].rev_sub;
     SemaphoreHandle_t done = route_rt[slot].done_sem;
-    route_rt[slot].fwd_src_queue = NULL;
-    route_rt[slot].rev_src_queue = NULL;
+    route_rt[slot].fwd_sub = NULL;
+    route_rt[slot].rev_sub = NULL;
 
     xSemaphoreGive(route_mutex);
 
@@ -579,14 +2180,17 @@ esp_err_t route_stop(uint8_t route_id)
         }
     }
 
-    // Unsubscribe queues (may stop pump tasks if last subscriber).
-    src_unsubscribe(src,  fwd_q);
-    src_unsubscribe(dst0, rev_q);
+    // Release fan-out cursors (may stop pump tasks if last subscriber).
+    src_unsubscribe(src,  fwd_sub);
+    src_unsubscribe(dst0, rev_sub);
+    merge_detach(slot);
+    elastic_release(slot);
 
     // Now safe to clear task state -- slot cannot be reused until task_count = 0.
     xSemaphoreTake(route_mutex, portMAX_DELAY);
     r->task_count = 0;
     memset(r->task_handles, 0, sizeof(r->task_handles));
+    route_table_publish();
     xSemaphoreGive(route_mutex);
 
     vSemaphoreDelete(done);
@@ -606,6 +2210,7 @@ esp_err_t route_destroy(uint8_t route_id)
             ESP_LOGI(TAG, "Route %d destroyed", route_id);
             memset(&routes[i], 0, sizeof(route_t));
             memset(&route_rt[i], 0, sizeof(route_runtime_t));
+            route_table_publish();
             xSemaphoreGive(route_mutex);
             return ESP_OK;
         }
@@ -614,50 +2219,250 @@ esp_err_t route_destroy(uint8_t route_id)
     return ESP_ERR_NOT_FOUND;
 }
 
-int route_get_all(route_t *out, int max_count)
+esp_err_t route_set_destinations(uint8_t route_id, const uint8_t *dst_port_ids, uint8_t dst_count)
 {
+    if (dst_count == 0 || dst_count > ROUTE_MAX_DEST) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < dst_count; i++) {
+        if (!port_registry_get(dst_port_ids[i])) {
+            ESP_LOGE(TAG, "Destination port %d not found", dst_port_ids[i]);
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+
     xSemaphoreTake(route_mutex, portMAX_DELAY);
-    int count = 0;
-    for (int i = 0; i < ROUTE_MAX_COUNT && count < max_count; i++) {
-        if (routes[i].active || routes[i].task_count > 0) out[count++] = routes[i];
+    route_t *r = NULL;
+    for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
+        if (routes[i].active && routes[i].id == route_id) {
+            r = &routes[i];
+            break;
+        }
+    }
+    if (!r) {
+        xSemaphoreGive(route_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (r->type == ROUTE_TYPE_MERGE && dst_count > 1) {
+        xSemaphoreGive(route_mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The reverse direction of a bridge reads from its destination.
+    bool restart = r->type == ROUTE_TYPE_BRIDGE && r->task_count > 0;
+    if (restart) {
+        xSemaphoreGive(route_mutex);
+        route_stop(route_id);
+        xSemaphoreTake(route_mutex, portMAX_DELAY);
+        if (r->id != route_id || r->active || r->task_count > 0) {
+            xSemaphoreGive(route_mutex);    // slot taken by route_create() meanwhile
+            return ESP_ERR_INVALID_STATE;
+        }
+        r->active = true;
+    } else if (r->task_count > 0) {
+        for (int i = 0; i < dst_count; i++) {
+            port_t *dst = port_registry_get(dst_port_ids[i]);
+            if (dst->state == PORT_STATE_DISABLED && dst->ops.open) dst->ops.open(dst);
+        }
     }
+
+    memcpy(r->dst_port_ids, dst_port_ids, dst_count);
+    r->dst_count = dst_count;
+    route_table_publish();
+    if (r->task_handles[0]) xTaskNotifyGive(r->task_handles[0]);
     xSemaphoreGive(route_mutex);
+    dispatch_kick();
+
+    ESP_LOGI(TAG, "Route %d: %d destination(s)", route_id, dst_count);
+    return restart ? route_start(route_id) : ESP_OK;
+}
+
+int route_get_all(route_t *out, int max_count)
+{
+    const route_table_t *t = route_table_acquire();
+    int count = t->count < max_count ? t->count : max_count;
+    memcpy(out, t->routes, count * sizeof(route_t));
+    route_table_release(t);
+    return count;
+}
+
+esp_err_t route_get(uint8_t route_id, route_t *out)
+{
+    const route_table_t *t = route_table_acquire();
+    const route_t *r = route_table_find(t, route_id);
+    if (r) *out = *r;
+    route_table_release(t);
+    return r ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+int route_active_count(void)
+{
+    const route_table_t *t = route_table_acquire();
+    int count = 0;
+    for (int i = 0; i < t->count; i++) {
+        if (t->routes[i].active && t->routes[i].task_count > 0) count++;
+    }
+    route_table_release(t);
     return count;
 }
 
-route_t *route_get(uint8_t route_id)
+esp_err_t route_get_stats(uint8_t route_id, route_stats_t *out)
 {
     xSemaphoreTake(route_mutex, portMAX_DELAY);
     for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
         if (routes[i].active && routes[i].id == route_id) {
+            seqcount_read(&route_rt[i].stats_seq[0], &out->src_to_dst,
+                          &route_rt[i].stats[0], sizeof(out->src_to_dst));
+            seqcount_read(&route_rt[i].stats_seq[1], &out->dst_to_src,
+                          &route_rt[i].stats[1], sizeof(out->dst_to_src));
             xSemaphoreGive(route_mutex);
-            return &routes[i];
+            return ESP_OK;
         }
     }
     xSemaphoreGive(route_mutex);
-    return NULL;
+    return ESP_ERR_NOT_FOUND;
 }
 
-int route_active_count(void)
+esp_err_t route_get_latency(uint8_t route_id, latency_summary_t *src_to_dst,
+                            latency_summary_t *dst_to_src)
 {
     xSemaphoreTake(route_mutex, portMAX_DELAY);
-    int count = 0;
     for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
-        if (routes[i].active && routes[i].task_count > 0) count++;
+        if (routes[i].active && routes[i].id == route_id) {
+            latency_hist_summary(&route_rt[i].latency[0], src_to_dst);
+            latency_hist_summary(&route_rt[i].latency[1], dst_to_src);
+            xSemaphoreGive(route_mutex);
+            return ESP_OK;
+        }
     }
     xSemaphoreGive(route_mutex);
-    return count;
+    return ESP_ERR_NOT_FOUND;
 }
 
-void route_reset_counters(uint8_t route_id)
+esp_err_t route_get_merge_stats(uint8_t route_id, route_merge_stats_t *out, int *count)
 {
     xSemaphoreTake(route_mutex, portMAX_DELAY);
     for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
         if (routes[i].active && routes[i].id == route_id) {
-            routes[i].bytes_fwd_src_to_dst = 0;
-            routes[i].bytes_fwd_dst_to_src = 0;
-            break;
+            *count = routes[i].type == ROUTE_TYPE_MERGE ? 1 + routes[i].merge_src_count : 0;
+            seqcount_read(&route_rt[i].merge_seq, out, route_rt[i].merge_stats,
+                          sizeof(route_rt[i].merge_stats));
+            xSemaphoreGive(route_mutex);
+            return ESP_OK;
+        }
+    }
+    xSemaphoreGive(route_mutex);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t route_get_elastic_stats(uint8_t route_id, elastic_stats_t *out, int *count)
+{
+    xSemaphoreTake(route_mutex, portMAX_DELAY);
+    for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
+        if (routes[i].active && routes[i].id == route_id) {
+            const route_t *r = &routes[i];
+            int n = 0;
+            if (r->elastic_bytes) {
+                for (int d = 0; d < r->dst_count; d++) {
+                    elastic_buf_stats(&route_rt[i].elastic[d], &out[n++]);
+                }
+                if (r->type == ROUTE_TYPE_BRIDGE && r->dst_count > 0) {
+                    elastic_buf_stats(&route_rt[i].elastic[ROUTE_MAX_DEST], &out[n++]);
+                }
+            }
+            *count = n;
+            xSemaphoreGive(route_mutex);
+            return ESP_OK;
+        }
+    }
+    xSemaphoreGive(route_mutex);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t route_reset_latency(uint8_t route_id)
+{
+    xSemaphoreTake(route_mutex, portMAX_DELAY);
+    for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
+        if (routes[i].active && routes[i].id == route_id) {
+            latency_hist_reset(&route_rt[i].latency[0]);
+            latency_hist_reset(&route_rt[i].latency[1]);
+            xSemaphoreGive(route_mutex);
+            return ESP_OK;
         }
     }
     xSemaphoreGive(route_mutex);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t route_set_affinity(route_affinity_t policy)
+{
+    if (policy != ROUTE_AFFINITY_NONE && policy != ROUTE_AFFINITY_AUTO) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    affinity_policy = policy;
+    ESP_LOGI(TAG, "Core affinity policy: %s", policy == ROUTE_AFFINITY_AUTO ? "auto" : "none");
+    return ESP_OK;
+}
+
+route_affinity_t route_get_affinity(void)
+{
+    return affinity_policy;
+}
+
+// Rates are measured over the window since the previous sample, which is
+// taken at most every DP_RATE_WINDOW_US.
+#define DP_RATE_WINDOW_US   500000
+
+static void dp_sample_rates(route_engine_stats_t *out)
+{
+    static int64_t  last_us;
+    static uint32_t last_total, last_cross;
+    static uint32_t notify_per_s, cross_per_s;
+    static int8_t   cpu_load[portNUM_PROCESSORS] = { [0 ... portNUM_PROCESSORS - 1] = -1 };
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    static uint32_t last_idle[portNUM_PROCESSORS];
+#endif
+
+    int64_t now = esp_timer_get_time();
+    int64_t dt  = now - last_us;
+    if (dt >= DP_RATE_WINDOW_US) {
+        uint32_t total, cross;
+        dp_notify_get_counts(&total, &cross);
+        if (last_us) {
+            notify_per_s = (uint32_t)((uint64_t)(total - last_total) * 1000000 / dt);
+            cross_per_s  = (uint32_t)((uint64_t)(cross - last_cross) * 1000000 / dt);
+        }
+        last_total = total;
+        last_cross = cross;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        // Run-time counter ticks in microseconds (esp_timer clock).
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            uint32_t idle = ulTaskGetIdleRunTimeCounterForCore(c);
+            if (last_us) {
+                int64_t busy = 100 - (int64_t)(idle - last_idle[c]) * 100 / dt;
+                cpu_load[c] = busy < 0 ? 0 : busy > 100 ? 100 : busy;
+            }
+            last_idle[c] = idle;
+        }
+#endif
+        last_us = now;
+    }
+
+    out->notify_per_s     = notify_per_s;
+    out->cross_core_per_s = cross_per_s;
+    memcpy(out->cpu_load, cpu_load, sizeof(out->cpu_load));
+}
+
+void route_engine_get_stats(route_engine_stats_t *out)
+{
+#ifdef CONFIG_VUART_ROUTE_DISPATCHER
+    out->dispatcher  = true;
+    out->stack_bytes = dp_task_count * DISPATCH_STACK_SIZE;
+#else
+    out->dispatcher  = false;
+    out->stack_bytes = dp_task_count * FORWARD_STACK_SIZE;
+#endif
+    out->tasks    = dp_task_count;
+    out->wakeups  = dp_wakeups;
+    out->affinity = affinity_policy;
+    dp_sample_rates(out);
 }
@@ -1,102 +1,194 @@
 #include "signal_router.h"
 #include "port_registry.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <string.h>
 
 static const char *TAG = "sig_router";
 
-#define SIGNAL_POLL_INTERVAL_MS  10
-
 static TaskHandle_t signal_task_handle = NULL;
 static volatile bool signal_task_running = false;
-
-static void apply_signal_mappings(route_t *r)
+static latency_hist_t signal_latency;   // this task is the only writer
+
+// ---------------------------------------------------------------------------
+// Compiled mappings
+//
+// When the route table changes, each route's signal_map is compiled into
+// one program per direction: the resolved ports, with their registry
+// generations, and a lookup table from the source's 6 signal bits to the
+// destination bits the mapping drives.  Applying a program is one lookup
+// and one set_signals() per destination, and nothing at all while the
+// mapped source bits are unchanged and no destination has changed.
+// ---------------------------------------------------------------------------
+
+#define SIGNAL_BITS     6
+#define SIGNAL_LUT_SIZE (1 << SIGNAL_BITS)
+
+typedef struct {
+    uint8_t     src_id;
+    port_t     *src;
+    uint32_t    src_gen;
+    uint8_t     dst_ids[ROUTE_MAX_DEST];
+    port_t     *dst[ROUTE_MAX_DEST];
+    uint32_t    dst_gen[ROUTE_MAX_DEST];
+    int         dst_count;
+    uint32_t    src_mask;       // port id bits, to match change events
+    uint32_t    dst_mask;
+    uint8_t     in_mask;        // source bits the mapping reads
+    uint8_t     out_mask;       // destination bits it drives
+    int16_t     last_in;        // masked input last applied, -1 to force
+    uint8_t     lut[SIGNAL_LUT_SIZE];   // masked input -> driven bits that are set
+} signal_prog_t;
+
+static signal_prog_t progs[ROUTE_MAX_COUNT * 2];    // bridges have two directions
+static int prog_count;
+static signal_router_stats_t router_stats;          // this task is the only writer
+static signal_listener_t signal_listener;
+
+static void prog_resolve(signal_prog_t *p)
 {
-    if (r->signal_map_count == 0) return;
-
-    port_t *src = port_registry_get(r->src_port_id);
-    if (!src) return;
+    p->src = port_registry_lookup(p->src_id, &p->src_gen);
+    for (int d = 0; d < p->dst_count; d++) {
+        p->dst[d] = port_registry_lookup(p->dst_ids[d], &p->dst_gen[d]);
+    }
+    p->last_in = -1;
+}
 
-    uint32_t src_signals = 0;
-    if (src->ops.get_signals) {
-        src->ops.get_signals(src, &src_signals);
+static bool prog_valid(const signal_prog_t *p)
+{
+    if (!port_registry_valid(p->src_id, p->src_gen)) return false;
+    for (int d = 0; d < p->dst_count; d++) {
+        if (!port_registry_valid(p->dst_ids[d], p->dst_gen[d])) return false;
     }
+    return true;
+}
 
-    // For each destination, compute mapped signals and apply
-    for (int d = 0; d < r->dst_count; d++) {
-        port_t *dst = port_registry_get(r->dst_port_ids[d]);
-        if (!dst || !dst->ops.set_signals) continue;
+// Compile one direction.  Mappings apply in order, so a later one driving
+// the same bit wins, as when they were interpreted one by one.
+static void prog_compile(signal_prog_t *p, const route_t *r, bool reverse)
+{
+    memset(p, 0, sizeof(*p));
+    p->src_id = reverse ? r->dst_port_ids[0] : r->src_port_id;
+    p->dst_count = reverse ? 1 : r->dst_count;
+    for (int d = 0; d < p->dst_count; d++) {
+        p->dst_ids[d] = reverse ? r->src_port_id : r->dst_port_ids[d];
+    }
 
-        uint32_t dst_signals = 0;
-        // Read current destination signals to preserve unmapped ones
-        if (dst->ops.get_signals) {
-            dst->ops.get_signals(dst, &dst_signals);
-        }
+    p->src_mask = p->src_id < PORT_MAX_COUNT ? 1u << p->src_id : 0;
+    for (int d = 0; d < p->dst_count; d++) {
+        if (p->dst_ids[d] < PORT_MAX_COUNT) p->dst_mask |= 1u << p->dst_ids[d];
+    }
 
+    for (int m = 0; m < r->signal_map_count; m++) {
+        uint8_t from = reverse ? r->signal_map[m].to_signal : r->signal_map[m].from_signal;
+        uint8_t to   = reverse ? r->signal_map[m].from_signal : r->signal_map[m].to_signal;
+        p->in_mask  |= from & (SIGNAL_LUT_SIZE - 1);
+        p->out_mask |= to;
+    }
+    for (int in = 0; in < SIGNAL_LUT_SIZE; in++) {
+        uint8_t out = 0;
         for (int m = 0; m < r->signal_map_count; m++) {
-            uint8_t from = r->signal_map[m].from_signal;
-            uint8_t to = r->signal_map[m].to_signal;
-
-            if (src_signals & from) {
-                dst_signals |= to;
+            uint8_t from = reverse ? r->signal_map[m].to_signal : r->signal_map[m].from_signal;
+            uint8_t to   = reverse ? r->signal_map[m].from_signal : r->signal_map[m].to_signal;
+            if (in & from) {
+                out |= to;
             } else {
-                dst_signals &= ~to;
+                out &= ~to;
             }
         }
-
-        dst->ops.set_signals(dst, dst_signals);
+        p->lut[in] = out;
     }
+    prog_resolve(p);
+}
 
-    // For bridge routes: also map in reverse direction
-    if (r->type == ROUTE_TYPE_BRIDGE && r->dst_count > 0) {
-        port_t *dst0 = port_registry_get(r->dst_port_ids[0]);
-        if (!dst0) return;
-
-        uint32_t dst_signals = 0;
-        if (dst0->ops.get_signals) {
-            dst0->ops.get_signals(dst0, &dst_signals);
-        }
-
-        uint32_t rev_signals = 0;
-        if (src->ops.get_signals) {
-            src->ops.get_signals(src, &rev_signals);
-        }
+static void progs_compile(const route_table_t *t)
+{
+    prog_count = 0;
+    for (int i = 0; i < t->count; i++) {
+        const route_t *r = &t->routes[i];
+        if (!r->active || r->signal_map_count == 0 || r->dst_count == 0) continue;
+        prog_compile(&progs[prog_count++], r, false);
+        if (r->type == ROUTE_TYPE_BRIDGE) prog_compile(&progs[prog_count++], r, true);
+    }
+    router_stats.compiled++;
+}
 
-        for (int m = 0; m < r->signal_map_count; m++) {
-            // Reverse the mapping for bridge: to -> from
-            uint8_t from = r->signal_map[m].to_signal;
-            uint8_t to = r->signal_map[m].from_signal;
+// Returns the port id bits of the destinations driven.
+static uint32_t prog_apply(signal_prog_t *p)
+{
+    if (!prog_valid(p)) prog_resolve(p);
+    if (!p->src) return 0;
 
-            if (dst_signals & from) {
-                rev_signals |= to;
-            } else {
-                rev_signals &= ~to;
-            }
-        }
+    int in = port_get_effective_signals(p->src) & p->in_mask;
+    if (in == p->last_in) {
+        router_stats.skipped++;
+        return 0;
+    }
+    p->last_in = in;
 
-        src->ops.set_signals(src, rev_signals);
+    uint32_t set = p->lut[in];
+    for (int d = 0; d < p->dst_count; d++) {
+        port_t *dst = p->dst[d];
+        if (!dst || !dst->ops.set_signals) continue;
+        uint32_t cur = port_get_effective_signals(dst);
+        dst->ops.set_signals(dst, (cur & ~p->out_mask) | set);
     }
+    router_stats.applied++;
+    return p->dst_mask;
 }
 
 static void signal_router_task(void *arg)
 {
-    ESP_LOGI(TAG, "Signal router started (poll every %d ms)", SIGNAL_POLL_INTERVAL_MS);
+    ESP_LOGI(TAG, "Signal router started (event-driven)");
+
+    uint32_t version = 0;
+    int64_t stamps[PORT_MAX_COUNT];
+    port_signal_subscribe(xTaskGetCurrentTaskHandle());
 
     while (signal_task_running) {
-        // Get all active routes
-        route_t all_routes[ROUTE_MAX_COUNT];
-        int count = route_get_all(all_routes, ROUTE_MAX_COUNT);
+        uint32_t changed = port_signal_take(stamps);
+        uint32_t v = route_table_version();
+        if (v != version) {
+            version = v;
+            const route_table_t *t = route_table_acquire();
+            progs_compile(t);
+            route_table_release(t);
+        }
 
-        for (int i = 0; i < count; i++) {
-            if (all_routes[i].active && all_routes[i].signal_map_count > 0) {
-                apply_signal_mappings(&all_routes[i]);
+        // Let drivers refresh sampled inputs (UART GPIOs) in task context.
+        for (int i = 0; i < PORT_MAX_COUNT; i++) {
+            if (!(changed & (1u << i))) continue;
+            port_t *port = port_registry_get(i);
+            uint32_t sigs;
+            if (port && port->ops.get_signals) port->ops.get_signals(port, &sigs);
+        }
+
+        // A change on a destination (reconnect, override) may have undone
+        // what the program drove, so it is re-driven even if its input
+        // is unchanged.
+        uint32_t driven = 0;
+        for (int i = 0; i < prog_count; i++) {
+            signal_prog_t *p = &progs[i];
+            if (changed & p->dst_mask) p->last_in = -1;
+            if (p->last_in < 0 || (changed & p->src_mask)) driven |= prog_apply(p);
+        }
+
+        signal_listener_t listener = signal_listener;
+        if (listener && (changed | driven)) listener(changed | driven);
+
+        if (changed) {
+            int64_t now = esp_timer_get_time();
+            for (int i = 0; i < PORT_MAX_COUNT; i++) {
+                if (changed & (1u << i)) latency_hist_record(&signal_latency, (uint32_t)(now - stamps[i]));
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(SIGNAL_POLL_INTERVAL_MS));
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 
+    port_signal_subscribe(NULL);
     ESP_LOGI(TAG, "Signal router stopped");
     vTaskDelete(NULL);
 }
@@ -109,7 +201,7 @@ esp_err_t signal_router_init(void)
     }
 
     signal_task_running = true;
-    BaseType_t ret = xTaskCreate(signal_router_task, "sig_router", 3072, NULL, 4, &signal_task_handle);
+    BaseType_t ret = xTaskCreate(signal_router_task, "sig_router", 3072, NULL, 6, &signal_task_handle);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create signal router task");
         signal_task_running = false;
@@ -124,7 +216,36 @@ void signal_router_stop(void)
     if (!signal_task_handle) return;
 
     signal_task_running = false;
-    vTaskDelay(pdMS_TO_TICKS(SIGNAL_POLL_INTERVAL_MS * 3));
+    xTaskNotifyGive(signal_task_handle);
+    vTaskDelay(pdMS_TO_TICKS(30));
     signal_task_handle = NULL;
     ESP_LOGI(TAG, "Signal router stopped");
 }
+
+void signal_router_kick(void)
+{
+    TaskHandle_t task = signal_task_handle;
+    if (task) xTaskNotifyGive(task);
+}
+
+void signal_router_get_latency(latency_summary_t *out)
+{
+    latency_hist_summary(&signal_latency, out);
+}
+
+void signal_router_reset_latency(void)
+{
+    latency_hist_reset(&signal_latency);
+}
+
+void signal_router_get_stats(signal_router_stats_t *out)
+{
+    out->applied  = __atomic_load_n(&router_stats.applied, __ATOMIC_RELAXED);
+    out->skipped  = __atomic_load_n(&router_stats.skipped, __ATOMIC_RELAXED);
+    out->compiled = __atomic_load_n(&router_stats.compiled, __ATOMIC_RELAXED);
+}
+
+void signal_router_set_listener(signal_listener_t cb)
+{
+    signal_listener = cb;
+}
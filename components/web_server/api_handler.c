@@ -1,13 +1,19 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
-#include "cJSON.h"
 #include "port.h"
 #include "port_registry.h"
+#include "buf_pool.h"
 #include "route.h"
+#include "signal_router.h"
 #include "config_store.h"
 #include "wifi_mgr.h"
+#include "web_server.h"
+#include "json_writer.h"
+#include "json_parser.h"
 #include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 
 static const char *TAG = "api_handler";
 
@@ -28,6 +34,25 @@ static void persist_routes(void)
         sys_config.routes[i].signal_map_count = active[i].signal_map_count;
         memcpy(sys_config.routes[i].signal_map, active[i].signal_map,
                sizeof(active[i].signal_map));
+        sys_config.routes[i].flow            = active[i].flow;
+        sys_config.routes[i].coalesce_bytes  = active[i].coalesce_bytes;
+        sys_config.routes[i].coalesce_us     = active[i].coalesce_us;
+        memcpy(sys_config.routes[i].merge_src_ids, active[i].merge_src_ids,
+               sizeof(active[i].merge_src_ids));
+        sys_config.routes[i].merge_src_count = active[i].merge_src_count;
+        sys_config.routes[i].arbitration     = active[i].arbitration;
+        sys_config.routes[i].arb_delimiter   = active[i].arb_delimiter;
+        sys_config.routes[i].arb_idle_us     = active[i].arb_idle_us;
+        memcpy(sys_config.routes[i].merge_weights, active[i].merge_weights,
+               sizeof(active[i].merge_weights));
+        sys_config.routes[i].framing         = active[i].framing;
+        memcpy(sys_config.routes[i].frame_delim, active[i].frame_delim,
+               sizeof(active[i].frame_delim));
+        sys_config.routes[i].frame_delim_len = active[i].frame_delim_len;
+        sys_config.routes[i].frame_len       = active[i].frame_len;
+        sys_config.routes[i].frame_gap       = active[i].frame_gap;
+        sys_config.routes[i].elastic_bytes   = active[i].elastic_bytes;
+        sys_config.routes[i].elastic_overflow = active[i].elastic_overflow;
         sys_config.route_count++;
     }
     config_store_save(&sys_config);
@@ -45,109 +70,364 @@ static void deferred_wifi_switch_cb(void *arg)
         strlen(deferred_pass) > 0 ? deferred_pass : NULL);
 }
 
-// Helper: send JSON response
-static esp_err_t send_json(httpd_req_t *req, cJSON *json)
-{
-    char *str = cJSON_PrintUnformatted(json);
-    if (!str) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON format error");
-        return ESP_FAIL;
-    }
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-    esp_err_t ret = httpd_resp_sendstr(req, str);
-    free(str);
-    return ret;
-}
+// Request bodies are read into one buffer and tokenized in place.  The
+// server runs its handlers one at a time on its own task, so they share it.
+// The largest valid documents, a route with every option and eight signal
+// mappings or a config with escaped strings, pretty-printed, need up to 4 KB
+// and about 100 tokens.
+#define API_BODY_MAX        4096
+#define API_BODY_TOKENS     128
+
+static char       body_buf[API_BODY_MAX];
+static json_tok_t body_toks[API_BODY_TOKENS];
 
-// Helper: read request body
-static char *read_body(httpd_req_t *req)
+// Helper: read the request body and bind it to schema.  On false the
+// error response has been sent.
+static bool bind_body(httpd_req_t *req, const json_field_t *schema, void *out)
 {
     int total_len = req->content_len;
-    if (total_len <= 0 || total_len > 4096) {
-        return NULL;
+    if (total_len <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing body");
+        return false;
+    }
+    if (total_len > API_BODY_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body too large");
+        return false;
     }
-
-    char *buf = malloc(total_len + 1);
-    if (!buf) return NULL;
 
     int received = 0;
     while (received < total_len) {
-        int ret = httpd_req_recv(req, buf + received, total_len - received);
+        int ret = httpd_req_recv(req, body_buf + received, total_len - received);
         if (ret <= 0) {
-            free(buf);
-            return NULL;
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing body");
+            return false;
         }
         received += ret;
     }
-    buf[total_len] = '\0';
-    return buf;
+
+    int count = json_parse(body_buf, total_len, body_toks, API_BODY_TOKENS);
+    if (count < 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return false;
+    }
+
+    const char *bad;
+    if (json_bind(body_buf, body_toks, count, schema, out, &bad) != ESP_OK) {
+        char msg[48];
+        snprintf(msg, sizeof(msg), "Invalid %s", bad ? bad : "request");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+        return false;
+    }
+    return true;
 }
 
+// PUT /api/ports/<id>/config
+typedef struct {
+    port_line_coding_t coding;
+    uint32_t           override_mask;
+    uint32_t           override_val;
+    bool               overrides;
+} port_config_body_t;
+
+static const json_field_t line_coding_fields[] = {
+    JSON_FIELD_NUM("baudRate", JSON_U32, port_config_body_t, coding.baud_rate, 1, UINT32_MAX),
+    JSON_FIELD_NUM("dataBits", JSON_U8,  port_config_body_t, coding.data_bits, 5, 8),
+    JSON_FIELD_NUM("stopBits", JSON_U8,  port_config_body_t, coding.stop_bits, 0, 2),
+    JSON_FIELD_NUM("parity",   JSON_U8,  port_config_body_t, coding.parity, 0, 4),
+    JSON_FIELD_BOOL("flowControl", port_config_body_t, coding.flow_control),
+    { NULL }
+};
+
+static const json_field_t signal_override_fields[] = {
+    JSON_FIELD_NUM("mask",   JSON_U32, port_config_body_t, override_mask, 0, UINT32_MAX),
+    JSON_FIELD_NUM("values", JSON_U32, port_config_body_t, override_val, 0, UINT32_MAX),
+    { NULL }
+};
+
+static const json_field_t port_config_fields[] = {
+    JSON_FIELD_OBJECT("lineCoding", line_coding_fields),
+    JSON_FIELD_OBJECT("signalOverrides", signal_override_fields,
+                      JSON_SEEN(port_config_body_t, overrides)),
+    { NULL }
+};
+
+// PUT /api/routes.  "sources" is bound aside and split into src_port_id
+// and merge_src_ids afterwards.
+typedef struct {
+    route_t r;
+    uint8_t sources[ROUTE_MERGE_MAX_SRC];
+    uint8_t source_count;
+    uint8_t weight_count;
+    bool    arb_seen;
+    bool    arb_delim_seen;
+} route_body_t;
+
+static const json_field_t coalesce_fields[] = {
+    JSON_FIELD_NUM("bytes", JSON_U16, route_body_t, r.coalesce_bytes, 0, UINT16_MAX, JSON_CLAMPED),
+    JSON_FIELD_NUM("us",    JSON_U32, route_body_t, r.coalesce_us, 0, UINT32_MAX, JSON_CLAMPED),
+    { NULL }
+};
+
+static const json_field_t framing_fields[] = {
+    JSON_FIELD_NUM("mode",   JSON_ENUM, route_body_t, r.framing, ROUTE_FRAME_NONE, ROUTE_FRAME_IDLE),
+    JSON_FIELD_BYTES("delimiter", route_body_t, r.frame_delim, r.frame_delim_len),
+    JSON_FIELD_NUM("length", JSON_U16, route_body_t, r.frame_len, 0, UINT16_MAX, JSON_CLAMPED),
+    JSON_FIELD_NUM("gap",    JSON_U16, route_body_t, r.frame_gap, 0, UINT16_MAX, JSON_CLAMPED),
+    { NULL }
+};
+
+static const json_field_t elastic_fields[] = {
+    JSON_FIELD_NUM("bytes",    JSON_U32,  route_body_t, r.elastic_bytes, 0, UINT32_MAX, JSON_CLAMPED),
+    JSON_FIELD_NUM("overflow", JSON_ENUM, route_body_t, r.elastic_overflow,
+                   ROUTE_OVERFLOW_DROP_NEW, ROUTE_OVERFLOW_DROP_OLD),
+    { NULL }
+};
+
+static const json_field_t arbitration_fields[] = {
+    JSON_FIELD_NUM("mode",      JSON_ENUM, route_body_t, r.arbitration, ROUTE_ARB_BYTE, ROUTE_ARB_IDLE_GAP),
+    JSON_FIELD_NUM("delimiter", JSON_U8,   route_body_t, r.arb_delimiter, 0, UINT8_MAX,
+                   JSON_SEEN(route_body_t, arb_delim_seen)),
+    JSON_FIELD_NUM("idleUs",    JSON_U32,  route_body_t, r.arb_idle_us, 0, UINT32_MAX, JSON_CLAMPED),
+    JSON_FIELD_ARRAY("weights", route_body_t, r.merge_weights, weight_count, 1, UINT8_MAX, JSON_CLAMPED),
+    { NULL }
+};
+
+static const json_field_t signal_map_fields[] = {
+    JSON_FIELD_NUM("fromSignal", JSON_U8, signal_mapping_t, from_signal, 0, UINT8_MAX, JSON_REQUIRED),
+    JSON_FIELD_NUM("toSignal",   JSON_U8, signal_mapping_t, to_signal, 0, UINT8_MAX, JSON_REQUIRED),
+    { NULL }
+};
+
+static const json_field_t route_fields[] = {
+    JSON_FIELD_NUM("type",      JSON_ENUM, route_body_t, r.type, ROUTE_TYPE_BRIDGE, ROUTE_TYPE_MERGE),
+    JSON_FIELD_NUM("srcPortId", JSON_U8,   route_body_t, r.src_port_id, 0, PORT_MAX_COUNT - 1),
+    JSON_FIELD_NUM("flow",      JSON_ENUM, route_body_t, r.flow, ROUTE_FLOW_DROP, ROUTE_FLOW_LOSSLESS),
+    JSON_FIELD_OBJECT("coalesce", coalesce_fields),
+    JSON_FIELD_OBJECT("framing", framing_fields),
+    JSON_FIELD_OBJECT("elastic", elastic_fields),
+    JSON_FIELD_ARRAY("dstPortIds", route_body_t, r.dst_port_ids, r.dst_count, 0, PORT_MAX_COUNT - 1),
+    JSON_FIELD_ARRAY("sources", route_body_t, sources, source_count, 0, PORT_MAX_COUNT - 1),
+    JSON_FIELD_OBJECT("arbitration", arbitration_fields, JSON_SEEN(route_body_t, arb_seen)),
+    JSON_FIELD_OBJECTS("signalMap", route_body_t, r.signal_map, r.signal_map_count, signal_map_fields),
+    { NULL }
+};
+
+// PUT /api/routes/<id>
+typedef struct {
+    uint8_t ids[ROUTE_MAX_DEST];
+    uint8_t count;
+} route_dst_body_t;
+
+static const json_field_t route_dst_fields[] = {
+    JSON_FIELD_ARRAY("dstPortIds", route_dst_body_t, ids, count, 0, PORT_MAX_COUNT - 1, JSON_REQUIRED),
+    { NULL }
+};
+
+// PUT /api/config.  tcp starts as the stored configs, so an element may
+// give only some of its members.
+typedef struct {
+    char                 ssid[CONFIG_WIFI_SSID_MAX];
+    char                 pass[CONFIG_WIFI_PASS_MAX];
+    bool                 ssid_seen;
+    bool                 pass_seen;
+    tcp_persist_config_t tcp[4];
+    uint8_t              tcp_count;
+    char                 affinity[8];
+    bool                 affinity_seen;
+} config_body_t;
+
+static const json_field_t wifi_fields[] = {
+    JSON_FIELD_STR("ssid",     config_body_t, ssid, JSON_SEEN(config_body_t, ssid_seen)),
+    JSON_FIELD_STR("password", config_body_t, pass, JSON_SEEN(config_body_t, pass_seen)),
+    { NULL }
+};
+
+static const json_field_t tcp_fields[] = {
+    JSON_FIELD_STR("host", tcp_persist_config_t, host),
+    JSON_FIELD_NUM("port", JSON_U16, tcp_persist_config_t, port, 0, UINT16_MAX),
+    JSON_FIELD_BOOL("isServer", tcp_persist_config_t, is_server),
+    { NULL }
+};
+
+static const json_field_t config_fields[] = {
+    JSON_FIELD_OBJECT("wifi", wifi_fields),
+    JSON_FIELD_OBJECTS("tcpConfigs", config_body_t, tcp, tcp_count, tcp_fields),
+    JSON_FIELD_STR("routeAffinity", config_body_t, affinity, JSON_SEEN(config_body_t, affinity_seen)),
+    { NULL }
+};
+
 // Helper: serialize port to JSON
-static cJSON *port_to_json(port_t *port)
+static void port_to_json(json_writer_t *w, const char *key, port_t *port)
 {
-    cJSON *obj = cJSON_CreateObject();
-    cJSON_AddNumberToObject(obj, "id", port->id);
-    cJSON_AddStringToObject(obj, "name", port->name);
-    cJSON_AddNumberToObject(obj, "type", port->type);
-    cJSON_AddNumberToObject(obj, "state", port->state);
+    json_obj_open(w, key);
+    json_uint(w, "id", port->id);
+    json_str(w, "name", port->name);
+    json_uint(w, "type", port->type);
+    json_uint(w, "state", port->state);
+
+    // Traffic counters (monotonic since boot)
+    port_stats_t ps;
+    port_get_stats(port, &ps);
+    json_obj_open(w, "stats");
+    json_uint(w, "rxBytes", ps.rx.bytes);
+    json_uint(w, "rxChunks", ps.rx.chunks);
+    json_uint(w, "rxDropped", ps.rx.dropped);
+    json_uint(w, "rxOverflows", ps.rx.overflows);
+    json_uint(w, "txQueued", ps.tx.queued);
+    json_uint(w, "txRefused", ps.tx.refused);
+    json_uint(w, "txDiscarded", ps.tx.discarded);
+    json_uint(w, "txPending", port_tx_pending(port));
+    json_uint(w, "txBytes", ps.tx.bytes);
+    json_uint(w, "txWrites", ps.tx.writes);
+    json_uint(w, "txShortWrites", ps.tx.short_writes);
+    json_obj_close(w);
 
     // Line coding
-    cJSON *lc = cJSON_CreateObject();
-    cJSON_AddNumberToObject(lc, "baudRate", port->line_coding.baud_rate);
-    cJSON_AddNumberToObject(lc, "dataBits", port->line_coding.data_bits);
-    cJSON_AddNumberToObject(lc, "stopBits", port->line_coding.stop_bits);
-    cJSON_AddNumberToObject(lc, "parity", port->line_coding.parity);
-    cJSON_AddBoolToObject(lc, "flowControl", port->line_coding.flow_control);
-    cJSON_AddItemToObject(obj, "lineCoding", lc);
+    json_obj_open(w, "lineCoding");
+    json_uint(w, "baudRate", port->line_coding.baud_rate);
+    json_uint(w, "dataBits", port->line_coding.data_bits);
+    json_uint(w, "stopBits", port->line_coding.stop_bits);
+    json_uint(w, "parity", port->line_coding.parity);
+    json_bool(w, "flowControl", port->line_coding.flow_control);
+    json_obj_close(w);
 
     // Signals
     uint32_t sigs = port_get_effective_signals(port);
-    cJSON *signals = cJSON_CreateObject();
-    cJSON_AddBoolToObject(signals, "dtr", (sigs & SIGNAL_DTR) != 0);
-    cJSON_AddBoolToObject(signals, "rts", (sigs & SIGNAL_RTS) != 0);
-    cJSON_AddBoolToObject(signals, "cts", (sigs & SIGNAL_CTS) != 0);
-    cJSON_AddBoolToObject(signals, "dsr", (sigs & SIGNAL_DSR) != 0);
-    cJSON_AddBoolToObject(signals, "dcd", (sigs & SIGNAL_DCD) != 0);
-    cJSON_AddBoolToObject(signals, "ri",  (sigs & SIGNAL_RI)  != 0);
-    cJSON_AddItemToObject(obj, "signals", signals);
-
-    return obj;
+    json_obj_open(w, "signals");
+    json_bool(w, "dtr", (sigs & SIGNAL_DTR) != 0);
+    json_bool(w, "rts", (sigs & SIGNAL_RTS) != 0);
+    json_bool(w, "cts", (sigs & SIGNAL_CTS) != 0);
+    json_bool(w, "dsr", (sigs & SIGNAL_DSR) != 0);
+    json_bool(w, "dcd", (sigs & SIGNAL_DCD) != 0);
+    json_bool(w, "ri",  (sigs & SIGNAL_RI)  != 0);
+    json_obj_close(w);
+
+    json_obj_close(w);
 }
 
 // Helper: serialize route to JSON
-static cJSON *route_to_json(route_t *route)
+static void route_to_json(json_writer_t *w, const char *key, route_t *route)
 {
-    cJSON *obj = cJSON_CreateObject();
-    cJSON_AddNumberToObject(obj, "id", route->id);
-    cJSON_AddNumberToObject(obj, "type", route->type);
-    cJSON_AddBoolToObject(obj, "active", route->active);
-    cJSON_AddNumberToObject(obj, "srcPortId", route->src_port_id);
+    json_obj_open(w, key);
+    json_uint(w, "id", route->id);
+    json_uint(w, "type", route->type);
+    json_bool(w, "active", route->active);
+    json_uint(w, "srcPortId", route->src_port_id);
+    json_uint(w, "flow", route->flow);
+
+    json_obj_open(w, "coalesce");
+    json_uint(w, "bytes", route->coalesce_bytes);
+    json_uint(w, "us", route->coalesce_us);
+    json_obj_close(w);
+
+    json_obj_open(w, "framing");
+    json_uint(w, "mode", route->framing);
+    json_arr_open(w, "delimiter");
+    for (int i = 0; i < route->frame_delim_len; i++) {
+        json_uint(w, NULL, route->frame_delim[i]);
+    }
+    json_arr_close(w);
+    json_uint(w, "length", route->frame_len);
+    json_uint(w, "gap", route->frame_gap);
+    json_obj_close(w);
+
+    json_obj_open(w, "elastic");
+    json_uint(w, "bytes", route->elastic_bytes);
+    json_uint(w, "overflow", route->elastic_overflow);
+    elastic_stats_t es[ROUTE_MAX_DEST + 1];
+    int ecount = 0;
+    if (route_get_elastic_stats(route->id, es, &ecount) == ESP_OK && ecount > 0) {
+        json_arr_open(w, "buffers");
+        for (int i = 0; i < ecount; i++) {
+            json_obj_open(w, NULL);
+            json_uint(w, "capacity", es[i].capacity);
+            json_uint(w, "fill", es[i].fill);
+            json_uint(w, "highWater", es[i].high_water);
+            json_uint(w, "overflow", es[i].overflow);
+            json_uint(w, "rate", es[i].rate);
+            json_obj_close(w);
+        }
+        json_arr_close(w);
+    }
+    json_obj_close(w);
 
-    cJSON *dsts = cJSON_CreateArray();
+    json_arr_open(w, "dstPortIds");
     for (int i = 0; i < route->dst_count; i++) {
-        cJSON_AddItemToArray(dsts, cJSON_CreateNumber(route->dst_port_ids[i]));
+        json_uint(w, NULL, route->dst_port_ids[i]);
+    }
+    json_arr_close(w);
+
+    // Merge: all sources in order, arbitration and per-source counters
+    if (route->type == ROUTE_TYPE_MERGE) {
+        json_arr_open(w, "sources");
+        json_uint(w, NULL, route->src_port_id);
+        for (int i = 0; i < route->merge_src_count; i++) {
+            json_uint(w, NULL, route->merge_src_ids[i]);
+        }
+        json_arr_close(w);
+
+        json_obj_open(w, "arbitration");
+        json_uint(w, "mode", route->arbitration);
+        json_uint(w, "delimiter", route->arb_delimiter);
+        json_uint(w, "idleUs", route->arb_idle_us);
+        json_arr_open(w, "weights");
+        for (int i = 0; i <= route->merge_src_count; i++) {
+            json_uint(w, NULL, route->merge_weights[i]);
+        }
+        json_arr_close(w);
+        json_obj_close(w);
+
+        route_merge_stats_t ms[ROUTE_MERGE_MAX_SRC];
+        int mcount = 0;
+        if (route_get_merge_stats(route->id, ms, &mcount) == ESP_OK) {
+            json_arr_open(w, "mergeStats");
+            for (int i = 0; i < mcount; i++) {
+                json_obj_open(w, NULL);
+                json_uint(w, "bytes", ms[i].bytes);
+                json_uint(w, "frames", ms[i].frames);
+                json_uint(w, "lost", ms[i].lost);
+                json_uint(w, "forced", ms[i].forced);
+                json_obj_close(w);
+            }
+            json_arr_close(w);
+        }
     }
-    cJSON_AddItemToObject(obj, "dstPortIds", dsts);
 
     // Signal mappings
     if (route->signal_map_count > 0) {
-        cJSON *maps = cJSON_CreateArray();
+        json_arr_open(w, "signalMap");
         for (int i = 0; i < route->signal_map_count; i++) {
-            cJSON *m = cJSON_CreateObject();
-            cJSON_AddNumberToObject(m, "fromSignal", route->signal_map[i].from_signal);
-            cJSON_AddNumberToObject(m, "toSignal", route->signal_map[i].to_signal);
-            cJSON_AddItemToArray(maps, m);
+            json_obj_open(w, NULL);
+            json_uint(w, "fromSignal", route->signal_map[i].from_signal);
+            json_uint(w, "toSignal", route->signal_map[i].to_signal);
+            json_obj_close(w);
         }
-        cJSON_AddItemToObject(obj, "signalMap", maps);
+        json_arr_close(w);
     }
 
-    // Stats
-    cJSON_AddNumberToObject(obj, "bytesSrcToDst", route->bytes_fwd_src_to_dst);
-    cJSON_AddNumberToObject(obj, "bytesDstToSrc", route->bytes_fwd_dst_to_src);
-
-    return obj;
+    // Stats (monotonic since the route was created)
+    route_stats_t st = {0};
+    route_get_stats(route->id, &st);
+    json_uint(w, "bytesSrcToDst", st.src_to_dst.bytes);
+    json_uint(w, "bytesDstToSrc", st.dst_to_src.bytes);
+    json_uint(w, "bytesLostSrcToDst", st.src_to_dst.lost);
+    json_uint(w, "bytesLostDstToSrc", st.dst_to_src.lost);
+    json_uint(w, "stallsSrcToDst", st.src_to_dst.stalls);
+    json_uint(w, "stallsDstToSrc", st.dst_to_src.stalls);
+    json_uint(w, "writesSrcToDst", st.src_to_dst.writes);
+    json_uint(w, "writesDstToSrc", st.dst_to_src.writes);
+    json_uint(w, "chunksSrcToDst", st.src_to_dst.chunks);
+    json_uint(w, "chunksDstToSrc", st.dst_to_src.chunks);
+    json_uint(w, "shortWritesSrcToDst", st.src_to_dst.short_writes);
+    json_uint(w, "shortWritesDstToSrc", st.dst_to_src.short_writes);
+    json_uint(w, "overrunsSrcToDst", st.src_to_dst.overruns);
+    json_uint(w, "overrunsDstToSrc", st.dst_to_src.overruns);
+    json_uint(w, "framesSrcToDst", st.src_to_dst.frames);
+    json_uint(w, "framesDstToSrc", st.dst_to_src.frames);
+    json_uint(w, "partialFramesSrcToDst", st.src_to_dst.partial_frames);
+    json_uint(w, "partialFramesDstToSrc", st.dst_to_src.partial_frames);
+
+    json_obj_close(w);
 }
 
 // GET /api/ports
@@ -156,16 +436,17 @@ esp_err_t api_get_ports_handler(httpd_req_t *req)
     port_t *ports[PORT_MAX_COUNT];
     int count = port_registry_get_all(ports, PORT_MAX_COUNT);
 
-    cJSON *arr = cJSON_CreateArray();
+    json_writer_t w;
+    json_begin(&w, req);
+    json_arr_open(&w, NULL);
     for (int i = 0; i < count; i++) {
-        cJSON_AddItemToArray(arr, port_to_json(ports[i]));
+        port_to_json(&w, NULL, ports[i]);
     }
-
-    esp_err_t ret = send_json(req, arr);
-    cJSON_Delete(arr);
-    return ret;
+    json_arr_close(&w);
+    return json_end(&w);
 }
 
+
 // PUT /api/ports/<id>/config - update port line coding
 esp_err_t api_put_port_config_handler(httpd_req_t *req)
 {
@@ -183,56 +464,31 @@ esp_err_t api_put_port_config_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    char *body = read_body(req);
-    if (!body) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing body");
-        return ESP_OK;
-    }
-
-    cJSON *json = cJSON_Parse(body);
-    free(body);
-    if (!json) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_OK;
-    }
-
-    // Update line coding
-    port_line_coding_t coding = port->line_coding;
-    cJSON *lc = cJSON_GetObjectItem(json, "lineCoding");
-    if (lc) {
-        cJSON *br = cJSON_GetObjectItem(lc, "baudRate");
-        if (br) coding.baud_rate = br->valueint;
-        cJSON *db = cJSON_GetObjectItem(lc, "dataBits");
-        if (db) coding.data_bits = db->valueint;
-        cJSON *sb = cJSON_GetObjectItem(lc, "stopBits");
-        if (sb) coding.stop_bits = sb->valueint;
-        cJSON *par = cJSON_GetObjectItem(lc, "parity");
-        if (par) coding.parity = par->valueint;
-        cJSON *fc = cJSON_GetObjectItem(lc, "flowControl");
-        if (fc) coding.flow_control = cJSON_IsTrue(fc);
-    }
+    port_config_body_t body = {
+        .coding        = port->line_coding,
+        .override_mask = port->signal_override,
+        .override_val  = port->signal_override_val,
+    };
+    if (!bind_body(req, port_config_fields, &body)) return ESP_OK;
 
     // Update signal overrides
-    cJSON *overrides = cJSON_GetObjectItem(json, "signalOverrides");
-    if (overrides) {
-        cJSON *mask = cJSON_GetObjectItem(overrides, "mask");
-        cJSON *val = cJSON_GetObjectItem(overrides, "values");
-        if (mask) port->signal_override = mask->valueint;
-        if (val)  port->signal_override_val = val->valueint;
+    if (body.overrides) {
+        port->signal_override     = body.override_mask;
+        port->signal_override_val = body.override_val;
+        port_signals_changed(port);
     }
 
+    // Update line coding
     if (port->ops.set_line_coding) {
-        port->ops.set_line_coding(port, &coding);
+        port->ops.set_line_coding(port, &body.coding);
     }
-    port->line_coding = coding;
-
-    cJSON_Delete(json);
+    port->line_coding = body.coding;
 
     // Respond with updated port
-    cJSON *resp = port_to_json(port);
-    esp_err_t ret = send_json(req, resp);
-    cJSON_Delete(resp);
-    return ret;
+    json_writer_t w;
+    json_begin(&w, req);
+    port_to_json(&w, NULL, port);
+    return json_end(&w);
 }
 
 // GET /api/routes
@@ -241,64 +497,46 @@ esp_err_t api_get_routes_handler(httpd_req_t *req)
     route_t routes[ROUTE_MAX_COUNT];
     int count = route_get_all(routes, ROUTE_MAX_COUNT);
 
-    cJSON *arr = cJSON_CreateArray();
+    json_writer_t w;
+    json_begin(&w, req);
+    json_arr_open(&w, NULL);
     for (int i = 0; i < count; i++) {
-        cJSON_AddItemToArray(arr, route_to_json(&routes[i]));
+        route_to_json(&w, NULL, &routes[i]);
     }
-
-    esp_err_t ret = send_json(req, arr);
-    cJSON_Delete(arr);
-    return ret;
+    json_arr_close(&w);
+    return json_end(&w);
 }
 
+
 // PUT /api/routes - create a new route
 esp_err_t api_put_routes_handler(httpd_req_t *req)
 {
-    char *body = read_body(req);
-    if (!body) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing body");
-        return ESP_OK;
+    // Coalescing and framing values are clamped by route_create(), elastic
+    // bytes to CONFIG_VUART_ROUTE_ELASTIC_MAX_KB
+    route_body_t body = {0};
+    if (!bind_body(req, route_fields, &body)) return ESP_OK;
+    route_t *r = &body.r;
+
+    // Merge: "sources" lists every source; the first one is srcPortId.
+    // Arbitration defaults to delimiter '\n' when only the mode is given.
+    if (r->type == ROUTE_TYPE_MERGE && body.source_count > 0) {
+        r->src_port_id = body.sources[0];
+        memcpy(r->merge_src_ids, &body.sources[1], body.source_count - 1);
+        r->merge_src_count = body.source_count - 1;
     }
+    if (body.arb_seen && !body.arb_delim_seen) r->arb_delimiter = '\n';
 
-    cJSON *json = cJSON_Parse(body);
-    free(body);
-    if (!json) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+    uint8_t route_id;
+    esp_err_t ret = route_create(r, &route_id);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Port not found");
         return ESP_OK;
     }
-
-    route_t r = {0};
-
-    cJSON *type = cJSON_GetObjectItem(json, "type");
-    if (type) r.type = type->valueint;
-
-    cJSON *src = cJSON_GetObjectItem(json, "srcPortId");
-    if (src) r.src_port_id = src->valueint;
-
-    cJSON *dsts = cJSON_GetObjectItem(json, "dstPortIds");
-    if (dsts && cJSON_IsArray(dsts)) {
-        r.dst_count = cJSON_GetArraySize(dsts);
-        if (r.dst_count > ROUTE_MAX_DEST) r.dst_count = ROUTE_MAX_DEST;
-        for (int i = 0; i < r.dst_count; i++) {
-            r.dst_port_ids[i] = cJSON_GetArrayItem(dsts, i)->valueint;
-        }
-    }
-
-    cJSON *maps = cJSON_GetObjectItem(json, "signalMap");
-    if (maps && cJSON_IsArray(maps)) {
-        r.signal_map_count = cJSON_GetArraySize(maps);
-        if (r.signal_map_count > 8) r.signal_map_count = 8;
-        for (int i = 0; i < r.signal_map_count; i++) {
-            cJSON *m = cJSON_GetArrayItem(maps, i);
-            r.signal_map[i].from_signal = cJSON_GetObjectItem(m, "fromSignal")->valueint;
-            r.signal_map[i].to_signal = cJSON_GetObjectItem(m, "toSignal")->valueint;
-        }
+    if (ret == ESP_ERR_INVALID_ARG) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid merge sources");
+        return ESP_OK;
     }
-
-    uint8_t route_id;
-    esp_err_t ret = route_create(&r, &route_id);
     if (ret != ESP_OK) {
-        cJSON_Delete(json);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to create route");
         return ESP_OK;
     }
@@ -309,14 +547,13 @@ esp_err_t api_put_routes_handler(httpd_req_t *req)
     // Persist updated route list to NVS
     persist_routes();
 
-    cJSON_Delete(json);
-
     // Respond with created route
-    route_t *created = route_get(route_id);
-    if (created) {
-        cJSON *resp = route_to_json(created);
-        ret = send_json(req, resp);
-        cJSON_Delete(resp);
+    route_t created;
+    if (route_get(route_id, &created) == ESP_OK) {
+        json_writer_t w;
+        json_begin(&w, req);
+        route_to_json(&w, NULL, &created);
+        ret = json_end(&w);
     } else {
         // Should not happen, but respond with a valid JSON error
         httpd_resp_set_type(req, "application/json");
@@ -327,6 +564,44 @@ esp_err_t api_put_routes_handler(httpd_req_t *req)
     return ret;
 }
 
+// PUT /api/routes/<id> - {"dstPortIds": [...]}, applied to the running route
+esp_err_t api_put_route_handler(httpd_req_t *req)
+{
+    int route_id = -1;
+    sscanf(req->uri, "/api/routes/%d", &route_id);
+    if (route_id < 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid route ID");
+        return ESP_OK;
+    }
+
+    route_dst_body_t body = {0};
+    if (!bind_body(req, route_dst_fields, &body)) return ESP_OK;
+
+    esp_err_t ret = route_set_destinations(route_id, body.ids, body.count);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Route or port not found");
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid destinations");
+        return ESP_OK;
+    }
+
+    // Persist updated route list to NVS
+    persist_routes();
+
+    route_t updated;
+    if (route_get(route_id, &updated) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Route not found");
+        return ESP_OK;
+    }
+    json_writer_t w;
+    json_begin(&w, req);
+    route_to_json(&w, NULL, &updated);
+    return json_end(&w);
+}
+
+
 // DELETE /api/routes/<id>
 esp_err_t api_delete_route_handler(httpd_req_t *req)
 {
@@ -352,94 +627,257 @@ esp_err_t api_delete_route_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static void latency_to_json(json_writer_t *w, const char *key, const latency_summary_t *l)
+{
+    json_obj_open(w, key);
+    json_uint(w, "count", l->count);
+    json_uint(w, "meanUs", l->mean_us);
+    json_uint(w, "p50Us", l->p50_us);
+    json_uint(w, "p99Us", l->p99_us);
+    json_uint(w, "p999Us", l->p999_us);
+    json_uint(w, "maxUs", l->max_us);
+    json_obj_close(w);
+}
+
+// GET /api/latency - forwarding latency histograms per route direction
+esp_err_t api_get_latency_handler(httpd_req_t *req)
+{
+    route_t routes[ROUTE_MAX_COUNT];
+    int count = route_get_all(routes, ROUTE_MAX_COUNT);
+
+    json_writer_t w;
+    json_begin(&w, req);
+    json_arr_open(&w, NULL);
+    for (int i = 0; i < count; i++) {
+        latency_summary_t s2d, d2s;
+        if (route_get_latency(routes[i].id, &s2d, &d2s) != ESP_OK) continue;
+        json_obj_open(&w, NULL);
+        json_uint(&w, "routeId", routes[i].id);
+        latency_to_json(&w, "srcToDst", &s2d);
+        if (routes[i].type == ROUTE_TYPE_BRIDGE) {
+            latency_to_json(&w, "dstToSrc", &d2s);
+        }
+        json_obj_close(&w);
+    }
+    json_arr_close(&w);
+    return json_end(&w);
+}
+
+
+// POST /api/latency/reset[?route=<id>] - clear one route's histograms, or all
+esp_err_t api_post_latency_reset_handler(httpd_req_t *req)
+{
+    int route_id = -1;
+    char query[32], val[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "route", val, sizeof(val)) == ESP_OK) {
+        route_id = atoi(val);
+    }
+
+    if (route_id >= 0) {
+        if (route_reset_latency(route_id) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Route not found");
+            return ESP_OK;
+        }
+    } else {
+        route_t routes[ROUTE_MAX_COUNT];
+        int count = route_get_all(routes, ROUTE_MAX_COUNT);
+        for (int i = 0; i < count; i++) {
+            route_reset_latency(routes[i].id);
+        }
+        signal_router_reset_latency();
+        web_server_reset_ws_latency();
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_sendstr(req, "{\"ok\":true}");
+    return ESP_OK;
+}
+
+static void dir_metrics_to_json(json_writer_t *w, const char *key,
+                                const route_dir_stats_t *s, const latency_summary_t *l)
+{
+    json_obj_open(w, key);
+    json_uint(w, "bytes", s->bytes);
+    json_uint(w, "chunks", s->chunks);
+    json_uint(w, "writes", s->writes);
+    json_uint(w, "shortWrites", s->short_writes);
+    json_uint(w, "lost", s->lost);
+    json_uint(w, "overruns", s->overruns);
+    json_uint(w, "stalls", s->stalls);
+    json_uint(w, "frames", s->frames);
+    json_uint(w, "partialFrames", s->partial_frames);
+    latency_to_json(w, "latency", l);
+    json_obj_close(w);
+}
+
+// GET /api/metrics - data-plane counters in one flat document for scripts.
+// Everything is a monotonic total; diff two samples against timeUs for
+// MB/s and chunks/s.
+esp_err_t api_get_metrics_handler(httpd_req_t *req)
+{
+    json_writer_t w;
+    json_begin(&w, req);
+    json_obj_open(&w, NULL);
+    json_int(&w, "timeUs", esp_timer_get_time());
+
+    // Heap and data-path buffer allocations
+    json_obj_open(&w, "heap");
+    json_uint(&w, "free", esp_get_free_heap_size());
+    json_uint(&w, "minFree", esp_get_minimum_free_heap_size());
+    buf_pool_stats_t pool[BUF_CLASS_COUNT];
+    buf_pool_get_stats(pool);
+    uint32_t takes = 0, failures = 0;
+    for (int i = 0; i < BUF_CLASS_COUNT; i++) {
+        takes    += pool[i].takes;
+        failures += pool[i].failures;
+    }
+    json_uint(&w, "poolTakes", takes);
+    json_uint(&w, "poolFailures", failures);
+    json_obj_close(&w);
+
+    route_engine_stats_t dp;
+    route_engine_get_stats(&dp);
+    json_uint(&w, "wakeups", dp.wakeups);
+
+    port_t *ports[PORT_MAX_COUNT];
+    int pcount = port_registry_get_all(ports, PORT_MAX_COUNT);
+    json_arr_open(&w, "ports");
+    for (int i = 0; i < pcount; i++) {
+        port_stats_t ps;
+        port_get_stats(ports[i], &ps);
+        json_obj_open(&w, NULL);
+        json_uint(&w, "id", ports[i]->id);
+        json_uint(&w, "rxBytes", ps.rx.bytes);
+        json_uint(&w, "rxChunks", ps.rx.chunks);
+        json_uint(&w, "rxDropped", ps.rx.dropped);
+        json_uint(&w, "txQueued", ps.tx.queued);
+        json_uint(&w, "txRefused", ps.tx.refused);
+        json_uint(&w, "txDiscarded", ps.tx.discarded);
+        json_uint(&w, "txPending", port_tx_pending(ports[i]));
+        json_uint(&w, "txBytes", ps.tx.bytes);
+        json_uint(&w, "txWrites", ps.tx.writes);
+        json_uint(&w, "txShortWrites", ps.tx.short_writes);
+        json_obj_close(&w);
+    }
+    json_arr_close(&w);
+
+    route_t routes[ROUTE_MAX_COUNT];
+    int rcount = route_get_all(routes, ROUTE_MAX_COUNT);
+    json_arr_open(&w, "routes");
+    for (int i = 0; i < rcount; i++) {
+        route_stats_t st;
+        latency_summary_t s2d, d2s;
+        if (route_get_stats(routes[i].id, &st) != ESP_OK ||
+            route_get_latency(routes[i].id, &s2d, &d2s) != ESP_OK) {
+            continue;
+        }
+        json_obj_open(&w, NULL);
+        json_uint(&w, "id", routes[i].id);
+        json_uint(&w, "type", routes[i].type);
+        json_uint(&w, "destinations", routes[i].dst_count);
+        dir_metrics_to_json(&w, "srcToDst", &st.src_to_dst, &s2d);
+        if (routes[i].type == ROUTE_TYPE_BRIDGE) {
+            dir_metrics_to_json(&w, "dstToSrc", &st.dst_to_src, &d2s);
+        }
+        json_obj_close(&w);
+    }
+    json_arr_close(&w);
+
+    // Signal change to mappings applied, all ports
+    latency_summary_t sig;
+    signal_router_get_latency(&sig);
+    latency_to_json(&w, "signalLatency", &sig);
+    signal_router_stats_t ss;
+    signal_router_get_stats(&ss);
+    json_uint(&w, "signalApplied", ss.applied);
+    json_uint(&w, "signalSkipped", ss.skipped);
+
+    // WebSocket pushes, per encoding
+    web_server_ws_stats_t ws;
+    web_server_get_ws_stats(&ws);
+    json_obj_open(&w, "ws");
+    json_uint(&w, "jsonFrames", ws.json_frames);
+    json_uint(&w, "binaryFrames", ws.binary_frames);
+    json_uint(&w, "bytes", ws.bytes);
+    json_uint(&w, "sendErrors", ws.send_errors);
+    json_uint(&w, "coalesced", ws.coalesced);
+    json_uint(&w, "dropped", ws.dropped);
+    json_uint(&w, "clients", ws.clients);
+    latency_to_json(&w, "produceLatency", &ws.produce);
+    json_obj_close(&w);
+
+    json_obj_close(&w);
+    return json_end(&w);
+}
+
 // GET /api/config
 esp_err_t api_get_config_handler(httpd_req_t *req)
 {
-
-    cJSON *obj = cJSON_CreateObject();
+    json_writer_t w;
+    json_begin(&w, req);
+    json_obj_open(&w, NULL);
 
     // WiFi (don't expose password)
-    cJSON *wifi = cJSON_CreateObject();
-    cJSON_AddStringToObject(wifi, "ssid", sys_config.wifi_ssid);
-    cJSON_AddStringToObject(wifi, "mode",
+    json_obj_open(&w, "wifi");
+    json_str(&w, "ssid", sys_config.wifi_ssid);
+    json_str(&w, "mode",
         wifi_mgr_get_mode() == WIFI_MGR_MODE_STA ? "sta" :
         wifi_mgr_get_mode() == WIFI_MGR_MODE_AP ? "ap" : "none");
-    cJSON_AddStringToObject(wifi, "ip", wifi_mgr_get_ip());
-    cJSON_AddBoolToObject(wifi, "connected", wifi_mgr_is_connected());
-    cJSON_AddItemToObject(obj, "wifi", wifi);
+    json_str(&w, "ip", wifi_mgr_get_ip());
+    json_bool(&w, "connected", wifi_mgr_is_connected());
+    json_obj_close(&w);
 
     // TCP configs
-    cJSON *tcp = cJSON_CreateArray();
+    json_arr_open(&w, "tcpConfigs");
     for (int i = 0; i < 4; i++) {
-        cJSON *tc = cJSON_CreateObject();
-        cJSON_AddStringToObject(tc, "host", sys_config.tcp_configs[i].host);
-        cJSON_AddNumberToObject(tc, "port", sys_config.tcp_configs[i].port);
-        cJSON_AddBoolToObject(tc, "isServer", sys_config.tcp_configs[i].is_server);
-        cJSON_AddItemToArray(tcp, tc);
+        json_obj_open(&w, NULL);
+        json_str(&w, "host", sys_config.tcp_configs[i].host);
+        json_uint(&w, "port", sys_config.tcp_configs[i].port);
+        json_bool(&w, "isServer", sys_config.tcp_configs[i].is_server);
+        json_obj_close(&w);
     }
-    cJSON_AddItemToObject(obj, "tcpConfigs", tcp);
+    json_arr_close(&w);
 
-    esp_err_t ret = send_json(req, obj);
-    cJSON_Delete(obj);
-    return ret;
+    json_obj_close(&w);
+    return json_end(&w);
 }
 
+
 // PUT /api/config - update WiFi credentials and/or TCP configs
 esp_err_t api_put_config_handler(httpd_req_t *req)
 {
-    char *body = read_body(req);
-    if (!body) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing body");
-        return ESP_OK;
-    }
-
-    cJSON *json = cJSON_Parse(body);
-    free(body);
-    if (!json) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_OK;
+    config_body_t body = {0};
+    memcpy(body.tcp, sys_config.tcp_configs, sizeof(body.tcp));
+    if (!bind_body(req, config_fields, &body)) return ESP_OK;
+
+    route_affinity_t affinity = route_get_affinity();
+    if (body.affinity_seen) {
+        if (strcmp(body.affinity, "auto") == 0) {
+            affinity = ROUTE_AFFINITY_AUTO;
+        } else if (strcmp(body.affinity, "none") == 0) {
+            affinity = ROUTE_AFFINITY_NONE;
+        } else {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid routeAffinity");
+            return ESP_OK;
+        }
     }
 
-    bool wifi_changed = false;
-
     // Update WiFi credentials
-    cJSON *wifi = cJSON_GetObjectItem(json, "wifi");
-    if (wifi) {
-        cJSON *ssid = cJSON_GetObjectItem(wifi, "ssid");
-        cJSON *pass = cJSON_GetObjectItem(wifi, "password");
-        if (ssid && cJSON_IsString(ssid)) {
-            strncpy(sys_config.wifi_ssid, ssid->valuestring, sizeof(sys_config.wifi_ssid) - 1);
-            wifi_changed = true;
-        }
-        if (pass && cJSON_IsString(pass)) {
-            strncpy(sys_config.wifi_pass, pass->valuestring, sizeof(sys_config.wifi_pass) - 1);
-            wifi_changed = true;
-        }
-    }
+    bool wifi_changed = body.ssid_seen || body.pass_seen;
+    if (body.ssid_seen) memcpy(sys_config.wifi_ssid, body.ssid, sizeof(body.ssid));
+    if (body.pass_seen) memcpy(sys_config.wifi_pass, body.pass, sizeof(body.pass));
 
     // Update TCP configs
-    cJSON *tcp = cJSON_GetObjectItem(json, "tcpConfigs");
-    if (tcp && cJSON_IsArray(tcp)) {
-        int count = cJSON_GetArraySize(tcp);
-        if (count > 4) count = 4;
-        for (int i = 0; i < count; i++) {
-            cJSON *tc = cJSON_GetArrayItem(tcp, i);
-            cJSON *host = cJSON_GetObjectItem(tc, "host");
-            cJSON *port = cJSON_GetObjectItem(tc, "port");
-            cJSON *is_server = cJSON_GetObjectItem(tc, "isServer");
-
-            if (host && cJSON_IsString(host))
-                strncpy(sys_config.tcp_configs[i].host, host->valuestring, sizeof(sys_config.tcp_configs[i].host) - 1);
-            if (port) sys_config.tcp_configs[i].port = port->valueint;
-            if (is_server) sys_config.tcp_configs[i].is_server = cJSON_IsTrue(is_server);
-        }
-    }
+    memcpy(sys_config.tcp_configs, body.tcp, sizeof(sys_config.tcp_configs));
+
+    // Data-plane core placement (runtime only; the boot default is Kconfig)
+    if (body.affinity_seen) route_set_affinity(affinity);
 
     // Save config
     config_store_save(&sys_config);
 
-    cJSON_Delete(json);
-
     // Send response BEFORE switching WiFi (switching kills the AP connection)
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
@@ -485,15 +923,50 @@ esp_err_t api_post_config_reset_handler(httpd_req_t *req)
 // GET /api/system - system info
 esp_err_t api_get_system_handler(httpd_req_t *req)
 {
-    cJSON *obj = cJSON_CreateObject();
-    cJSON_AddStringToObject(obj, "firmware", "ESP32 Virtual UART");
-    cJSON_AddStringToObject(obj, "version", "0.1.0");
-    cJSON_AddNumberToObject(obj, "portCount", port_registry_count());
-    cJSON_AddNumberToObject(obj, "activeRoutes", route_active_count());
-    cJSON_AddNumberToObject(obj, "freeHeap", (int)esp_get_free_heap_size());
-    cJSON_AddNumberToObject(obj, "uptime", (int)(xTaskGetTickCount() / configTICK_RATE_HZ));
-
-    esp_err_t ret = send_json(req, obj);
-    cJSON_Delete(obj);
-    return ret;
+    json_writer_t w;
+    json_begin(&w, req);
+    json_obj_open(&w, NULL);
+    json_str(&w, "firmware", "ESP32 Virtual UART");
+    json_str(&w, "version", "0.1.0");
+    json_uint(&w, "portCount", port_registry_count());
+    json_uint(&w, "activeRoutes", route_active_count());
+    json_uint(&w, "freeHeap", esp_get_free_heap_size());
+    json_uint(&w, "uptime", xTaskGetTickCount() / configTICK_RATE_HZ);
+
+    // Data-plane buffer pool usage per size class
+    buf_pool_stats_t pool[BUF_CLASS_COUNT];
+    buf_pool_get_stats(pool);
+    json_arr_open(&w, "bufPool");
+    for (int i = 0; i < BUF_CLASS_COUNT; i++) {
+        json_obj_open(&w, NULL);
+        json_uint(&w, "blockSize", pool[i].block_size);
+        json_uint(&w, "blockCount", pool[i].block_count);
+        json_uint(&w, "inUse", pool[i].in_use);
+        json_uint(&w, "highWater", pool[i].high_water);
+        json_uint(&w, "takes", pool[i].takes);
+        json_uint(&w, "fallbacks", pool[i].fallbacks);
+        json_uint(&w, "failures", pool[i].failures);
+        json_obj_close(&w);
+    }
+    json_arr_close(&w);
+
+    route_engine_stats_t dp;
+    route_engine_get_stats(&dp);
+    json_obj_open(&w, "dataPlane");
+    json_str(&w, "mode", dp.dispatcher ? "dispatcher" : "per-task");
+    json_uint(&w, "tasks", dp.tasks);
+    json_uint(&w, "stackBytes", dp.stack_bytes);
+    json_uint(&w, "wakeups", dp.wakeups);
+    json_str(&w, "affinity", dp.affinity == ROUTE_AFFINITY_AUTO ? "auto" : "none");
+    json_arr_open(&w, "cpuLoad");
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        json_int(&w, NULL, dp.cpu_load[i]);
+    }
+    json_arr_close(&w);
+    json_uint(&w, "notifyPerSec", dp.notify_per_s);
+    json_uint(&w, "crossCorePerSec", dp.cross_core_per_s);
+    json_obj_close(&w);
+
+    json_obj_close(&w);
+    return json_end(&w);
 }
@@ -1,6 +1,20 @@
 #pragma once
 
+#include <stdint.h>
 #include "esp_err.h"
+#include "latency_hist.h"
+
+// WebSocket push counters since boot.
+typedef struct {
+    uint32_t json_frames;
+    uint32_t binary_frames;
+    uint64_t bytes;
+    uint32_t send_errors;
+    uint32_t coalesced;         // queued frames replaced by newer figures
+    uint32_t dropped;           // frames not queued: client queue or frame pool full
+    uint32_t clients;           // connected now, all endpoints
+    latency_summary_t produce;  // producer side: encode and queue for every client
+} web_server_ws_stats_t;
 
 // Start the HTTP + WebSocket server.
 // Must be called after WiFi is connected and all ports/routes are initialized.
@@ -14,3 +28,6 @@ void web_server_notify_signal_change(uint8_t port_id, uint32_t signals);
 
 // Notify WebSocket clients of data flow stats
 void web_server_notify_data_flow(uint8_t route_id, uint32_t bytes_src_to_dst, uint32_t bytes_dst_to_src);
+
+void web_server_get_ws_stats(web_server_ws_stats_t *out);
+void web_server_reset_ws_latency(void);
@@ -0,0 +1,403 @@
+#include "json_parser.h"
+#include <string.h>
+
+typedef struct {
+    const char *js;
+    size_t      len;
+    size_t      pos;
+    json_tok_t *toks;
+    int         max;
+    int         n;
+} parser_t;
+
+static void skip_ws(parser_t *p)
+{
+    while (p->pos < p->len) {
+        char c = p->js[p->pos];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') break;
+        p->pos++;
+    }
+}
+
+static int new_tok(parser_t *p, json_tok_type_t type, size_t start)
+{
+    if (p->n >= p->max) return -1;
+    json_tok_t *t = &p->toks[p->n];
+    t->type  = type;
+    t->start = start;
+    t->end   = start;
+    t->size  = 0;
+    t->next  = p->n + 1;
+    return p->n++;
+}
+
+static int hex_val(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// At the opening quote
+static bool parse_string(parser_t *p)
+{
+    int i = new_tok(p, JSON_TOK_STRING, ++p->pos);
+    if (i < 0) return false;
+
+    while (p->pos < p->len) {
+        unsigned char c = p->js[p->pos];
+        if (c == '"') {
+            p->toks[i].end = p->pos++;
+            return true;
+        }
+        if (c < 0x20) return false;
+        if (c == '\\') {
+            if (++p->pos >= p->len) return false;
+            c = p->js[p->pos];
+            if (c == 'u') {
+                for (int k = 0; k < 4; k++) {
+                    if (++p->pos >= p->len || hex_val(p->js[p->pos]) < 0) return false;
+                }
+            } else if (c == '\0' || !strchr("\"\\/bfnrt", c)) {
+                return false;
+            }
+        }
+        p->pos++;
+    }
+    return false;
+}
+
+static bool scan_digits(parser_t *p)
+{
+    size_t from = p->pos;
+    while (p->pos < p->len && p->js[p->pos] >= '0' && p->js[p->pos] <= '9') p->pos++;
+    return p->pos > from;
+}
+
+static bool parse_primitive(parser_t *p)
+{
+    static const char *const literals[] = { "true", "false", "null" };
+    int i = new_tok(p, JSON_TOK_PRIMITIVE, p->pos);
+    if (i < 0) return false;
+
+    for (int k = 0; k < 3; k++) {
+        size_t n = strlen(literals[k]);
+        if (p->len - p->pos >= n && memcmp(&p->js[p->pos], literals[k], n) == 0) {
+            p->pos += n;
+            p->toks[i].end = p->pos;
+            return true;
+        }
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    if (p->pos < p->len && p->js[p->pos] == '-') p->pos++;
+    if (p->pos < p->len && p->js[p->pos] == '0') {
+        p->pos++;
+    } else if (!scan_digits(p)) {
+        return false;
+    }
+    if (p->pos < p->len && p->js[p->pos] == '.') {
+        p->pos++;
+        if (!scan_digits(p)) return false;
+    }
+    if (p->pos < p->len && (p->js[p->pos] == 'e' || p->js[p->pos] == 'E')) {
+        p->pos++;
+        if (p->pos < p->len && (p->js[p->pos] == '+' || p->js[p->pos] == '-')) p->pos++;
+        if (!scan_digits(p)) return false;
+    }
+    p->toks[i].end = p->pos;
+    return true;
+}
+
+static bool parse_value(parser_t *p, int depth)
+{
+    skip_ws(p);
+    if (p->pos >= p->len) return false;
+
+    char open = p->js[p->pos];
+    if (open == '"') return parse_string(p);
+    if (open != '{' && open != '[') return parse_primitive(p);
+
+    char close = open == '{' ? '}' : ']';
+    if (depth >= JSON_PARSE_DEPTH) return false;
+    int i = new_tok(p, open == '{' ? JSON_TOK_OBJECT : JSON_TOK_ARRAY, p->pos++);
+    if (i < 0) return false;
+
+    skip_ws(p);
+    if (p->pos < p->len && p->js[p->pos] == close) {
+        p->pos++;
+    } else {
+        for (;;) {
+            if (open == '{') {
+                skip_ws(p);
+                if (p->pos >= p->len || p->js[p->pos] != '"' || !parse_string(p)) return false;
+                skip_ws(p);
+                if (p->pos >= p->len || p->js[p->pos] != ':') return false;
+                p->pos++;
+            }
+            if (!parse_value(p, depth + 1)) return false;
+            p->toks[i].size++;
+
+            skip_ws(p);
+            if (p->pos >= p->len) return false;
+            char c = p->js[p->pos++];
+            if (c == close) break;
+            if (c != ',') return false;
+        }
+    }
+    p->toks[i].end  = p->pos;
+    p->toks[i].next = p->n;
+    return true;
+}
+
+int json_parse(const char *js, size_t len, json_tok_t *toks, int max_toks)
+{
+    if (len > UINT16_MAX) return -1;
+
+    parser_t p = { .js = js, .len = len, .toks = toks, .max = max_toks };
+    if (!parse_value(&p, 0)) return -1;
+    skip_ws(&p);
+    return p.pos == len ? p.n : -1;
+}
+
+// --- Binding ---
+
+typedef struct {
+    const char       *js;
+    const json_tok_t *toks;
+    const char      **bad;
+} binder_t;
+
+static bool tok_is(const binder_t *b, const json_tok_t *t, const char *s)
+{
+    size_t n = strlen(s);
+    return (size_t)(t->end - t->start) == n && memcmp(&b->js[t->start], s, n) == 0;
+}
+
+// Integers only: a fraction or exponent is a type error here
+static bool tok_int(const binder_t *b, const json_tok_t *t, int64_t *out)
+{
+    if (t->type != JSON_TOK_PRIMITIVE) return false;
+
+    const char *s = &b->js[t->start], *end = &b->js[t->end];
+    bool neg = *s == '-';
+    if (neg) s++;
+    if (s == end || *s < '0' || *s > '9') return false;
+
+    int64_t v = 0;
+    for (; s < end; s++) {
+        if (*s < '0' || *s > '9') return false;
+        if (v > (INT64_MAX - 9) / 10) return false;
+        v = v * 10 + (*s - '0');
+    }
+    *out = neg ? -v : v;
+    return true;
+}
+
+static bool in_range(const json_field_t *f, int64_t *v)
+{
+    if (*v >= f->min && *v <= f->max) return true;
+    if (!f->clamp) return false;
+    *v = *v < f->min ? f->min : f->max;
+    return true;
+}
+
+// Decode a string token into out.  In byte mode \u escapes must fit a byte;
+// otherwise they become UTF-8 and NUL is refused.  Returns the length or -1.
+static int unescape(const binder_t *b, const json_tok_t *t, uint8_t *out, size_t cap, bool bytes)
+{
+    size_t n = 0;
+    for (size_t i = t->start; i < t->end; i++) {
+        uint32_t cp = (uint8_t)b->js[i];
+        bool raw = cp != '\\';
+        if (!raw) {
+            char e = b->js[++i];
+            if (e != 'u') {
+                static const char from[] = "\"\\/bfnrt", to[] = "\"\\/\b\f\n\r\t";
+                cp = to[strchr(from, e) - from];
+            } else {
+                cp = 0;
+                for (int k = 0; k < 4; k++) cp = cp << 4 | hex_val(b->js[++i]);
+                if (!bytes && cp >= 0xd800 && cp <= 0xdbff) {
+                    // High surrogate: the low half must follow
+                    uint32_t lo = 0;
+                    if (i + 6 >= t->end || b->js[i + 1] != '\\' || b->js[i + 2] != 'u') return -1;
+                    for (int k = 0; k < 4; k++) lo = lo << 4 | hex_val(b->js[i + 3 + k]);
+                    if (lo < 0xdc00 || lo > 0xdfff) return -1;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                    i += 6;
+                } else if (!bytes && cp >= 0xdc00 && cp <= 0xdfff) {
+                    return -1;
+                }
+                if (bytes ? cp > 0xff : cp == 0) return -1;
+            }
+        }
+
+        uint8_t enc[4];
+        size_t len;
+        if (raw || bytes || cp < 0x80) {
+            enc[0] = cp;
+            len = 1;
+        } else if (cp < 0x800) {
+            enc[0] = 0xc0 | cp >> 6;
+            enc[1] = 0x80 | (cp & 0x3f);
+            len = 2;
+        } else if (cp < 0x10000) {
+            enc[0] = 0xe0 | cp >> 12;
+            enc[1] = 0x80 | (cp >> 6 & 0x3f);
+            enc[2] = 0x80 | (cp & 0x3f);
+            len = 3;
+        } else {
+            enc[0] = 0xf0 | cp >> 18;
+            enc[1] = 0x80 | (cp >> 12 & 0x3f);
+            enc[2] = 0x80 | (cp >> 6 & 0x3f);
+            enc[3] = 0x80 | (cp & 0x3f);
+            len = 4;
+        }
+        if (n + len > cap) return -1;
+        memcpy(&out[n], enc, len);
+        n += len;
+    }
+    return n;
+}
+
+static void store_num(uint8_t *dst, json_kind_t kind, int64_t v)
+{
+    switch (kind) {
+    case JSON_U8:   *dst = v; break;
+    case JSON_U16:  { uint16_t x = v; memcpy(dst, &x, sizeof(x)); break; }
+    case JSON_U32:  { uint32_t x = v; memcpy(dst, &x, sizeof(x)); break; }
+    default:        { int x = v; memcpy(dst, &x, sizeof(x)); break; }
+    }
+}
+
+// Elements of the array at toks[i] into uint8_t dst, at most cap
+static bool bind_u8_array(const binder_t *b, const json_field_t *f, int i, uint8_t *dst, uint8_t *count)
+{
+    const json_tok_t *arr = &b->toks[i];
+    if (arr->size > f->cap) return false;
+
+    int e = i + 1;
+    for (int j = 0; j < arr->size; j++) {
+        int64_t v;
+        if (!tok_int(b, &b->toks[e], &v) || !in_range(f, &v)) return false;
+        dst[j] = v;
+        e = b->toks[e].next;
+    }
+    *count = arr->size;
+    return true;
+}
+
+static bool bind_object(const binder_t *b, int i, const json_field_t *schema, uint8_t *base);
+
+static bool bind_value(const binder_t *b, const json_field_t *f, int i, uint8_t *base)
+{
+    const json_tok_t *t = &b->toks[i];
+    uint8_t *dst = base + f->offset;
+
+    switch ((json_kind_t)f->kind) {
+    case JSON_U8:
+    case JSON_U16:
+    case JSON_U32:
+    case JSON_ENUM: {
+        int64_t v;
+        if (!tok_int(b, t, &v) || !in_range(f, &v)) return false;
+        store_num(dst, f->kind, v);
+        break;
+    }
+    case JSON_BOOL:
+        if (t->type != JSON_TOK_PRIMITIVE || !(tok_is(b, t, "true") || tok_is(b, t, "false"))) {
+            return false;
+        }
+        *(bool *)dst = b->js[t->start] == 't';
+        break;
+    case JSON_STR: {
+        if (t->type != JSON_TOK_STRING) return false;
+        int n = unescape(b, t, dst, f->cap - 1, false);
+        if (n < 0) return false;
+        dst[n] = '\0';
+        break;
+    }
+    case JSON_BYTES:
+        if (t->type == JSON_TOK_STRING) {
+            int n = unescape(b, t, dst, f->cap, true);
+            if (n < 0) return false;
+            base[f->count] = n;
+        } else if (t->type != JSON_TOK_ARRAY || !bind_u8_array(b, f, i, dst, &base[f->count])) {
+            return false;
+        }
+        break;
+    case JSON_ARRAY:
+        if (t->type != JSON_TOK_ARRAY || !bind_u8_array(b, f, i, dst, &base[f->count])) return false;
+        break;
+    case JSON_OBJECT:
+        if (t->type != JSON_TOK_OBJECT || !bind_object(b, i, f->sub, base)) return false;
+        break;
+    case JSON_OBJECTS: {
+        if (t->type != JSON_TOK_ARRAY || t->size > f->cap) return false;
+        int e = i + 1;
+        for (int j = 0; j < t->size; j++) {
+            if (b->toks[e].type != JSON_TOK_OBJECT ||
+                !bind_object(b, e, f->sub, dst + j * f->stride)) {
+                return false;
+            }
+            e = b->toks[e].next;
+        }
+        base[f->count] = t->size;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (f->track) *(bool *)(base + f->seen) = true;
+    return true;
+}
+
+static bool bind_object(const binder_t *b, int i, const json_field_t *schema, uint8_t *base)
+{
+    uint32_t seen = 0;
+    for (int f = 0; schema[f].key; f++) {
+        if (f >= JSON_SCHEMA_MAX) {
+            // One bit of seen per field: a longer schema cannot be checked
+            *b->bad = schema[f].key;
+            return false;
+        }
+    }
+
+    int k = i + 1;
+    for (int m = 0; m < b->toks[i].size; m++) {
+        const json_tok_t *key = &b->toks[k], *val = &b->toks[k + 1];
+        for (int f = 0; schema[f].key; f++) {
+            if (!tok_is(b, key, schema[f].key)) continue;
+            if (val->type == JSON_TOK_PRIMITIVE && tok_is(b, val, "null")) break;
+            if (!bind_value(b, &schema[f], k + 1, base)) {
+                if (!*b->bad) *b->bad = schema[f].key;
+                return false;
+            }
+            seen |= 1u << f;
+            break;
+        }
+        k = val->next;
+    }
+
+    for (int f = 0; schema[f].key; f++) {
+        if (schema[f].required && !(seen & (1u << f))) {
+            *b->bad = schema[f].key;
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t json_bind(const char *js, const json_tok_t *toks, int count,
+                    const json_field_t *schema, void *base, const char **bad)
+{
+    const char *dummy;
+    binder_t b = { .js = js, .toks = toks, .bad = bad ? bad : &dummy };
+    *b.bad = NULL;
+
+    if (count < 1 || toks[0].type != JSON_TOK_OBJECT) return ESP_ERR_INVALID_ARG;
+    return bind_object(&b, 0, schema, base) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
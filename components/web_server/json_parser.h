@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Zero-allocation JSON reader for request bodies, in two steps.
+//
+// json_parse() checks the whole document against the JSON grammar and
+// records it as a flat array of tokens pointing into the caller's buffer.
+// json_bind() then walks the tokens once against a schema, a table of
+// json_field_t, storing each known member straight into a C struct.  Unknown
+// members and nulls are skipped.  A value of the wrong type or outside
+// [min, max], an over-long string or array, or a missing required member
+// rejects the document; the struct may then be partly written.
+
+typedef enum {
+    JSON_TOK_OBJECT,
+    JSON_TOK_ARRAY,
+    JSON_TOK_STRING,        // start/end exclude the quotes; escapes are left in
+    JSON_TOK_PRIMITIVE,     // number, true, false or null
+} json_tok_type_t;
+
+typedef struct {
+    uint8_t  type;          // json_tok_type_t
+    uint16_t start;         // byte offsets into the document
+    uint16_t end;
+    uint16_t size;          // members of an object, elements of an array
+    uint16_t next;          // index of the token after this value's subtree
+} json_tok_t;
+
+#define JSON_PARSE_DEPTH    8
+
+// Tokenize len bytes of js.  Returns the token count, or -1 if the text is
+// not a single valid JSON value or needs more than max_toks tokens.
+int json_parse(const char *js, size_t len, json_tok_t *toks, int max_toks);
+
+typedef enum {
+    JSON_U8,
+    JSON_U16,
+    JSON_U32,
+    JSON_ENUM,              // an enum member, stored as int
+    JSON_BOOL,
+    JSON_STR,               // NUL-terminated, cap bytes including the NUL
+    JSON_BYTES,             // a string or an array of 0..255; uint8_t count
+    JSON_ARRAY,             // numbers into uint8_t elements; uint8_t count
+    JSON_OBJECT,            // members bound by sub, same base
+    JSON_OBJECTS,           // array of objects bound by sub, stride apart; uint8_t count
+} json_kind_t;
+
+#define JSON_SCHEMA_MAX     32      // fields per schema, not counting the NULL end
+
+typedef struct json_field {
+    const char  *key;           // NULL ends a schema of at most JSON_SCHEMA_MAX fields
+    uint8_t      kind;          // json_kind_t
+    uint8_t      clamp    : 1;  // pull numbers into [min, max] instead of rejecting
+    uint8_t      required : 1;
+    uint8_t      track    : 1;  // set the bool at seen when the member is bound
+    uint16_t     offset;
+    uint16_t     count;         // offset of the element count
+    uint16_t     seen;
+    uint16_t     cap;           // STR bytes, array elements
+    uint16_t     stride;        // JSON_OBJECTS element size
+    int64_t      min, max;      // numbers and array elements
+    const struct json_field *sub;
+} json_field_t;
+
+#define JSON_FIELD_NUM(k, kind_, T, m, lo, hi, ...) \
+    { .key = k, .kind = kind_, .offset = offsetof(T, m), .min = lo, .max = hi, __VA_ARGS__ }
+#define JSON_FIELD_BOOL(k, T, m, ...) \
+    { .key = k, .kind = JSON_BOOL, .offset = offsetof(T, m), __VA_ARGS__ }
+#define JSON_FIELD_STR(k, T, m, ...) \
+    { .key = k, .kind = JSON_STR, .offset = offsetof(T, m), \
+      .cap = sizeof(((T *)0)->m), __VA_ARGS__ }
+#define JSON_FIELD_BYTES(k, T, m, n, ...) \
+    { .key = k, .kind = JSON_BYTES, .offset = offsetof(T, m), .count = offsetof(T, n), \
+      .cap = sizeof(((T *)0)->m), .min = 0, .max = UINT8_MAX, __VA_ARGS__ }
+#define JSON_FIELD_ARRAY(k, T, m, n, lo, hi, ...) \
+    { .key = k, .kind = JSON_ARRAY, .offset = offsetof(T, m), .count = offsetof(T, n), \
+      .cap = sizeof(((T *)0)->m), .min = lo, .max = hi, __VA_ARGS__ }
+#define JSON_FIELD_OBJECT(k, schema, ...) \
+    { .key = k, .kind = JSON_OBJECT, .sub = schema, __VA_ARGS__ }
+#define JSON_FIELD_OBJECTS(k, T, m, n, schema, ...) \
+    { .key = k, .kind = JSON_OBJECTS, .offset = offsetof(T, m), .count = offsetof(T, n), \
+      .cap = sizeof(((T *)0)->m) / sizeof(((T *)0)->m[0]), \
+      .stride = sizeof(((T *)0)->m[0]), .sub = schema, __VA_ARGS__ }
+
+// Modifiers for the last argument of the macros above
+#define JSON_CLAMPED        .clamp = 1
+#define JSON_REQUIRED       .required = 1
+#define JSON_SEEN(T, m)     .track = 1, .seen = offsetof(T, m)
+
+// Bind the value at toks[0], which must be an object, into base.  On
+// ESP_ERR_INVALID_ARG, *bad names the member at fault (may be NULL).
+esp_err_t json_bind(const char *js, const json_tok_t *toks, int count,
+                    const json_field_t *schema, void *base, const char **bad);
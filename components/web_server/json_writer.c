@@ -0,0 +1,129 @@
+#include "json_writer.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static void flush(json_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = httpd_resp_send_chunk(w->req, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void put(json_writer_t *w, const char *s, size_t n)
+{
+    while (n > 0 && w->err == ESP_OK) {
+        size_t room = sizeof(w->buf) - w->len;
+        if (room == 0) {
+            flush(w);
+            continue;
+        }
+        if (room > n) room = n;
+        memcpy(&w->buf[w->len], s, room);
+        w->len += room;
+        s += room;
+        n -= room;
+    }
+}
+
+static void put_c(json_writer_t *w, char c)
+{
+    put(w, &c, 1);
+}
+
+static void put_string(json_writer_t *w, const char *s)
+{
+    put_c(w, '"');
+    for (const char *run = s;; s++) {
+        unsigned char c = *s;
+        if (c != '\0' && c != '"' && c != '\\' && c >= 0x20) continue;
+
+        put(w, run, s - run);
+        if (c == '\0') break;
+        char esc[8];
+        int n = c == '"' || c == '\\' ? snprintf(esc, sizeof(esc), "\\%c", c)
+              : c == '\n'             ? snprintf(esc, sizeof(esc), "\\n")
+              : c == '\r'             ? snprintf(esc, sizeof(esc), "\\r")
+              : c == '\t'             ? snprintf(esc, sizeof(esc), "\\t")
+              :                         snprintf(esc, sizeof(esc), "\\u%04x", c);
+        put(w, esc, n);
+        run = s + 1;
+    }
+    put_c(w, '"');
+}
+
+// Separator and key ahead of a value.
+static void member(json_writer_t *w, const char *key)
+{
+    uint32_t bit = 1u << w->depth;
+    if (w->started & bit) put_c(w, ',');
+    w->started |= bit;
+    if (key) {
+        put_string(w, key);
+        put_c(w, ':');
+    }
+}
+
+void json_begin(json_writer_t *w, httpd_req_t *req)
+{
+    w->req     = req;
+    w->err     = ESP_OK;
+    w->len     = 0;
+    w->depth   = 0;
+    w->started = 0;
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+}
+
+esp_err_t json_end(json_writer_t *w)
+{
+    flush(w);
+    if (w->err == ESP_OK) w->err = httpd_resp_send_chunk(w->req, NULL, 0);
+    return w->err;
+}
+
+static void container_open(json_writer_t *w, const char *key, char c)
+{
+    member(w, key);
+    put_c(w, c);
+    if (w->depth < JSON_WRITER_DEPTH - 1) w->depth++;
+    w->started &= ~(1u << w->depth);
+}
+
+static void container_close(json_writer_t *w, char c)
+{
+    put_c(w, c);
+    if (w->depth > 0) w->depth--;
+}
+
+void json_obj_open(json_writer_t *w, const char *key)  { container_open(w, key, '{'); }
+void json_obj_close(json_writer_t *w)                  { container_close(w, '}'); }
+void json_arr_open(json_writer_t *w, const char *key)  { container_open(w, key, '['); }
+void json_arr_close(json_writer_t *w)                  { container_close(w, ']'); }
+
+void json_int(json_writer_t *w, const char *key, int64_t v)
+{
+    char num[24];
+    member(w, key);
+    put(w, num, snprintf(num, sizeof(num), "%" PRId64, v));
+}
+
+void json_uint(json_writer_t *w, const char *key, uint64_t v)
+{
+    char num[24];
+    member(w, key);
+    put(w, num, snprintf(num, sizeof(num), "%" PRIu64, v));
+}
+
+void json_bool(json_writer_t *w, const char *key, bool v)
+{
+    member(w, key);
+    put(w, v ? "true" : "false", v ? 4 : 5);
+}
+
+void json_str(json_writer_t *w, const char *key, const char *s)
+{
+    member(w, key);
+    put_string(w, s ? s : "");
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Streaming JSON emitter for HTTP responses.  Output collects in a small
+// buffer inside the writer (on the handler's stack) and goes out with
+// httpd_resp_send_chunk() whenever it fills, so a response never exists in
+// memory as a whole and nothing is allocated.
+//
+// Members of an object take a key; array elements and the top-level value
+// pass NULL.  A send error is sticky: later calls do nothing and
+// json_end() returns it.
+
+#define JSON_WRITER_BUF     256
+#define JSON_WRITER_DEPTH   16
+
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t    err;
+    uint16_t     len;
+    uint8_t      depth;
+    uint32_t     started;       // bit per depth: the container has a value already
+    char         buf[JSON_WRITER_BUF];
+} json_writer_t;
+
+// Set the JSON content type and CORS header; nothing is sent yet.
+void json_begin(json_writer_t *w, httpd_req_t *req);
+
+// Flush and finish the chunked response.
+esp_err_t json_end(json_writer_t *w);
+
+void json_obj_open(json_writer_t *w, const char *key);
+void json_obj_close(json_writer_t *w);
+void json_arr_open(json_writer_t *w, const char *key);
+void json_arr_close(json_writer_t *w);
+
+void json_int(json_writer_t *w, const char *key, int64_t v);
+void json_uint(json_writer_t *w, const char *key, uint64_t v);
+void json_bool(json_writer_t *w, const char *key, bool v);
+void json_str(json_writer_t *w, const char *key, const char *s);
@@ -8,6 +8,13 @@
 
 static const char *TAG = "web_server";
 
+// Sockets the HTTP server may hold open: every WebSocket client of the three
+// endpoints, plus a few concurrent REST requests.  httpd needs three more
+// for itself, within LWIP_MAX_SOCKETS.
+#define WEB_REST_SOCKETS    4
+#define WEB_WANT_SOCKETS    (3 * CONFIG_VUART_WS_MAX_CLIENTS + WEB_REST_SOCKETS)
+#define WEB_MAX_SOCKETS     (CONFIG_LWIP_MAX_SOCKETS - 3)
+
 static httpd_handle_t server = NULL;
 
 // Forward declarations from api_handler.c
@@ -15,7 +22,11 @@ esp_err_t api_get_ports_handler(httpd_req_t *req);
 esp_err_t api_put_port_config_handler(httpd_req_t *req);
 esp_err_t api_get_routes_handler(httpd_req_t *req);
 esp_err_t api_put_routes_handler(httpd_req_t *req);
+esp_err_t api_put_route_handler(httpd_req_t *req);
 esp_err_t api_delete_route_handler(httpd_req_t *req);
+esp_err_t api_get_latency_handler(httpd_req_t *req);
+esp_err_t api_post_latency_reset_handler(httpd_req_t *req);
+esp_err_t api_get_metrics_handler(httpd_req_t *req);
 esp_err_t api_get_config_handler(httpd_req_t *req);
 esp_err_t api_put_config_handler(httpd_req_t *req);
 esp_err_t api_post_config_reset_handler(httpd_req_t *req);
@@ -24,8 +35,10 @@ esp_err_t api_get_system_handler(httpd_req_t *req);
 // Forward declarations from ws_handler.c
 esp_err_t ws_signals_handler(httpd_req_t *req);
 esp_err_t ws_monitor_handler(httpd_req_t *req);
+esp_err_t ws_tap_handler(httpd_req_t *req);
 void ws_init(httpd_handle_t server_handle);
 void ws_cleanup(void);
+void ws_close_fd(httpd_handle_t hd, int sockfd);
 
 // Content-type lookup
 static const char *get_content_type(const char *path)
@@ -235,6 +248,12 @@ esp_err_t web_server_start(void)
     config.max_uri_handlers = 24;
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.stack_size = 8192;
+    config.max_open_sockets = WEB_WANT_SOCKETS < WEB_MAX_SOCKETS ? WEB_WANT_SOCKETS : WEB_MAX_SOCKETS;
+    config.lru_purge_enable = true;     // a new connection evicts the least recently used
+    config.close_fn = ws_close_fd;      // which unsubscribes it if it was a WebSocket client
+    if (WEB_WANT_SOCKETS > WEB_MAX_SOCKETS) {
+        ESP_LOGW(TAG, "LWIP_MAX_SOCKETS allows %d of %d HTTP sockets", WEB_MAX_SOCKETS, WEB_WANT_SOCKETS);
+    }
 
     esp_err_t ret = httpd_start(&server, &config);
     if (ret != ESP_OK) {
@@ -285,6 +304,13 @@ esp_err_t web_server_start(void)
     };
     httpd_register_uri_handler(server, &routes_put_uri);
 
+    httpd_uri_t route_put_uri = {
+        .uri = "/api/routes/*",
+        .method = HTTP_PUT,
+        .handler = api_put_route_handler,
+    };
+    httpd_register_uri_handler(server, &route_put_uri);
+
     httpd_uri_t route_delete_uri = {
         .uri = "/api/routes/*",
         .method = HTTP_DELETE,
@@ -292,6 +318,28 @@ esp_err_t web_server_start(void)
     };
     httpd_register_uri_handler(server, &route_delete_uri);
 
+    // Forwarding latency
+    httpd_uri_t latency_get_uri = {
+        .uri = "/api/latency",
+        .method = HTTP_GET,
+        .handler = api_get_latency_handler,
+    };
+    httpd_register_uri_handler(server, &latency_get_uri);
+
+    httpd_uri_t latency_reset_uri = {
+        .uri = "/api/latency/reset",
+        .method = HTTP_POST,
+        .handler = api_post_latency_reset_handler,
+    };
+    httpd_register_uri_handler(server, &latency_reset_uri);
+
+    httpd_uri_t metrics_uri = {
+        .uri = "/api/metrics",
+        .method = HTTP_GET,
+        .handler = api_get_metrics_handler,
+    };
+    httpd_register_uri_handler(server, &metrics_uri);
+
     // Config
     httpd_uri_t config_get_uri = {
         .uri = "/api/config",
@@ -331,6 +379,14 @@ esp_err_t web_server_start(void)
     };
     httpd_register_uri_handler(server, &ws_monitor_uri);
 
+    httpd_uri_t ws_tap_uri = {
+        .uri = "/ws/tap",
+        .method = HTTP_GET,
+        .handler = ws_tap_handler,
+        .is_websocket = true,
+    };
+    httpd_register_uri_handler(server, &ws_tap_uri);
+
     // Static file serving (wildcard catch-all, includes captive portal logic)
     httpd_uri_t static_uri = {
         .uri = "/*",
@@ -366,3 +422,15 @@ void web_server_notify_data_flow(uint8_t route_id, uint32_t bytes_src_to_dst, ui
     extern void ws_broadcast_data_flow(uint8_t route_id, uint32_t bytes_src_to_dst, uint32_t bytes_dst_to_src);
     ws_broadcast_data_flow(route_id, bytes_src_to_dst, bytes_dst_to_src);
 }
+
+void web_server_get_ws_stats(web_server_ws_stats_t *out)
+{
+    extern void ws_get_stats(web_server_ws_stats_t *out);
+    ws_get_stats(out);
+}
+
+void web_server_reset_ws_latency(void)
+{
+    extern void ws_reset_latency(void);
+    ws_reset_latency();
+}
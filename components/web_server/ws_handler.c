@@ -1,90 +1,505 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
-#include "cJSON.h"
+#include "esp_heap_caps.h"
+#include "buf_pool.h"
+#include "port_registry.h"
+#include "port_tap.h"
+#include "esp_timer.h"
+#include "web_server.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 static const char *TAG = "ws_handler";
 
-#define WS_MAX_CLIENTS 4
+#define WS_MAX_CLIENTS      CONFIG_VUART_WS_MAX_CLIENTS     // per endpoint
+#define WS_CLIENT_QUEUE     CONFIG_VUART_WS_CLIENT_QUEUE
+#define WS_FRAME_MAX        1024
+#define WS_FRAME_COUNT      (WS_MAX_CLIENTS * 4 + 8)
+#define WS_SEND_RETRIES     3       // consecutive send errors before a client is dropped
+
+_Static_assert(WS_FRAME_MAX >= 64 + PORT_MAX_COUNT * 40, "WS_FRAME_MAX too small for a signal snapshot");
+
+// Clients choose the encoding with the query string: /ws/signals?fmt=bin.
+// JSON text stays the default.
+//
+// Binary frames are little-endian: an 8-byte header, then fixed records.
+//   header        u8 version, u8 kind, u16 record count, u32 seq
+//   SIGNALS(_FULL) u8 port id, u8 changed bits, u8 their values, u8 0
+//   FLOW          u8 route id, u8[3] 0, u32 bytes src->dst, u32 bytes dst->src
+#define WS_BIN_VERSION          1
+#define WS_BIN_SIGNALS          1
+#define WS_BIN_SIGNALS_FULL     2
+#define WS_BIN_FLOW             3
+#define WS_BIN_TAP              4
+#define WS_BIN_HEADER           8
+
+// ---------------------------------------------------------------------------
+// Outgoing frames
+//
+// Producers encode a message once per format into a pooled, reference
+// counted frame and queue a reference on each client, then return; the
+// ws_tx task does the socket writes.  A full client queue never blocks the
+// producer: a frame with a coalescing key replaces the queued one with the
+// same key (counters, latest value wins), anything else is dropped and
+// counted.  Signal deltas are numbered, so a client that lost one resyncs.
+// ---------------------------------------------------------------------------
+
+typedef struct ws_frame {
+    struct ws_frame *next;      // free list
+    uint16_t refs;
+    uint16_t len;
+    uint16_t key;               // coalescing key, 0 = never superseded
+    bool     binary;
+    uint8_t  data[WS_FRAME_MAX];
+} ws_frame_t;
 
 typedef struct {
-    int fd;
-    bool active;
+    int         fd;
+    bool        active;
+    bool        binary;
+    uint8_t     failures;       // consecutive send errors
+    uint8_t     head;
+    uint8_t     count;
+    ws_frame_t *queue[WS_CLIENT_QUEUE];
 } ws_client_t;
 
 static httpd_handle_t ws_server = NULL;
 static ws_client_t signal_clients[WS_MAX_CLIENTS];
 static ws_client_t monitor_clients[WS_MAX_CLIENTS];
+static SemaphoreHandle_t ws_mutex;          // everything below but sig_lock's fields
+static ws_frame_t *frame_pool;
+static ws_frame_t *frame_free;
+static web_server_ws_stats_t ws_stats;
+static latency_hist_t ws_produce;           // producers take ws_mutex, one at a time
+static TaskHandle_t tx_task;
+
+// Signal deltas.  Reported changes are collected for one window and sent as
+// a single message with the ports and bits that changed since the previous
+// one.  Messages are numbered; a client that sees a gap asks for a snapshot.
+static portMUX_TYPE sig_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t sig_state[PORT_MAX_COUNT];  // latest reported, under sig_lock
+static uint32_t sig_pending;                // ports reported this window
+static uint32_t sig_sent[PORT_MAX_COUNT];   // as of message sig_seq
+static uint32_t sig_seq;
+static uint32_t flow_seq;
+static TaskHandle_t sig_task;
+
+static void signal_flush_task(void *arg);
+static void ws_tx_task(void *arg);
+static void tap_release_all(void);
+static ws_client_t *client_slot(int n);
+static void client_dropped(int n);
+
+static ws_frame_t *frame_get(bool binary, uint16_t key)
+{
+    ws_frame_t *f = frame_free;
+    if (!f) {
+        ws_stats.dropped++;
+        return NULL;
+    }
+    frame_free = f->next;
+    f->refs   = 1;
+    f->len    = 0;
+    f->key    = key;
+    f->binary = binary;
+    return f;
+}
+
+static void frame_put(ws_frame_t *f)
+{
+    if (f && --f->refs == 0) {
+        f->next = frame_free;
+        frame_free = f;
+    }
+}
+
+// Queue a reference to f.  False if the queue is full.
+static bool client_push(ws_client_t *c, ws_frame_t *f)
+{
+    if (f->key) {
+        for (int i = 0; i < c->count; i++) {
+            ws_frame_t **q = &c->queue[(c->head + i) % WS_CLIENT_QUEUE];
+            if ((*q)->key == f->key) {
+                frame_put(*q);
+                *q = f;
+                f->refs++;
+                ws_stats.coalesced++;
+                return true;
+            }
+        }
+    }
+    if (c->count == WS_CLIENT_QUEUE) {
+        ws_stats.dropped++;
+        return false;
+    }
+    c->queue[(c->head + c->count++) % WS_CLIENT_QUEUE] = f;
+    f->refs++;
+    if (tx_task) xTaskNotifyGive(tx_task);
+    return true;
+}
+
+static void client_reset(ws_client_t *c)
+{
+    while (c->count) {
+        frame_put(c->queue[c->head]);
+        c->head = (c->head + 1) % WS_CLIENT_QUEUE;
+        c->count--;
+    }
+    c->active = false;
+}
 
 void ws_init(httpd_handle_t server_handle)
 {
+    if (!ws_mutex) {
+        ws_mutex = xSemaphoreCreateMutex();
+        frame_pool = heap_caps_calloc(WS_FRAME_COUNT, sizeof(ws_frame_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!ws_mutex || !frame_pool ||
+            xTaskCreate(ws_tx_task, "ws_tx", 3072, NULL, 4, &tx_task) != pdPASS ||
+            xTaskCreate(signal_flush_task, "ws_sig", 3072, NULL, 4, &sig_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to start WebSocket tasks");
+        }
+        for (int i = 0; frame_pool && i < WS_FRAME_COUNT; i++) {
+            frame_pool[i].next = frame_free;
+            frame_free = &frame_pool[i];
+        }
+    }
+
+    if (ws_mutex) xSemaphoreTake(ws_mutex, portMAX_DELAY);
     ws_server = server_handle;
-    memset(signal_clients, 0, sizeof(signal_clients));
-    memset(monitor_clients, 0, sizeof(monitor_clients));
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        client_reset(&signal_clients[i]);
+        client_reset(&monitor_clients[i]);
+    }
+
+    // No client has seen anything yet: start from the current state.
+    taskENTER_CRITICAL(&sig_lock);
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        port_t *port = port_registry_get(i);
+        if (port) sig_state[i] = port_get_effective_signals(port);
+        sig_sent[i] = sig_state[i];
+    }
+    sig_pending = 0;
+    taskEXIT_CRITICAL(&sig_lock);
+    if (ws_mutex) xSemaphoreGive(ws_mutex);
 }
 
 void ws_cleanup(void)
 {
+    if (ws_mutex) xSemaphoreTake(ws_mutex, portMAX_DELAY);
+    tap_release_all();
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        client_reset(&signal_clients[i]);
+        client_reset(&monitor_clients[i]);
+    }
     ws_server = NULL;
-    memset(signal_clients, 0, sizeof(signal_clients));
-    memset(monitor_clients, 0, sizeof(monitor_clients));
+    if (ws_mutex) xSemaphoreGive(ws_mutex);
+}
+
+void ws_get_stats(web_server_ws_stats_t *out)
+{
+    xSemaphoreTake(ws_mutex, portMAX_DELAY);
+    *out = ws_stats;
+    out->clients = 0;
+    for (int n = 0; client_slot(n); n++) {
+        if (client_slot(n)->active) out->clients++;
+    }
+    xSemaphoreGive(ws_mutex);
+    latency_hist_summary(&ws_produce, &out->produce);
+}
+
+void ws_reset_latency(void)
+{
+    latency_hist_reset(&ws_produce);
 }
 
-static void add_client(ws_client_t *list, int fd)
+static bool wants_binary(httpd_req_t *req)
+{
+    char query[32], fmt[8];
+    return httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+           httpd_query_key_value(query, "fmt", fmt, sizeof(fmt)) == ESP_OK &&
+           strcmp(fmt, "bin") == 0;
+}
+
+static ws_client_t *add_client(ws_client_t *list, int fd, bool binary)
 {
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (list[i].active && list[i].fd == fd) return &list[i];
+    }
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
         if (!list[i].active) {
             list[i].fd = fd;
+            list[i].binary = binary;
+            list[i].failures = 0;
             list[i].active = true;
-            ESP_LOGI(TAG, "WS client connected: fd=%d (slot %d)", fd, i);
-            return;
+            ESP_LOGI(TAG, "WS client connected: fd=%d (slot %d, %s)", fd, i, binary ? "binary" : "json");
+            return &list[i];
         }
     }
     ESP_LOGW(TAG, "WS client rejected: no free slots");
+    return NULL;
+}
+
+// A client sending on an open socket: its slot, reactivated in the format
+// it chose at the handshake if it was dropped after send errors.  NULL if
+// the slot has since gone to another client.
+static ws_client_t *rejoin_client(ws_client_t *list, int fd)
+{
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (list[i].active && list[i].fd == fd) return &list[i];
+    }
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (!list[i].active && list[i].fd == fd) {
+            list[i].failures = 0;
+            list[i].active = true;
+            ESP_LOGI(TAG, "WS client rejoined: fd=%d (slot %d, %s)", fd, i,
+                     list[i].binary ? "binary" : "json");
+            return &list[i];
+        }
+    }
+    return NULL;
 }
 
 static void remove_client(ws_client_t *list, int fd)
 {
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
         if (list[i].active && list[i].fd == fd) {
-            list[i].active = false;
+            client_reset(&list[i]);
+            list[i].fd = -1;
             ESP_LOGI(TAG, "WS client disconnected: fd=%d (slot %d)", fd, i);
             return;
         }
     }
 }
 
-static void broadcast(ws_client_t *list, const char *data, size_t len)
+static bool has_clients(const ws_client_t *list, bool binary)
 {
-    if (!ws_server) return;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (list[i].active && list[i].binary == binary) return true;
+    }
+    return false;
+}
+
+// Queue each client the frame in its format and drop the producer's
+// references.  ws_mutex held.
+static void broadcast(ws_client_t *list, ws_frame_t *json, ws_frame_t *bin)
+{
+    for (int i = 0; ws_server && i < WS_MAX_CLIENTS; i++) {
+        if (!list[i].active) continue;
+        ws_frame_t *f = list[i].binary ? bin : json;
+        if (f) client_push(&list[i], f);
+    }
+    frame_put(json);
+    frame_put(bin);
+}
 
-    httpd_ws_frame_t frame = {
-        .type = HTTPD_WS_TYPE_TEXT,
-        .payload = (uint8_t *)data,
-        .len = len,
-    };
+// ---------------------------------------------------------------------------
+// Encoders.  ws_mutex held.
+// ---------------------------------------------------------------------------
 
-    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (list[i].active) {
-            esp_err_t ret = httpd_ws_send_frame_async(ws_server, list[i].fd, &frame);
-            if (ret != ESP_OK) {
-                ESP_LOGD(TAG, "WS send failed fd=%d: %s", list[i].fd, esp_err_to_name(ret));
-                list[i].active = false;
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static int bin_header(uint8_t *buf, uint8_t kind, uint16_t count, uint32_t seq)
+{
+    buf[0] = WS_BIN_VERSION;
+    buf[1] = kind;
+    put_u16(&buf[2], count);
+    put_u32(&buf[4], seq);
+    return WS_BIN_HEADER;
+}
+
+// Every port in mask with the bits in changed[] and their values.
+static void encode_signals_json(ws_frame_t *f, uint32_t seq, bool full, uint32_t mask,
+                                const uint32_t *changed, const uint32_t *value)
+{
+    char  *buf  = (char *)f->data;
+    size_t size = sizeof(f->data);
+    int n = snprintf(buf, size, "{\"type\":\"signals\",\"seq\":%lu%s,\"ports\":[",
+                     (unsigned long)seq, full ? ",\"full\":true" : "");
+    const char *sep = "";
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        if (!(mask & (1u << i))) continue;
+        n += snprintf(buf + n, size - n, "%s{\"id\":%d,\"changed\":%lu,\"value\":%lu}", sep, i,
+                      (unsigned long)changed[i], (unsigned long)(value[i] & changed[i]));
+        sep = ",";
+    }
+    n += snprintf(buf + n, size - n, "]}");
+    f->len = n;
+}
+
+static void encode_signals_bin(ws_frame_t *f, uint32_t seq, bool full, uint32_t mask,
+                               const uint32_t *changed, const uint32_t *value)
+{
+    int n = WS_BIN_HEADER;
+    uint16_t count = 0;
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        if (!(mask & (1u << i))) continue;
+        f->data[n++] = i;
+        f->data[n++] = changed[i];
+        f->data[n++] = value[i] & changed[i];
+        f->data[n++] = 0;
+        count++;
+    }
+    bin_header(f->data, full ? WS_BIN_SIGNALS_FULL : WS_BIN_SIGNALS, count, seq);
+    f->len = n;
+}
+
+// Queue c the current state of every port, as of message sig_seq.
+static void send_snapshot(ws_client_t *c)
+{
+    uint32_t all[PORT_MAX_COUNT];
+    uint32_t mask = 0;
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        all[i] = SIGNAL_DTR | SIGNAL_RTS | SIGNAL_CTS | SIGNAL_DSR | SIGNAL_DCD | SIGNAL_RI;
+        if (port_registry_get(i)) mask |= 1u << i;
+    }
+
+    ws_frame_t *f = frame_get(c->binary, 0);
+    if (!f) return;
+    if (c->binary) {
+        encode_signals_bin(f, sig_seq, true, mask, all, sig_sent);
+    } else {
+        encode_signals_json(f, sig_seq, true, mask, all, sig_sent);
+    }
+    client_push(c, f);
+    frame_put(f);
+}
+
+static void signal_flush_task(void *arg)
+{
+    uint32_t state[PORT_MAX_COUNT];
+    uint32_t changed[PORT_MAX_COUNT];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_VUART_WS_SIGNAL_WINDOW_MS));
+
+        taskENTER_CRITICAL(&sig_lock);
+        uint32_t pending = sig_pending;
+        sig_pending = 0;
+        memcpy(state, sig_state, sizeof(state));
+        taskEXIT_CRITICAL(&sig_lock);
+
+        int64_t t0 = esp_timer_get_time();
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        uint32_t mask = 0;
+        for (int i = 0; i < PORT_MAX_COUNT; i++) {
+            changed[i] = (pending & (1u << i)) ? state[i] ^ sig_sent[i] : 0;
+            if (changed[i]) mask |= 1u << i;
+        }
+        if (mask) {
+            sig_seq++;
+            memcpy(sig_sent, state, sizeof(sig_sent));
+            ws_frame_t *json = NULL, *bin = NULL;
+            if (has_clients(signal_clients, false) && (json = frame_get(false, 0))) {
+                encode_signals_json(json, sig_seq, false, mask, changed, state);
             }
+            if (has_clients(signal_clients, true) && (bin = frame_get(true, 0))) {
+                encode_signals_bin(bin, sig_seq, false, mask, changed, state);
+            }
+            broadcast(signal_clients, json, bin);
+            latency_hist_record(&ws_produce, (uint32_t)(esp_timer_get_time() - t0));
         }
+        xSemaphoreGive(ws_mutex);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sender: one frame per client per pass, so a slow socket only delays the
+// others by one write.
+// ---------------------------------------------------------------------------
+
+static void ws_tx_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        bool sent;
+        do {
+            sent = false;
+            for (int n = 0; client_slot(n); n++) {
+                xSemaphoreTake(ws_mutex, portMAX_DELAY);
+                ws_client_t *c = client_slot(n);
+                ws_frame_t *f = NULL;
+                int fd = c->fd;
+                httpd_handle_t server = ws_server;
+                if (c->active && c->count) {
+                    f = c->queue[c->head];
+                    c->head = (c->head + 1) % WS_CLIENT_QUEUE;
+                    c->count--;
+                }
+                xSemaphoreGive(ws_mutex);
+                if (!f) continue;
+
+                httpd_ws_frame_t frame = {
+                    .type = f->binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+                    .payload = f->data,
+                    .len = f->len,
+                };
+                // The fd may already belong to a plain HTTP connection if the
+                // socket was closed before ws_close_fd() ran.
+                esp_err_t ret = !server ? ESP_ERR_INVALID_STATE
+                              : httpd_ws_get_fd_info(server, fd) != HTTPD_WS_CLIENT_WEBSOCKET ? ESP_ERR_NOT_FOUND
+                              : httpd_ws_send_frame_async(server, fd, &frame);
+
+                xSemaphoreTake(ws_mutex, portMAX_DELAY);
+                if (ret == ESP_OK) {
+                    if (f->binary) {
+                        ws_stats.binary_frames++;
+                    } else {
+                        ws_stats.json_frames++;
+                    }
+                    ws_stats.bytes += f->len;
+                    if (c->fd == fd) c->failures = 0;
+                } else {
+                    ESP_LOGD(TAG, "WS send failed fd=%d: %s", fd, esp_err_to_name(ret));
+                    ws_stats.send_errors++;
+                    if (c->active && c->fd == fd && ++c->failures >= WS_SEND_RETRIES) client_dropped(n);
+                }
+                frame_put(f);
+                xSemaphoreGive(ws_mutex);
+                sent = true;
+            }
+        } while (sent);
     }
 }
 
 // WebSocket handler for /ws/signals
 esp_err_t ws_signals_handler(httpd_req_t *req)
 {
+    int fd = httpd_req_to_sockfd(req);
+
     if (req->method == HTTP_GET) {
-        // WebSocket handshake
-        ESP_LOGI(TAG, "WS /ws/signals handshake, fd=%d", httpd_req_to_sockfd(req));
+        // WebSocket handshake: the client is subscribed from here on and
+        // starts from a snapshot.
+        bool binary = wants_binary(req);
+        ESP_LOGI(TAG, "WS /ws/signals handshake, fd=%d", fd);
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        ws_client_t *c = add_client(signal_clients, fd, binary);
+        if (c) send_snapshot(c);
+        xSemaphoreGive(ws_mutex);
         return ESP_OK;
     }
 
-    // Receive frame (client might send ping/pong or close)
+    // Receive frame (client might send ping/pong, close or a resync request)
     httpd_ws_frame_t frame;
     memset(&frame, 0, sizeof(frame));
     frame.type = HTTPD_WS_TYPE_TEXT;
@@ -95,41 +510,45 @@ esp_err_t ws_signals_handler(httpd_req_t *req)
     }
 
     if (frame.type == HTTPD_WS_TYPE_CLOSE) {
-        remove_client(signal_clients, httpd_req_to_sockfd(req));
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        remove_client(signal_clients, fd);
+        xSemaphoreGive(ws_mutex);
         return ESP_OK;
     }
 
-    // If it's the first real frame, register the client
-    int fd = httpd_req_to_sockfd(req);
-    bool found = false;
-    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (signal_clients[i].active && signal_clients[i].fd == fd) {
-            found = true;
-            break;
-        }
-    }
-    if (!found) {
-        add_client(signal_clients, fd);
-    }
-
-    // Allocate buffer if frame has payload
+    bool resync = false;
     if (frame.len > 0) {
-        uint8_t *buf = malloc(frame.len + 1);
-        if (buf) {
-            frame.payload = buf;
-            httpd_ws_recv_frame(req, &frame, frame.len);
-            free(buf);
+        uint8_t *buf = buf_pool_take(frame.len + 1);
+        if (!buf) {
+            ESP_LOGW(TAG, "WS fd=%d: no buffer for %d-byte frame", fd, (int)frame.len);
+            return ESP_ERR_NO_MEM;
         }
+        frame.payload = buf;
+        if (httpd_ws_recv_frame(req, &frame, frame.len) == ESP_OK && frame.type == HTTPD_WS_TYPE_TEXT) {
+            buf[frame.len] = '\0';
+            resync = strstr((char *)buf, "resync") != NULL;
+        }
+        buf_pool_give(buf);
     }
 
+    xSemaphoreTake(ws_mutex, portMAX_DELAY);
+    ws_client_t *c = rejoin_client(signal_clients, fd);
+    if (c && resync) send_snapshot(c);
+    xSemaphoreGive(ws_mutex);
     return ESP_OK;
 }
 
 // WebSocket handler for /ws/monitor
 esp_err_t ws_monitor_handler(httpd_req_t *req)
 {
+    int fd = httpd_req_to_sockfd(req);
+
     if (req->method == HTTP_GET) {
-        ESP_LOGI(TAG, "WS /ws/monitor handshake, fd=%d", httpd_req_to_sockfd(req));
+        ESP_LOGI(TAG, "WS /ws/monitor handshake, fd=%d", fd);
+        bool binary = wants_binary(req);
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        add_client(monitor_clients, fd, binary);
+        xSemaphoreGive(ws_mutex);
         return ESP_OK;
     }
 
@@ -143,71 +562,394 @@ esp_err_t ws_monitor_handler(httpd_req_t *req)
     }
 
     if (frame.type == HTTPD_WS_TYPE_CLOSE) {
-        remove_client(monitor_clients, httpd_req_to_sockfd(req));
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        remove_client(monitor_clients, fd);
+        xSemaphoreGive(ws_mutex);
         return ESP_OK;
     }
 
-    int fd = httpd_req_to_sockfd(req);
-    bool found = false;
+    xSemaphoreTake(ws_mutex, portMAX_DELAY);
+    rejoin_client(monitor_clients, fd);
+    xSemaphoreGive(ws_mutex);
+
+    if (frame.len > 0) {
+        uint8_t *buf = buf_pool_take(frame.len + 1);
+        if (!buf) {
+            ESP_LOGW(TAG, "WS fd=%d: no buffer for %d-byte frame", fd, (int)frame.len);
+            return ESP_ERR_NO_MEM;
+        }
+        frame.payload = buf;
+        httpd_ws_recv_frame(req, &frame, frame.len);
+        buf_pool_give(buf);
+    }
+
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Byte-stream tap: /ws/tap?port=<id>[&dir=rx|tx|both][&rate=<bytes/s>][&sample=<n>]
+//
+// The tap task reads chunks from the port tap ring and batches them per
+// client into binary frames:
+//   header   kind WS_BIN_TAP, seq = the client's frame number
+//   u32 bytes dropped (over budget, tap ring or client queue full),
+//   u32 bytes sampled out
+//   records  u8 port, u8 dir, u16 len, u32 us, then len bytes
+// Each client has a byte budget and may forward only one chunk in `sample`.
+// Chunks over budget are dropped and counted, so a slow browser loses tap
+// data but never holds up a port.
+// ---------------------------------------------------------------------------
+
+#define WS_TAP_PREFIX       (WS_BIN_HEADER + 8)
+#define WS_TAP_RECORD       8
+#define WS_TAP_FLUSH_MS     50
+
+typedef struct {
+    ws_client_t out;
+    uint8_t     port_id;
+    uint8_t     dirs;           // bit per PORT_TAP_RX / PORT_TAP_TX
+    uint32_t    rate;           // budget, bytes per second
+    uint32_t    burst;
+    uint32_t    tokens;
+    int64_t     refill_us;
+    uint32_t    sample;         // forward one chunk in sample
+    uint32_t    sample_ctr;
+    uint64_t    dropped;        // over budget or queue full
+    uint64_t    skipped;        // sampled out
+    uint64_t    lost_base[2];   // port_tap_lost() at subscription
+    uint64_t    reported;       // dropped + lost + skipped in the last frame
+    uint32_t    seq;
+    uint16_t    count;
+    ws_frame_t *batch;          // being filled
+} tap_client_t;
+
+static tap_client_t tap_clients[WS_MAX_CLIENTS];    // under ws_mutex
+static TaskHandle_t tap_task;
+
+// The n-th client slot across all endpoints, NULL past the end.
+static ws_client_t *client_slot(int n)
+{
+    if (n < WS_MAX_CLIENTS) return &signal_clients[n];
+    n -= WS_MAX_CLIENTS;
+    if (n < WS_MAX_CLIENTS) return &monitor_clients[n];
+    n -= WS_MAX_CLIENTS;
+    if (n < WS_MAX_CLIENTS) return &tap_clients[n].out;
+    return NULL;
+}
+
+static uint64_t tap_lost(const tap_client_t *c)
+{
+    uint64_t lost = 0;
+    for (int dir = PORT_TAP_RX; dir <= PORT_TAP_TX; dir++) {
+        if (c->dirs & (1u << dir)) lost += port_tap_lost(c->port_id, dir) - c->lost_base[dir];
+    }
+    return lost;
+}
+
+static void tap_remove(tap_client_t *c)
+{
+    for (int dir = PORT_TAP_RX; dir <= PORT_TAP_TX; dir++) {
+        if (c->dirs & (1u << dir)) port_tap_disable(c->port_id, dir);
+    }
+    c->dirs = 0;
+    frame_put(c->batch);
+    c->batch = NULL;
+    client_reset(&c->out);
+    ESP_LOGI(TAG, "WS tap closed: fd=%d port=%d", c->out.fd, c->port_id);
+}
+
+static void tap_release_all(void)
+{
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (monitor_clients[i].active && monitor_clients[i].fd == fd) {
-            found = true;
-            break;
+        if (tap_clients[i].out.active) tap_remove(&tap_clients[i]);
+    }
+}
+
+// Given up on client slot n after repeated send errors.  ws_mutex held.
+static void client_dropped(int n)
+{
+    ESP_LOGW(TAG, "WS client fd=%d dropped after %d send errors", client_slot(n)->fd, WS_SEND_RETRIES);
+    if (n >= 2 * WS_MAX_CLIENTS) {
+        tap_remove(&tap_clients[n - 2 * WS_MAX_CLIENTS]);
+    } else {
+        client_reset(client_slot(n));
+    }
+}
+
+// The HTTP server's close_fn: a socket is going away, whether the client
+// hung up or the server purged it to admit a new connection.  Forget the
+// fd in every list, so nothing is sent to the next connection that gets
+// the same number, then close it as the server would have.
+void ws_close_fd(httpd_handle_t hd, int fd)
+{
+    if (ws_mutex) {
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (tap_clients[i].out.active && tap_clients[i].out.fd == fd) tap_remove(&tap_clients[i]);
+            if (tap_clients[i].out.fd == fd) tap_clients[i].out.fd = -1;
         }
+        for (int n = 0; n < 2 * WS_MAX_CLIENTS; n++) {
+            ws_client_t *c = client_slot(n);
+            if (c->fd != fd) continue;
+            if (c->active) ESP_LOGI(TAG, "WS client closed: fd=%d", fd);
+            client_reset(c);
+            c->fd = -1;
+        }
+        xSemaphoreGive(ws_mutex);
     }
-    if (!found) {
-        add_client(monitor_clients, fd);
+    close(fd);
+}
+
+// Queue what the client has batched, or just news of more drops.  Returns
+// false, keeping the batch, while the client's queue is full.  ws_mutex held.
+static bool tap_flush(tap_client_t *c)
+{
+    uint64_t dropped = c->dropped + tap_lost(c);
+    if (!c->batch && dropped + c->skipped == c->reported) return true;
+    if (c->out.count == WS_CLIENT_QUEUE) return false;
+    if (!c->batch) {
+        c->batch = frame_get(true, 0);
+        if (!c->batch) return false;
+        c->batch->len = WS_TAP_PREFIX;
+        c->count = 0;
     }
 
-    if (frame.len > 0) {
-        uint8_t *buf = malloc(frame.len + 1);
-        if (buf) {
-            frame.payload = buf;
-            httpd_ws_recv_frame(req, &frame, frame.len);
-            free(buf);
+    ws_frame_t *f = c->batch;
+    bin_header(f->data, WS_BIN_TAP, c->count, ++c->seq);
+    put_u32(&f->data[8], (uint32_t)dropped);
+    put_u32(&f->data[12], (uint32_t)c->skipped);
+    client_push(&c->out, f);
+    frame_put(f);
+    c->batch = NULL;
+    c->reported = dropped + c->skipped;
+    return true;
+}
+
+static void tap_refill(tap_client_t *c, int64_t now)
+{
+    int64_t dt = now - c->refill_us;
+    if (dt <= 0) return;
+    uint64_t add = (uint64_t)dt * c->rate / 1000000;
+    if (add == 0) return;
+    c->refill_us += (int64_t)(add * 1000000 / c->rate);
+    c->tokens = add >= c->burst - c->tokens ? c->burst : c->tokens + add;
+}
+
+// ws_mutex held.
+static void tap_offer(tap_client_t *c, const port_tap_chunk_t *chunk, const uint8_t *data, int64_t now)
+{
+    if (chunk->port_id != c->port_id || !(c->dirs & (1u << chunk->dir))) return;
+
+    if (++c->sample_ctr < c->sample) {
+        c->skipped += chunk->len;
+        return;
+    }
+    c->sample_ctr = 0;
+
+    uint32_t cost = WS_TAP_RECORD + chunk->len;
+    tap_refill(c, now);
+    if (cost > c->tokens) {
+        c->dropped += chunk->len;
+        return;
+    }
+
+    if (c->batch && c->batch->len + cost > WS_FRAME_MAX && !tap_flush(c)) {
+        c->dropped += chunk->len;
+        return;
+    }
+    if (!c->batch) {
+        c->batch = frame_get(true, 0);
+        if (!c->batch) {
+            c->dropped += chunk->len;
+            return;
         }
+        c->batch->len = WS_TAP_PREFIX;
+        c->count = 0;
     }
+    c->tokens -= cost;
 
+    uint8_t *p = &c->batch->data[c->batch->len];
+    p[0] = chunk->port_id;
+    p[1] = chunk->dir;
+    put_u16(&p[2], chunk->len);
+    put_u32(&p[4], chunk->us);
+    memcpy(&p[WS_TAP_RECORD], data, chunk->len);
+    c->batch->len += cost;
+    c->count++;
+}
+
+static void tap_task_fn(void *arg)
+{
+    static uint8_t data[PORT_TAP_CHUNK_MAX];
+    port_tap_chunk_t chunk;
+    int64_t last_flush = esp_timer_get_time();
+
+    for (;;) {
+        bool got = port_tap_read(&chunk, data, pdMS_TO_TICKS(WS_TAP_FLUSH_MS));
+        int64_t now = esp_timer_get_time();
+
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        for (int i = 0; got && i < WS_MAX_CLIENTS; i++) {
+            if (tap_clients[i].out.active) tap_offer(&tap_clients[i], &chunk, data, now);
+        }
+        if (now - last_flush >= WS_TAP_FLUSH_MS * 1000) {
+            for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+                if (tap_clients[i].out.active) tap_flush(&tap_clients[i]);
+            }
+            last_flush = now;
+        }
+        xSemaphoreGive(ws_mutex);
+    }
+}
+
+static uint32_t query_u32(const char *query, const char *key, uint32_t def)
+{
+    char val[12];
+    if (httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK) return def;
+    return strtoul(val, NULL, 10);
+}
+
+// Subscribe fd as the query string asks.  ws_mutex held.
+static esp_err_t tap_subscribe(int fd, const char *query)
+{
+    uint32_t port_id = query_u32(query, "port", PORT_MAX_COUNT);
+    if (port_id >= PORT_MAX_COUNT || !port_registry_get(port_id)) {
+        ESP_LOGW(TAG, "WS tap fd=%d: no such port", fd);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char dir[8] = "rx";
+    httpd_query_key_value(query, "dir", dir, sizeof(dir));
+    uint8_t dirs = strcmp(dir, "tx") == 0   ? 1u << PORT_TAP_TX
+                 : strcmp(dir, "both") == 0 ? (1u << PORT_TAP_RX) | (1u << PORT_TAP_TX)
+                 :                            1u << PORT_TAP_RX;
+
+    tap_client_t *c = NULL;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (!tap_clients[i].out.active) { c = &tap_clients[i]; break; }
+    }
+    if (!c) {
+        ESP_LOGW(TAG, "WS tap fd=%d rejected: no free slots", fd);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!tap_task && xTaskCreate(tap_task_fn, "ws_tap", 3072, NULL, 3, &tap_task) != pdPASS) {
+        tap_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->out.fd     = fd;
+    c->out.binary = true;
+    c->port_id    = port_id;
+    c->rate       = query_u32(query, "rate", CONFIG_VUART_WS_TAP_RATE);
+    if (c->rate == 0 || c->rate > CONFIG_VUART_WS_TAP_RATE) c->rate = CONFIG_VUART_WS_TAP_RATE;
+    c->burst      = c->rate / 10;
+    if (c->burst < WS_TAP_RECORD + PORT_TAP_CHUNK_MAX) c->burst = WS_TAP_RECORD + PORT_TAP_CHUNK_MAX;
+    c->tokens     = c->burst;
+    c->refill_us  = esp_timer_get_time();
+    c->sample     = query_u32(query, "sample", 1);
+    if (c->sample == 0) c->sample = 1;
+
+    for (int d = PORT_TAP_RX; d <= PORT_TAP_TX; d++) {
+        if (!(dirs & (1u << d))) continue;
+        c->lost_base[d] = port_tap_lost(port_id, d);
+        if (port_tap_enable(port_id, d) != ESP_OK) {
+            tap_remove(c);
+            return ESP_ERR_NO_MEM;
+        }
+        c->dirs |= 1u << d;
+    }
+    c->out.active = true;
+    ESP_LOGI(TAG, "WS tap opened: fd=%d port=%lu dir=%s rate=%lu sample=%lu", fd,
+             (unsigned long)port_id, dir, (unsigned long)c->rate, (unsigned long)c->sample);
     return ESP_OK;
 }
 
-// Broadcast signal change to /ws/signals clients
-void ws_broadcast_signal(uint8_t port_id, uint32_t signals)
+// WebSocket handler for /ws/tap
+esp_err_t ws_tap_handler(httpd_req_t *req)
 {
-    cJSON *obj = cJSON_CreateObject();
-    cJSON_AddStringToObject(obj, "type", "signal");
-    cJSON_AddNumberToObject(obj, "portId", port_id);
+    int fd = httpd_req_to_sockfd(req);
 
-    cJSON *sigs = cJSON_CreateObject();
-    cJSON_AddBoolToObject(sigs, "dtr", (signals & (1 << 0)) != 0);
-    cJSON_AddBoolToObject(sigs, "rts", (signals & (1 << 1)) != 0);
-    cJSON_AddBoolToObject(sigs, "cts", (signals & (1 << 2)) != 0);
-    cJSON_AddBoolToObject(sigs, "dsr", (signals & (1 << 3)) != 0);
-    cJSON_AddBoolToObject(sigs, "dcd", (signals & (1 << 4)) != 0);
-    cJSON_AddBoolToObject(sigs, "ri",  (signals & (1 << 5)) != 0);
-    cJSON_AddItemToObject(obj, "signals", sigs);
+    if (req->method == HTTP_GET) {
+        char query[64] = "";
+        httpd_req_get_url_query_str(req, query, sizeof(query));
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        esp_err_t ret = tap_subscribe(fd, query);
+        xSemaphoreGive(ws_mutex);
+        return ret;
+    }
+
+    httpd_ws_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
 
-    char *str = cJSON_PrintUnformatted(obj);
-    if (str) {
-        broadcast(signal_clients, str, strlen(str));
-        free(str);
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) {
+        return ret;
     }
-    cJSON_Delete(obj);
+
+    if (frame.type == HTTPD_WS_TYPE_CLOSE) {
+        xSemaphoreTake(ws_mutex, portMAX_DELAY);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (tap_clients[i].out.active && tap_clients[i].out.fd == fd) tap_remove(&tap_clients[i]);
+        }
+        xSemaphoreGive(ws_mutex);
+        return ESP_OK;
+    }
+
+    // Nothing is expected from tap clients; discard what they send.
+    if (frame.len > 0) {
+        uint8_t *buf = buf_pool_take(frame.len);
+        if (!buf) return ESP_ERR_NO_MEM;
+        frame.payload = buf;
+        httpd_ws_recv_frame(req, &frame, frame.len);
+        buf_pool_give(buf);
+    }
+    return ESP_OK;
 }
 
-// Broadcast data flow stats to /ws/monitor clients
+// Record a port's signals; the flush task sends the delta after the window.
+void ws_broadcast_signal(uint8_t port_id, uint32_t signals)
+{
+    if (port_id >= PORT_MAX_COUNT) return;
+
+    taskENTER_CRITICAL(&sig_lock);
+    bool wake = !sig_pending;
+    sig_state[port_id] = signals;
+    sig_pending |= 1u << port_id;
+    taskEXIT_CRITICAL(&sig_lock);
+
+    if (wake && sig_task) xTaskNotifyGive(sig_task);
+}
+
+// Queue data flow stats for /ws/monitor clients.  A client that has not
+// taken the previous figures for this route yet gets the new ones instead.
 void ws_broadcast_data_flow(uint8_t route_id, uint32_t bytes_src_to_dst, uint32_t bytes_dst_to_src)
 {
-    cJSON *obj = cJSON_CreateObject();
-    cJSON_AddStringToObject(obj, "type", "dataFlow");
-    cJSON_AddNumberToObject(obj, "routeId", route_id);
-    cJSON_AddNumberToObject(obj, "bytesSrcToDst", bytes_src_to_dst);
-    cJSON_AddNumberToObject(obj, "bytesDstToSrc", bytes_dst_to_src);
+    if (!ws_mutex) return;
 
-    char *str = cJSON_PrintUnformatted(obj);
-    if (str) {
-        broadcast(monitor_clients, str, strlen(str));
-        free(str);
+    int64_t t0 = esp_timer_get_time();
+    uint16_t key = (WS_BIN_FLOW << 8) | route_id;
+    xSemaphoreTake(ws_mutex, portMAX_DELAY);
+    flow_seq++;
+    ws_frame_t *json = NULL, *bin = NULL;
+    if (has_clients(monitor_clients, false) && (json = frame_get(false, key))) {
+        json->len = snprintf((char *)json->data, sizeof(json->data),
+                             "{\"type\":\"dataFlow\",\"routeId\":%d,\"bytesSrcToDst\":%lu,\"bytesDstToSrc\":%lu}",
+                             route_id, (unsigned long)bytes_src_to_dst, (unsigned long)bytes_dst_to_src);
+    }
+    if (has_clients(monitor_clients, true) && (bin = frame_get(true, key))) {
+        int n = bin_header(bin->data, WS_BIN_FLOW, 1, flow_seq);
+        bin->data[n++] = route_id;
+        memset(&bin->data[n], 0, 3);
+        n += 3;
+        put_u32(&bin->data[n], bytes_src_to_dst);
+        put_u32(&bin->data[n + 4], bytes_dst_to_src);
+        bin->len = n + 8;
+    }
+    if (json || bin) {
+        broadcast(monitor_clients, json, bin);
+        latency_hist_record(&ws_produce, (uint32_t)(esp_timer_get_time() - t0));
     }
-    cJSON_Delete(obj);
+    xSemaphoreGive(ws_mutex);
 }
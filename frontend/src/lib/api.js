@@ -61,19 +61,102 @@ export async function fetchSystem() {
   return res.json();
 }
 
-// WebSocket connections
-export function connectSignals(onMessage) {
+// WebSocket connections. Both ask for the binary encoding (?fmt=bin);
+// decodeFrame() turns its frames into the same messages as the JSON one.
+const WS_BIN_VERSION = 1;
+const WS_BIN_SIGNALS = 1;
+const WS_BIN_SIGNALS_FULL = 2;
+const WS_BIN_FLOW = 3;
+const WS_BIN_TAP = 4;
+
+// Little-endian: u8 version, u8 kind, u16 count, u32 seq, then fixed records.
+export function decodeFrame(data) {
+  if (typeof data === 'string') return [JSON.parse(data)];
+
+  const v = new DataView(data);
+  if (v.byteLength < 8 || v.getUint8(0) !== WS_BIN_VERSION) return [];
+  const kind = v.getUint8(1);
+  const count = v.getUint16(2, true);
+  const seq = v.getUint32(4, true);
+
+  if (kind === WS_BIN_SIGNALS || kind === WS_BIN_SIGNALS_FULL) {
+    const ports = [];
+    for (let i = 0, off = 8; i < count && off + 4 <= v.byteLength; i++, off += 4) {
+      ports.push({ id: v.getUint8(off), changed: v.getUint8(off + 1), value: v.getUint8(off + 2) });
+    }
+    return [{ type: 'signals', seq, full: kind === WS_BIN_SIGNALS_FULL, ports }];
+  }
+  if (kind === WS_BIN_FLOW) {
+    const msgs = [];
+    for (let i = 0, off = 8; i < count && off + 12 <= v.byteLength; i++, off += 12) {
+      msgs.push({
+        type: 'dataFlow',
+        routeId: v.getUint8(off),
+        bytesSrcToDst: v.getUint32(off + 4, true),
+        bytesDstToSrc: v.getUint32(off + 8, true),
+      });
+    }
+    return msgs;
+  }
+  if (kind === WS_BIN_TAP && v.byteLength >= 16) {
+    const chunks = [];
+    let off = 16;
+    for (let i = 0; i < count && off + 8 <= v.byteLength; i++) {
+      const len = v.getUint16(off + 2, true);
+      chunks.push({
+        portId: v.getUint8(off),
+        dir: v.getUint8(off + 1) ? 'tx' : 'rx',
+        us: v.getUint32(off + 4, true),
+        data: new Uint8Array(data, off + 8, len),
+      });
+      off += 8 + len;
+    }
+    return [{
+      type: 'tap', seq,
+      dropped: v.getUint32(8, true),
+      skipped: v.getUint32(12, true),
+      chunks,
+    }];
+  }
+  return [];
+}
+
+function openSocket(path) {
   const proto = location.protocol === 'https:' ? 'wss:' : 'ws:';
-  const ws = new WebSocket(`${proto}//${location.host}/ws/signals`);
-  ws.onmessage = (e) => onMessage(JSON.parse(e.data));
+  const ws = new WebSocket(`${proto}//${location.host}${path}?fmt=bin`);
+  ws.binaryType = 'arraybuffer';
+  return ws;
+}
+
+export function connectSignals(onMessage) {
+  const ws = openSocket('/ws/signals');
+  // The server sends a snapshot on connect and deltas after that; a handler
+  // returning true has missed one and gets a fresh snapshot.
+  ws.onmessage = (e) => {
+    for (const msg of decodeFrame(e.data)) {
+      if (onMessage(msg)) ws.send('{"type":"resync"}');
+    }
+  };
   ws.onclose = () => setTimeout(() => connectSignals(onMessage), 3000);
   return ws;
 }
 
-export function connectMonitor(onMessage) {
+// Byte stream of one port: dir is 'rx', 'tx' or 'both'; rate (bytes/s) and
+// sample (forward one chunk in n) are optional. Not reconnected on close.
+export function connectTap(portId, dir, onMessage, { rate, sample } = {}) {
   const proto = location.protocol === 'https:' ? 'wss:' : 'ws:';
-  const ws = new WebSocket(`${proto}//${location.host}/ws/monitor`);
-  ws.onmessage = (e) => onMessage(JSON.parse(e.data));
+  let q = `port=${portId}&dir=${dir}`;
+  if (rate) q += `&rate=${rate}`;
+  if (sample) q += `&sample=${sample}`;
+  const ws = new WebSocket(`${proto}//${location.host}/ws/tap?${q}`);
+  ws.binaryType = 'arraybuffer';
+  ws.onmessage = (e) => decodeFrame(e.data).forEach(onMessage);
+  return ws;
+}
+
+export function connectMonitor(onMessage) {
+  const ws = openSocket('/ws/monitor');
+  ws.onmessage = (e) => decodeFrame(e.data).forEach(onMessage);
   ws.onclose = () => setTimeout(() => connectMonitor(onMessage), 3000);
   return ws;
 }
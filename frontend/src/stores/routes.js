@@ -9,3 +9,6 @@ export async function refreshRoutes() {
 }
 
 export const ROUTE_TYPES = ['Bridge', 'Clone', 'Merge'];
+export const ROUTE_FLOWS = ['Drop', 'Lossless'];
+export const ROUTE_ARBITRATIONS = ['Byte', 'Line', 'Idle gap'];
+export const ROUTE_FRAMINGS = ['None', 'Line', 'Fixed length', 'Idle gap'];
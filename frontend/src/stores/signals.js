@@ -6,10 +6,36 @@ export const liveSignals = writable({});
 // Data flow per route: { routeId: { bytesSrcToDst, bytesDstToSrc } }
 export const dataFlow = writable({});
 
+const SIGNAL_BITS = { dtr: 1, rts: 2, cts: 4, dsr: 8, dcd: 16, ri: 32 };
+
+// Sequence number of the last /ws/signals message applied, null before the
+// first snapshot.
+let lastSeq = null;
+
+// Apply a /ws/signals message: a full snapshot, or a delta carrying only the
+// changed bits of the changed ports. Returns true when a delta was missed
+// and the caller should ask for a snapshot.
 export function updateSignal(msg) {
-  if (msg.type === 'signal') {
-    liveSignals.update(s => ({ ...s, [msg.portId]: msg.signals }));
+  if (msg.type !== 'signals') return false;
+
+  if (!msg.full && (lastSeq === null || msg.seq !== ((lastSeq + 1) >>> 0))) {
+    lastSeq = null;
+    return true;
   }
+  lastSeq = msg.seq;
+
+  liveSignals.update(s => {
+    const next = msg.full ? {} : { ...s };
+    for (const p of msg.ports) {
+      const cur = { ...(next[p.id] || {}) };
+      for (const [name, bit] of Object.entries(SIGNAL_BITS)) {
+        if (p.changed & bit) cur[name] = (p.value & bit) !== 0;
+      }
+      next[p.id] = cur;
+    }
+    return next;
+  });
+  return false;
 }
 
 export function updateDataFlow(msg) {
@@ -0,0 +1,209 @@
+#include "api_bench.h"
+#include "bench.h"
+#include "mock_port.h"
+#include "port_registry.h"
+#include "config_store.h"
+#include "wifi_mgr.h"
+#include "web_server.h"
+#include "esp_http_server.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define API_UNUSED_PORT     5       // no port with this id on the device
+#define API_SRC_COUNT       8       // source ports read by the routes
+
+// From api_handler.c
+esp_err_t api_get_ports_handler(httpd_req_t *req);
+esp_err_t api_get_routes_handler(httpd_req_t *req);
+esp_err_t api_get_latency_handler(httpd_req_t *req);
+esp_err_t api_get_metrics_handler(httpd_req_t *req);
+esp_err_t api_get_config_handler(httpd_req_t *req);
+esp_err_t api_get_system_handler(httpd_req_t *req);
+
+static const struct {
+    const char *uri;
+    esp_err_t (*handler)(httpd_req_t *req);
+} endpoints[] = {
+    { "/api/ports",   api_get_ports_handler },
+    { "/api/routes",  api_get_routes_handler },
+    { "/api/latency", api_get_latency_handler },
+    { "/api/metrics", api_get_metrics_handler },
+    { "/api/config",  api_get_config_handler },
+    { "/api/system",  api_get_system_handler },
+};
+#define ENDPOINT_COUNT  (sizeof(endpoints) / sizeof(endpoints[0]))
+
+// ---------------------------------------------------------------------------
+// What api_handler.c needs from the rest of the firmware
+// ---------------------------------------------------------------------------
+
+system_config_t sys_config;
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len)
+{
+    if (buf && len > 0) {
+        req->resp_bytes += len;
+        req->resp_chunks++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str)
+{
+    return httpd_resp_send_chunk(req, str, strlen(str));
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    req->resp_error = true;
+    return httpd_resp_sendstr(req, msg ? msg : "");
+}
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t len)
+{
+    size_t n = req->content_len - req->body_read;
+    if (n > len) n = len;
+    memcpy(buf, req->body + req->body_read, n);
+    req->body_read += n;
+    return (int)n;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t len)
+{
+    const char *q = strchr(req->uri, '?');
+    if (!q || strlen(q + 1) >= len) return ESP_ERR_NOT_FOUND;
+    strcpy(buf, q + 1);
+    return ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t len)
+{
+    size_t klen = strlen(key);
+    for (const char *p = qry; p; p = strchr(p, '&'), p = p ? p + 1 : NULL) {
+        if (strncmp(p, key, klen) != 0 || p[klen] != '=') continue;
+        const char *v = p + klen + 1;
+        size_t n = strcspn(v, "&");
+        if (n >= len) return ESP_ERR_INVALID_SIZE;
+        memcpy(val, v, n);
+        val[n] = '\0';
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t config_store_save(const system_config_t *config) { return ESP_OK; }
+esp_err_t config_store_reset(void) { return ESP_OK; }
+
+bool wifi_mgr_is_connected(void) { return true; }
+const char *wifi_mgr_get_ip(void) { return "192.168.4.1"; }
+wifi_mgr_mode_t wifi_mgr_get_mode(void) { return WIFI_MGR_MODE_STA; }
+esp_err_t wifi_mgr_set_credentials(const char *ssid, const char *password) { return ESP_OK; }
+
+void web_server_get_ws_stats(web_server_ws_stats_t *out) { memset(out, 0, sizeof(*out)); }
+void web_server_reset_ws_latency(void) { }
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// Every route maps DTR to RTS; every fourth is a bridge and the rest clone
+// to two destinations.  Routes read at most API_SRC_COUNT ports, as many as
+// the engine can read at once; the destinations cover the others too.
+static int api_routes(bench_set_t *set, const uint8_t *ids, int n)
+{
+    for (int i = 0; i < ROUTE_MAX_COUNT; i++) {
+        route_t r = {
+            .flow = i % 2 ? ROUTE_FLOW_LOSSLESS : ROUTE_FLOW_DROP,
+            .src_port_id = ids[i % API_SRC_COUNT],
+            .signal_map = { { SIGNAL_DTR, SIGNAL_RTS } }, .signal_map_count = 1,
+        };
+        if (i % 4 == 0) {
+            r.type            = ROUTE_TYPE_BRIDGE;
+            r.dst_port_ids[0] = ids[(i + 1 + i / API_SRC_COUNT) % API_SRC_COUNT];
+            r.dst_count       = 1;
+        } else {
+            r.type            = ROUTE_TYPE_CLONE;
+            r.dst_port_ids[0] = ids[API_SRC_COUNT + i % (n - API_SRC_COUNT)];
+            r.dst_port_ids[1] = ids[(i + 3) % API_SRC_COUNT];
+            r.dst_count       = 2;
+        }
+        if (bench_route(set, &r) < 0) return -1;
+    }
+    return 0;
+}
+
+static void api_endpoint(const char *uri, esp_err_t (*handler)(httpd_req_t *req), int routes)
+{
+    static httpd_req_t req;
+    uint64_t requests = 0, allocs = 0, bytes = 0, chunks = 0;
+    size_t peak = 0;
+    bool ok = true;
+
+    bench_begin("api");
+    bench_str("endpoint", uri);
+    bench_u64("ports", port_registry_count());
+    bench_u64("routes", routes);
+
+    int64_t t0 = esp_timer_get_time(), t1;
+    do {
+        memset(&req, 0, sizeof(req));
+        snprintf(req.uri, sizeof(req.uri), "%s", uri);
+
+        uint64_t a = bench_heap_allocs();
+        bench_heap_mark();
+        ok &= handler(&req) == ESP_OK && !req.resp_error && req.resp_bytes > 0;
+        size_t p = bench_heap_peak();
+
+        if (p > peak) peak = p;
+        allocs += bench_heap_allocs() - a;
+        bytes  += req.resp_bytes;
+        chunks += req.resp_chunks;
+        requests++;
+        t1 = esp_timer_get_time();
+    } while (t1 - t0 < CONFIG_ROUTE_BENCH_RUN_MS * 1000LL);
+
+    double secs = (t1 - t0) / 1e6;
+    bench_num("requests_s",     requests / secs);
+    bench_u64("resp_bytes",     bytes / requests);
+    bench_num("chunks_per_req", (double)chunks / requests);
+    bench_num("allocs_per_req", (double)allocs / requests);
+    bench_u64("peak_heap",      peak);
+    bench_check("ok",           ok);
+    bench_end();
+}
+
+void api_bench(void)
+{
+    uint8_t ids[PORT_MAX_COUNT];
+    int n = 0;
+    bench_set_t set = { 0 };
+
+    port_registry_remove(API_UNUSED_PORT);
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        if (port_registry_get(i)) ids[n++] = i;
+    }
+
+    if (api_routes(&set, ids, n) == 0) {
+        for (size_t i = 0; i < ENDPOINT_COUNT; i++) {
+            api_endpoint(endpoints[i].uri, endpoints[i].handler, set.route_count);
+        }
+    } else {
+        bench_begin("api");
+        bench_str("error", "route setup failed");
+        bench_end();
+    }
+
+    bench_teardown(&set);
+    port_registry_add(&mock_port(API_UNUSED_PORT)->port);
+}
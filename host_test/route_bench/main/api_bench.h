@@ -0,0 +1,8 @@
+#pragma once
+
+// REST API cost: calls each GET handler of api_handler.c for
+// CONFIG_ROUTE_BENCH_RUN_MS with the firmware's 11 ports registered and
+// all ROUTE_MAX_COUNT routes running, and prints one "api" line per
+// endpoint with requests/s, response size and the heap each request
+// allocated.
+void api_bench(void);
@@ -0,0 +1,309 @@
+#include "bench.h"
+#include "mock_port.h"
+#include "buf_pool.h"
+#include "dp_notify.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "bench";
+
+#define BENCH_WARMUP_MS     100
+#define BENCH_SETTLE_MS     1000    // longest wait for the sinks to catch up
+#define BENCH_IDLE_MS       20      // ... which they have once idle this long
+
+static int failures;
+static uint64_t heap_allocs;
+static int64_t  heap_live;      // bytes, as malloc_usable_size() counts them
+static int64_t  heap_peak;
+static int64_t  heap_mark;
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+void bench_begin(const char *bench)
+{
+    printf("{\"bench\":\"%s\"", bench);
+}
+
+void bench_str(const char *key, const char *val)
+{
+    printf(",\"%s\":\"%s\"", key, val);
+}
+
+void bench_u64(const char *key, uint64_t val)
+{
+    printf(",\"%s\":%" PRIu64, key, val);
+}
+
+void bench_num(const char *key, double val)
+{
+    printf(",\"%s\":%.3f", key, val);
+}
+
+void bench_end(void)
+{
+    printf("}\n");
+    fflush(stdout);
+}
+
+void bench_check(const char *key, bool ok)
+{
+    printf(",\"%s\":%s", key, ok ? "true" : "false");
+    if (!ok) failures++;
+}
+
+int bench_failures(void)
+{
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// Heap use: main/CMakeLists.txt links with --wrap for these.  Memory from
+// allocators that are not wrapped (aligned_alloc) only shows when freed, so
+// heap_live drifts down; peaks are taken relative to a mark.
+// ---------------------------------------------------------------------------
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void  __real_free(void *p);
+
+static void heap_add(int64_t bytes)
+{
+    int64_t live = __atomic_add_fetch(&heap_live, bytes, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&heap_peak, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&heap_peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    void *p = __real_malloc(size);
+    __atomic_add_fetch(&heap_allocs, 1, __ATOMIC_RELAXED);
+    if (p) heap_add(malloc_usable_size(p));
+    return p;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    void *p = __real_calloc(n, size);
+    __atomic_add_fetch(&heap_allocs, 1, __ATOMIC_RELAXED);
+    if (p) heap_add(malloc_usable_size(p));
+    return p;
+}
+
+void *__wrap_realloc(void *old, size_t size)
+{
+    int64_t was = old ? malloc_usable_size(old) : 0;
+    void *p = __real_realloc(old, size);
+    if (!old) __atomic_add_fetch(&heap_allocs, 1, __ATOMIC_RELAXED);
+    if (p) heap_add((int64_t)malloc_usable_size(p) - was);
+    else if (!size) heap_add(-was);
+    return p;
+}
+
+void __wrap_free(void *p)
+{
+    if (p) heap_add(-(int64_t)malloc_usable_size(p));
+    __real_free(p);
+}
+
+uint64_t bench_heap_allocs(void)
+{
+    return __atomic_load_n(&heap_allocs, __ATOMIC_RELAXED);
+}
+
+void bench_heap_mark(void)
+{
+    heap_mark = __atomic_load_n(&heap_live, __ATOMIC_RELAXED);
+    __atomic_store_n(&heap_peak, heap_mark, __ATOMIC_RELAXED);
+}
+
+size_t bench_heap_peak(void)
+{
+    int64_t peak = __atomic_load_n(&heap_peak, __ATOMIC_RELAXED) - heap_mark;
+    return peak > 0 ? (size_t)peak : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+// ---------------------------------------------------------------------------
+
+// Visit the mock port of every id bit set in `bits`.
+#define FOR_EACH_PORT(bits, id, m) \
+    for (uint8_t id = 0; id < MOCK_PORT_COUNT; id++) \
+        if ((((bits) >> id) & 1) && ((m) = mock_port(id)))
+
+void bench_snap(const bench_set_t *set, bench_snap_t *s)
+{
+    mock_port_t *m;
+    memset(s, 0, sizeof(*s));
+
+    FOR_EACH_PORT(set->srcs | set->sinks, id, m) {
+        port_stats_t ps;
+        port_get_stats(&m->port, &ps);
+        if ((set->srcs >> id) & 1) s->in_bytes += ps.rx.bytes;
+        s->rx_dropped   += ps.rx.dropped;
+        s->tx_refused   += ps.tx.refused;
+        s->tx_discarded += ps.tx.discarded;
+        s->out_bytes    += __atomic_load_n(&m->sink_bytes, __ATOMIC_RELAXED);
+        s->seq_errors   += __atomic_load_n(&m->seq_errors, __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < set->route_count; i++) {
+        route_stats_t rs;
+        if (route_get_stats(set->routes[i], &rs) != ESP_OK) continue;
+        s->chunks += rs.src_to_dst.chunks + rs.dst_to_src.chunks;
+        s->writes += rs.src_to_dst.writes + rs.dst_to_src.writes;
+        s->lost   += rs.src_to_dst.lost   + rs.dst_to_src.lost;
+        s->stalls += rs.src_to_dst.stalls + rs.dst_to_src.stalls;
+    }
+    if (set->extra) {
+        s->chunks += __atomic_load_n(&set->extra->chunks, __ATOMIC_RELAXED);
+        s->lost   += __atomic_load_n(&set->extra->lost, __ATOMIC_RELAXED);
+    }
+
+    buf_pool_stats_t pool[BUF_CLASS_COUNT];
+    buf_pool_get_stats(pool);
+    for (int c = 0; c < BUF_CLASS_COUNT; c++) {
+        s->pool_takes += pool[c].takes;
+    }
+    s->heap_allocs = bench_heap_allocs();
+
+    uint32_t notifies, cross_core;
+    dp_notify_get_counts(&notifies, &cross_core);
+    s->notifies   = notifies;
+    s->cross_core = cross_core;
+    s->us = esp_timer_get_time();
+}
+
+int bench_route(bench_set_t *set, const route_t *cfg)
+{
+    uint8_t id;
+    if (set->route_count >= ROUTE_MAX_COUNT) return -1;
+    if (route_create(cfg, &id) != ESP_OK) return -1;
+    if (route_start(id) != ESP_OK) {
+        route_destroy(id);
+        return -1;
+    }
+    set->routes[set->route_count++] = id;
+    return id;
+}
+
+void bench_measure(bench_set_t *set, size_t chunk)
+{
+    mock_port_t *m;
+    bench_snap_t a, b;
+
+    FOR_EACH_PORT(set->sinks, id, m) {
+        mock_sink_reset(m, (set->checked >> id) & 1);
+    }
+    FOR_EACH_PORT(set->srcs, id, m) {
+        mock_gen_start(m, chunk, set->gap_ms);
+    }
+    vTaskDelay(pdMS_TO_TICKS(BENCH_WARMUP_MS));
+    for (int i = 0; i < set->route_count; i++) {
+        route_reset_latency(set->routes[i]);
+    }
+
+    bench_snap(set, &a);
+    if (set->stalling && set->stall_ms) {
+        for (uint32_t ms = 0; ms < CONFIG_ROUTE_BENCH_RUN_MS; ms += set->stall_ms) {
+            bool stall = (ms / set->stall_ms) % 2 == 0;
+            FOR_EACH_PORT(set->stalling, id, m) {
+                m->stalled = stall;
+            }
+            vTaskDelay(pdMS_TO_TICKS(set->stall_ms));
+        }
+        FOR_EACH_PORT(set->stalling, id, m) {
+            m->stalled = false;
+        }
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_ROUTE_BENCH_RUN_MS));
+    }
+    bench_snap(set, &b);
+
+    uint32_t p50 = 0, p99 = 0;
+    for (int i = 0; i < set->route_count; i++) {
+        latency_summary_t lat[2];
+        if (route_get_latency(set->routes[i], &lat[0], &lat[1]) != ESP_OK) continue;
+        for (int d = 0; d < 2; d++) {
+            if (lat[d].count == 0) continue;
+            if (lat[d].p50_us > p50) p50 = lat[d].p50_us;
+            if (lat[d].p99_us > p99) p99 = lat[d].p99_us;
+        }
+    }
+
+    FOR_EACH_PORT(set->srcs, id, m) {
+        mock_gen_stop(m);
+    }
+
+    double secs = (b.us - a.us) / 1e6;
+    double in_mb = (b.in_bytes - a.in_bytes) / 1e6;
+    uint64_t takes = b.pool_takes - a.pool_takes;
+    uint64_t allocs = b.heap_allocs - a.heap_allocs;
+
+    bench_u64("ms",             (b.us - a.us) / 1000);
+    bench_num("in_mb_s",        in_mb / secs);
+    bench_num("out_mb_s",       (b.out_bytes - a.out_bytes) / 1e6 / secs);
+    bench_num("chunks_s",       (b.chunks - a.chunks) / secs);
+    bench_num("writes_s",       (b.writes - a.writes) / secs);
+    bench_num("bytes_per_write", b.writes > a.writes ?
+                                (double)(b.out_bytes - a.out_bytes) / (b.writes - a.writes) : 0);
+    bench_u64("pool_takes",     takes);
+    bench_num("takes_per_mb",   in_mb > 0 ? takes / in_mb : 0);
+    bench_u64("heap_allocs",    allocs);
+    bench_num("allocs_per_mb",  in_mb > 0 ? allocs / in_mb : 0);
+    bench_num("notify_s",       (uint32_t)(b.notifies - a.notifies) / secs);
+    bench_num("cross_core_s",   (uint32_t)(b.cross_core - a.cross_core) / secs);
+    bench_u64("p50_us",         p50);
+    bench_u64("p99_us",         p99);
+    bench_u64("lost",           b.lost - a.lost);
+    bench_u64("stalls",         b.stalls - a.stalls);
+    bench_u64("rx_dropped",     b.rx_dropped - a.rx_dropped);
+    bench_u64("tx_refused",     b.tx_refused - a.tx_refused);
+    bench_u64("tx_discarded",   b.tx_discarded - a.tx_discarded);
+    bench_u64("seq_errors",     b.seq_errors - a.seq_errors);
+}
+
+void bench_settle(const bench_set_t *set)
+{
+    mock_port_t *m;
+    bench_snap_t s;
+    uint64_t last = UINT64_MAX;
+    int idle = 0;
+
+    for (int ms = 0; ms < BENCH_SETTLE_MS && idle < BENCH_IDLE_MS; ms++) {
+        bool pending = false;
+        FOR_EACH_PORT(set->sinks, id, m) {
+            pending |= port_tx_pending(&m->port) != 0;
+        }
+        bench_snap(set, &s);
+        idle = pending || s.out_bytes != last ? 0 : idle + 1;
+        last = s.out_bytes;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+void bench_teardown(bench_set_t *set)
+{
+    mock_port_t *m;
+
+    for (int i = 0; i < set->route_count; i++) {
+        if (route_destroy(set->routes[i]) != ESP_OK) {
+            ESP_LOGW(TAG, "Route %d not destroyed", set->routes[i]);
+        }
+    }
+    set->route_count = 0;
+
+    FOR_EACH_PORT(set->srcs | set->sinks, id, m) {
+        mock_port_drain(m);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "route.h"
+
+// One result per line, as a flat JSON object:
+//   {"bench":"bridge","flow":"lossless","chunk":256,...,"mb_s":41.2,...}
+// bench_begin() opens a line, the field helpers append to it and
+// bench_end() closes it.
+
+void bench_begin(const char *bench);
+void bench_str(const char *key, const char *val);
+void bench_u64(const char *key, uint64_t val);
+void bench_num(const char *key, double val);
+void bench_end(void);
+
+// Append "key":true/false; a false one makes bench_failures() non-zero.
+void bench_check(const char *key, bool ok);
+int  bench_failures(void);
+
+// Counters of traffic moved outside the route engine (a baseline model).
+typedef struct {
+    uint64_t chunks;
+    uint64_t lost;
+} bench_counts_t;
+
+// Heap use, process-wide: malloc/calloc calls since boot, and the most in
+// use at once since bench_heap_mark() above what was in use then.
+uint64_t bench_heap_allocs(void);
+void     bench_heap_mark(void);
+size_t   bench_heap_peak(void);
+
+// The ports and routes a measurement covers.
+typedef struct {
+    uint32_t srcs;                      // port id bits: generators
+    uint32_t sinks;                     // port id bits: destinations
+    uint32_t checked;                   // ... of which verify the pattern
+    uint32_t stalling;                  // ... of which stall every other stall_ms
+    uint32_t stall_ms;
+    uint32_t gap_ms;                    // generators pause this long per chunk
+    uint8_t  routes[ROUTE_MAX_COUNT];
+    int      route_count;
+    const bench_counts_t *extra;        // folded into chunks and lost, or NULL
+} bench_set_t;
+
+// Totals since boot over a set's ports and routes.
+typedef struct {
+    int64_t  us;
+    uint64_t in_bytes;      // accepted into the sources' rx_rings
+    uint64_t out_bytes;     // taken by the sinks
+    uint64_t chunks;
+    uint64_t writes;
+    uint64_t lost;
+    uint64_t stalls;
+    uint64_t rx_dropped;
+    uint64_t tx_refused;
+    uint64_t tx_discarded;
+    uint64_t seq_errors;
+    uint64_t pool_takes;
+    uint64_t notifies;      // data-plane task notifications, process-wide
+    uint64_t cross_core;    // ... of which to a task not pinned to the notifying core
+    uint64_t heap_allocs;   // malloc/calloc calls, process-wide
+} bench_snap_t;
+
+void bench_snap(const bench_set_t *set, bench_snap_t *out);
+
+// Start a route; returns its id, or -1.
+int bench_route(bench_set_t *set, const route_t *cfg);
+
+// Run the generators of set->srcs with chunk-byte pushes, measure for
+// CONFIG_ROUTE_BENCH_RUN_MS and append the traffic fields to the open line:
+//   ms          measurement window
+//   in_mb_s     bytes accepted into the sources' rx_rings
+//   out_mb_s    bytes taken by the sinks (a clone counts each copy)
+//   chunks_s    fan-out reads by all routes
+//   writes_s    destination writes by all routes, and bytes per write
+//   pool_takes  buf_pool blocks taken in the window, and per MB in
+//   heap_allocs malloc/calloc calls in the window, and per MB in
+//   notify_s    data-plane task notifications, and cross_core_s of them
+//   p50_us/p99_us  worst route direction, ingress to egress
+//   lost        bytes the routes dropped (overrun or refused)
+//   stalls      times a lossless route held its source back
+//   rx_dropped, tx_refused, tx_discarded  port counters of set's ports
+//   seq_errors  bytes out of order at sinks that check the pattern
+void bench_measure(bench_set_t *set, size_t chunk);
+
+// After bench_measure(): wait until the sinks have taken everything still
+// queued towards them.
+void bench_settle(const bench_set_t *set);
+
+// Stop and destroy the routes of set, then drain its ports.
+void bench_teardown(bench_set_t *set);
@@ -0,0 +1,133 @@
+#include "fanout_queue.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "fanout_queue";
+
+// As in the route engine before the broadcast ring
+#define FQ_BUF_SIZE     256
+#define FQ_STACK_SIZE   4096
+#define FQ_Q_DEPTH      8
+#define FQ_SUB_MAX      8
+
+typedef struct {
+    uint8_t *data;
+    uint16_t len;
+} fanout_chunk_t;
+
+typedef struct {
+    QueueHandle_t   queue;
+    port_t         *dst;
+} fq_sub_t;
+
+static fq_sub_t          subs[FQ_SUB_MAX];
+static int               sub_count;
+static port_t           *src_port;
+static volatile bool     running;
+static SemaphoreHandle_t done;
+static bench_counts_t    counts;
+
+static void fq_pump_task(void *arg)
+{
+    uint8_t buf[FQ_BUF_SIZE];
+
+    while (running) {
+        int n = src_port->ops.read(src_port, buf, sizeof(buf), pdMS_TO_TICKS(50));
+        if (n <= 0) continue;
+
+        for (int i = 0; i < sub_count; i++) {
+            fanout_chunk_t chunk = {
+                .data = malloc(n),
+                .len  = (uint16_t)n,
+            };
+            if (!chunk.data) continue;
+            memcpy(chunk.data, buf, n);
+            if (xQueueSend(subs[i].queue, &chunk, 0) != pdTRUE) {
+                free(chunk.data);
+                __atomic_add_fetch(&counts.lost, n, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static void fq_forward_task(void *arg)
+{
+    fq_sub_t *sub = (fq_sub_t *)arg;
+    fanout_chunk_t chunk;
+
+    while (running) {
+        if (xQueueReceive(sub->queue, &chunk, pdMS_TO_TICKS(50)) != pdTRUE) continue;
+        int w = port_write(sub->dst, chunk.data, chunk.len);
+        if (w < chunk.len) __atomic_add_fetch(&counts.lost, chunk.len - w, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&counts.chunks, 1, __ATOMIC_RELAXED);
+        free(chunk.data);
+    }
+
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t fanout_queue_start(port_t *src, port_t *const *dst, int n)
+{
+    if (n < 1 || n > FQ_SUB_MAX) return ESP_ERR_INVALID_ARG;
+    if (!done) done = xSemaphoreCreateCounting(FQ_SUB_MAX + 1, 0);
+    if (!done) return ESP_ERR_NO_MEM;
+
+    src_port  = src;
+    sub_count = 0;
+    running   = true;
+    for (int i = 0; i < n; i++) {
+        subs[i].dst   = dst[i];
+        subs[i].queue = xQueueCreate(FQ_Q_DEPTH, sizeof(fanout_chunk_t));
+        if (!subs[i].queue) {
+            fanout_queue_stop();
+            return ESP_ERR_NO_MEM;
+        }
+        sub_count++;
+    }
+
+    int tasks = 0;
+    for (int i = 0; i < n; i++) {
+        if (xTaskCreate(fq_forward_task, "fq_fwd", FQ_STACK_SIZE, &subs[i], 5, NULL) == pdPASS) tasks++;
+    }
+    if (xTaskCreate(fq_pump_task, "fq_pump", FQ_STACK_SIZE, NULL, 5, NULL) == pdPASS) tasks++;
+    if (tasks != n + 1) {
+        ESP_LOGE(TAG, "Failed to create tasks");
+        running = false;
+        while (tasks--) xSemaphoreTake(done, portMAX_DELAY);
+        fanout_queue_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void fanout_queue_stop(void)
+{
+    if (running) {
+        running = false;
+        for (int i = 0; i < sub_count + 1; i++) {
+            xSemaphoreTake(done, portMAX_DELAY);
+        }
+    }
+
+    for (int i = 0; i < sub_count; i++) {
+        fanout_chunk_t chunk;
+        while (xQueueReceive(subs[i].queue, &chunk, 0) == pdTRUE) free(chunk.data);
+        vQueueDelete(subs[i].queue);
+        subs[i].queue = NULL;
+    }
+    sub_count = 0;
+}
+
+const bench_counts_t *fanout_queue_counts(void)
+{
+    return &counts;
+}
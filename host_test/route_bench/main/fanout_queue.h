@@ -0,0 +1,16 @@
+#pragma once
+
+#include "port.h"
+#include "bench.h"
+
+// The fan-out the broadcast ring replaced, kept as a baseline: one pump per
+// source copies every read into a malloc'd fanout_chunk_t per subscriber
+// and posts it to that subscriber's queue, dropping it when the queue is
+// full; each subscriber's forwarder writes the chunk out and frees it.
+// One instance at a time.
+
+esp_err_t fanout_queue_start(port_t *src, port_t *const *dst, int subs);
+void fanout_queue_stop(void);
+
+// Chunks forwarded and bytes dropped, for bench_set_t.extra.
+const bench_counts_t *fanout_queue_counts(void);
@@ -0,0 +1,190 @@
+#include "mock_port.h"
+#include "port_registry.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "mock_port";
+
+#define MOCK_GEN_STACK_SIZE 4096
+#define MOCK_GEN_PRIORITY   4       // below the data plane, like a driver feeding it
+#define MOCK_PACKET_SIZE    512     // one HS USB packet, as for a CDC port
+#define MOCK_DRAIN_MS       1000
+#define MOCK_HOME_CORE      0       // generators run here
+
+static mock_port_t mock_ports[MOCK_PORT_COUNT];
+
+static int mock_open(port_t *port)
+{
+    port->state = PORT_STATE_ACTIVE;
+    return 0;
+}
+
+static void mock_close(port_t *port)
+{
+    port->state = PORT_STATE_DISABLED;
+}
+
+static int mock_read(port_t *port, uint8_t *buf, size_t len, TickType_t timeout)
+{
+    return (int)port_rx_read(port, buf, len, timeout);
+}
+
+static void mock_check(mock_port_t *m, const uint8_t *buf, size_t len)
+{
+    uint64_t errors = 0;
+    uint8_t expect = m->expect;
+
+    for (size_t i = 0; i < len; i++) {
+        if (m->synced && buf[i] != expect) errors++;
+        m->synced = true;
+        expect = buf[i] + 1;
+    }
+    m->expect = expect;
+    if (errors) __atomic_add_fetch(&m->seq_errors, errors, __ATOMIC_RELAXED);
+}
+
+static int mock_writev(port_t *port, const port_iov_t *iov, int iovcnt, TickType_t timeout)
+{
+    mock_port_t *m = (mock_port_t *)port->priv;
+    (void)timeout;
+
+    if (m->stalled) return 0;
+
+    size_t n = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (m->check) mock_check(m, iov[i].buf, iov[i].len);
+        n += iov[i].len;
+    }
+    __atomic_add_fetch(&m->sink_bytes, n, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m->sink_writes, 1, __ATOMIC_RELAXED);
+    return (int)n;
+}
+
+static int mock_get_signals(port_t *port, uint32_t *signals)
+{
+    *signals = port->signals;
+    return 0;
+}
+
+static int mock_set_signals(port_t *port, uint32_t signals)
+{
+    mock_port_t *m = (mock_port_t *)port->priv;
+
+    port->signals = signals;
+    m->sig_set_us = esp_timer_get_time();
+    xSemaphoreGive(m->sig_set);
+    return 0;
+}
+
+static int mock_write(port_t *port, const uint8_t *buf, size_t len, TickType_t timeout)
+{
+    port_iov_t iov = { buf, len };
+    return mock_writev(port, &iov, 1, timeout);
+}
+
+static const port_ops_t mock_ops = {
+    .open        = mock_open,
+    .close       = mock_close,
+    .read        = mock_read,
+    .write       = mock_write,
+    .writev      = mock_writev,
+    .get_signals = mock_get_signals,
+    .set_signals = mock_set_signals,
+};
+
+esp_err_t mock_ports_init(void)
+{
+    for (int i = 0; i < MOCK_PORT_COUNT; i++) {
+        mock_port_t *m = &mock_ports[i];
+        char name[PORT_NAME_MAX];
+        snprintf(name, sizeof(name), "mock%d", i);
+
+        m->gen_done = xSemaphoreCreateBinary();
+        m->sig_set  = xSemaphoreCreateBinary();
+        if (!m->gen_done || !m->sig_set) return ESP_ERR_NO_MEM;
+
+        esp_err_t ret = port_init(&m->port, i, name, PORT_TYPE_CDC, &mock_ops, m);
+        if (ret == ESP_OK) {
+            m->port.packet_size = MOCK_PACKET_SIZE;
+            m->port.home_core   = MOCK_HOME_CORE;
+            ret = port_rx_init(&m->port);
+        }
+        if (ret == ESP_OK) ret = port_tx_init(&m->port);
+        if (ret == ESP_OK) ret = port_open(&m->port);
+        if (ret == ESP_OK) ret = port_registry_add(&m->port);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up %s: %s", name, esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+mock_port_t *mock_port(uint8_t id)
+{
+    return id < MOCK_PORT_COUNT ? &mock_ports[id] : NULL;
+}
+
+static void mock_gen_task(void *arg)
+{
+    mock_port_t *m = (mock_port_t *)arg;
+    uint8_t buf[MOCK_CHUNK_MAX];
+
+    while (m->gen_running) {
+        if (port_rx_space(&m->port) < m->chunk) {
+            taskYIELD();
+            continue;
+        }
+        for (size_t i = 0; i < m->chunk; i++) {
+            buf[i] = m->gen_next++;
+        }
+        port_rx_push(&m->port, buf, m->chunk);
+        if (m->gap_ms) vTaskDelay(pdMS_TO_TICKS(m->gap_ms));
+    }
+
+    xSemaphoreGive(m->gen_done);
+    vTaskDelete(NULL);
+}
+
+void mock_gen_start(mock_port_t *m, size_t chunk, uint32_t gap_ms)
+{
+    m->chunk = chunk < MOCK_CHUNK_MAX ? chunk : MOCK_CHUNK_MAX;
+    m->gap_ms = gap_ms;
+    m->gen_running = true;
+
+    char name[PORT_NAME_MAX + 4]; // "gen_" + name + NUL
+    snprintf(name, sizeof(name), "gen_%s", m->port.name);
+    if (xTaskCreatePinnedToCore(mock_gen_task, name, MOCK_GEN_STACK_SIZE, m, MOCK_GEN_PRIORITY,
+                                NULL, MOCK_HOME_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create generator for %s", m->port.name);
+        m->gen_running = false;
+    }
+}
+
+void mock_gen_stop(mock_port_t *m)
+{
+    if (!m->gen_running) return;
+    m->gen_running = false;
+    xSemaphoreTake(m->gen_done, portMAX_DELAY);
+}
+
+void mock_sink_reset(mock_port_t *m, bool check)
+{
+    m->check  = check;
+    m->synced = false;
+}
+
+void mock_port_drain(mock_port_t *m)
+{
+    uint8_t buf[256];
+    while (port_rx_read(&m->port, buf, sizeof(buf), 0) > 0) {
+    }
+
+    m->stalled = false;
+    for (int ms = 0; port_tx_pending(&m->port) && ms < MOCK_DRAIN_MS; ms++) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "port.h"
+#include "freertos/semphr.h"
+
+// In-memory port for the host benchmark, homed on core 0 like a CDC port
+// next to the TinyUSB task.  A generator task stands in for the driver's
+// receive side: it pushes a counting byte pattern into
+// rx_ring, one chunk at a time and only while the chunk fits, like a USB
+// host that is NAKed while the port is full.  Whatever the port's tx task
+// writes goes to a sink that counts it, can check the pattern and can be
+// told to stall.
+
+#define MOCK_PORT_COUNT     PORT_MAX_COUNT
+#define MOCK_CHUNK_MAX      2048
+
+typedef struct {
+    port_t              port;
+
+    // Generator
+    size_t              chunk;          // bytes per push
+    uint32_t            gap_ms;         // pause after each push, 0 = none
+    volatile bool       gen_running;
+    SemaphoreHandle_t   gen_done;
+    uint8_t             gen_next;       // next pattern byte
+
+    // Sink, written by the port's tx task
+    volatile bool       stalled;        // take nothing while set
+    bool                check;          // verify the pattern
+    bool                synced;         // first byte seen since mock_sink_reset()
+    uint8_t             expect;
+    uint64_t            sink_bytes;
+    uint64_t            sink_writes;
+    uint64_t            seq_errors;     // bytes that broke the pattern
+
+    // Output signals, driven by the signal router through ops.set_signals
+    SemaphoreHandle_t   sig_set;        // given on every set_signals()
+    int64_t             sig_set_us;     // esp_timer time of the last one
+} mock_port_t;
+
+// Create ports 0 .. MOCK_PORT_COUNT-1 and register them.
+esp_err_t mock_ports_init(void);
+mock_port_t *mock_port(uint8_t id);
+
+// Push chunk bytes at a time, as fast as the port takes them or, with
+// gap_ms, one chunk per gap_ms like a slow serial line.
+void mock_gen_start(mock_port_t *m, size_t chunk, uint32_t gap_ms);
+void mock_gen_stop(mock_port_t *m);
+
+// Resynchronise the pattern check on the next byte written.
+void mock_sink_reset(mock_port_t *m, bool check);
+
+// Once no route reads the port: empty its rx_ring, then wait for its
+// tx_ring to drain into the sink.
+void mock_port_drain(mock_port_t *m);
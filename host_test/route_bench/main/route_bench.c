@@ -0,0 +1,454 @@
+#include "bench.h"
+#include "mock_port.h"
+#include "fanout_queue.h"
+#include "rx_ring_bench.h"
+#include "api_bench.h"
+#include "port_registry.h"
+#include "buf_pool.h"
+#include "route.h"
+#include "signal_router.h"
+#include "latency_hist.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Host benchmark of the route engine: the real port_core and routing code
+// on the FreeRTOS linux port, between in-memory ports (mock_port.h).
+// Every case prints one JSON line (bench.h) to stdout.
+
+static const char *TAG = "route_bench";
+
+#define BENCH_PRIORITY      10      // above the data plane, so windows end on time
+#define SIGNAL_TOGGLES      1000
+#define SIGNAL_TIMEOUT_MS   100     // a toggle not seen by then is missed
+
+static const size_t chunk_sizes[] = { 16, 64, 256, 1024 };
+#define CHUNK_SIZE_COUNT    (sizeof(chunk_sizes) / sizeof(chunk_sizes[0]))
+
+static const route_flow_t flows[] = { ROUTE_FLOW_DROP, ROUTE_FLOW_LOSSLESS };
+
+static const char *flow_name(route_flow_t flow)
+{
+    return flow == ROUTE_FLOW_LOSSLESS ? "lossless" : "drop";
+}
+
+static void bench_case(const char *bench, route_flow_t flow, size_t chunk, int subs, int dests)
+{
+    bench_begin(bench);
+    bench_str("flow", flow_name(flow));
+    bench_u64("chunk", chunk);
+    bench_u64("subs", subs);
+    bench_u64("dests", dests);
+}
+
+static void bench_fail(bench_set_t *set)
+{
+    bench_str("error", "route setup failed");
+    bench_end();
+    bench_teardown(set);
+}
+
+// Bridge 0 <-> 1, traffic both ways.
+static void bench_bridge(route_flow_t flow, size_t chunk)
+{
+    bench_set_t set = { .srcs = 0x3, .sinks = 0x3, .checked = 0x3 };
+    route_t r = {
+        .type = ROUTE_TYPE_BRIDGE, .flow = flow,
+        .src_port_id = 0, .dst_port_ids = { 1 }, .dst_count = 1,
+    };
+
+    bench_case("bridge", flow, chunk, 1, 1);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    bench_teardown(&set);
+}
+
+// Clone 0 -> 1..4.
+static void bench_clone(route_flow_t flow, size_t chunk)
+{
+    bench_set_t set = { .srcs = 0x1, .sinks = 0x1e, .checked = 0x1e };
+    route_t r = {
+        .type = ROUTE_TYPE_CLONE, .flow = flow,
+        .src_port_id = 0, .dst_port_ids = { 1, 2, 3, 4 }, .dst_count = 4,
+    };
+
+    bench_case("clone", flow, chunk, 1, 4);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    bench_teardown(&set);
+}
+
+// Merge 0..3 -> 4.  Sources interleave, so the sink cannot check order.
+static void bench_merge(route_flow_t flow, size_t chunk)
+{
+    bench_set_t set = { .srcs = 0xf, .sinks = 0x10 };
+    route_t r = {
+        .type = ROUTE_TYPE_MERGE, .flow = flow,
+        .src_port_id = 0, .merge_src_ids = { 1, 2, 3 }, .merge_src_count = 3,
+        .dst_port_ids = { 4 }, .dst_count = 1,
+    };
+
+    bench_case("merge", flow, chunk, 4, 1);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    bench_teardown(&set);
+}
+
+static const char *arb_name(route_arbitration_t arb)
+{
+    switch (arb) {
+    case ROUTE_ARB_DELIMITER: return "delimiter";
+    case ROUTE_ARB_IDLE_GAP:  return "idle_gap";
+    default:                  return "byte";
+    }
+}
+
+// Lossless merge of 4 saturated sources 0..3 -> 4 under one arbitration
+// mode: the aggregate throughput, and each source's share of it since the
+// route started.  The pattern has a '\n' every 256 bytes to frame on;
+// saturated sources never fall idle, so idle_gap turns end by force.
+static void bench_merge_arb(route_arbitration_t arb, uint8_t weight0)
+{
+    bench_set_t set = { .srcs = 0xf, .sinks = 0x10 };
+    route_t r = {
+        .type = ROUTE_TYPE_MERGE, .flow = ROUTE_FLOW_LOSSLESS,
+        .src_port_id = 0, .merge_src_ids = { 1, 2, 3 }, .merge_src_count = 3,
+        .dst_port_ids = { 4 }, .dst_count = 1,
+        .arbitration = arb, .arb_delimiter = '\n',
+        .merge_weights = { weight0 },
+    };
+    route_merge_stats_t ms[ROUTE_MERGE_MAX_SRC];
+    int count = 0;
+
+    bench_case("merge_arb", ROUTE_FLOW_LOSSLESS, 256, 4, 1);
+    bench_str("arbitration", arb_name(arb));
+    bench_u64("weight0", weight0 ? weight0 : 1);
+    int id = bench_route(&set, &r);
+    if (id < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, 256);
+
+    if (route_get_merge_stats(id, ms, &count) == ESP_OK) {
+        uint64_t total = 0, frames = 0, forced = 0;
+        for (int i = 0; i < count; i++) {
+            total  += ms[i].bytes;
+            frames += ms[i].frames;
+            forced += ms[i].forced;
+        }
+        for (int i = 0; i < count; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "share%d", i);
+            bench_num(key, total ? (double)ms[i].bytes / total : 0);
+        }
+        bench_u64("frames", frames);
+        bench_u64("forced", forced);
+    }
+    bench_end();
+    bench_teardown(&set);
+}
+
+// `subs` clone routes reading port 0, one destination each (ports 1..subs):
+// the cost of sharing a source through its broadcast ring.
+static void bench_fanout(route_flow_t flow, size_t chunk, int subs)
+{
+    bench_set_t set = { .srcs = 0x1 };
+
+    bench_case("fanout", flow, chunk, subs, subs);
+    bench_str("impl", "ring");
+    for (int i = 1; i <= subs; i++) {
+        route_t r = {
+            .type = ROUTE_TYPE_CLONE, .flow = flow,
+            .src_port_id = 0, .dst_port_ids = { i }, .dst_count = 1,
+        };
+        set.sinks   |= 1u << i;
+        set.checked |= 1u << i;
+        if (bench_route(&set, &r) < 0) {
+            bench_fail(&set);
+            return;
+        }
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    bench_teardown(&set);
+}
+
+// The same fan-out through per-subscriber fanout_chunk_t queues
+// (fanout_queue.h), which could only drop.
+static void bench_fanout_queue(size_t chunk, int subs)
+{
+    bench_set_t set = { .srcs = 0x1, .extra = fanout_queue_counts() };
+    port_t *dst[8];
+
+    bench_case("fanout", ROUTE_FLOW_DROP, chunk, subs, subs);
+    bench_str("impl", "queue");
+    for (int i = 1; i <= subs; i++) {
+        dst[i - 1]   = &mock_port(i)->port;
+        set.sinks   |= 1u << i;
+        set.checked |= 1u << i;
+    }
+    if (fanout_queue_start(&mock_port(0)->port, dst, subs) != ESP_OK) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    fanout_queue_stop();
+    bench_teardown(&set);
+}
+
+// Clone 0 -> 1 without and with a coalescing policy, from a source pushing
+// `chunk` bytes every gap_ms (0: as fast as it can).
+static void bench_coalesce(size_t chunk, uint32_t gap_ms, uint16_t bytes, uint32_t us)
+{
+    bench_set_t set = { .srcs = 0x1, .sinks = 0x2, .checked = 0x2, .gap_ms = gap_ms };
+    route_t r = {
+        .type = ROUTE_TYPE_CLONE, .flow = ROUTE_FLOW_DROP,
+        .src_port_id = 0, .dst_port_ids = { 1 }, .dst_count = 1,
+        .coalesce_bytes = bytes, .coalesce_us = us,
+    };
+
+    bench_case("coalesce", ROUTE_FLOW_DROP, chunk, 1, 1);
+    bench_u64("gap_ms", gap_ms);
+    bench_u64("coalesce_bytes", bytes);
+    bench_u64("coalesce_us", us);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, chunk);
+    bench_end();
+    bench_teardown(&set);
+}
+
+// Lossless bridge 0 <-> 1 under each core placement policy.  Both ports
+// are homed on core 0, so "auto" pins the route's tasks there.
+static void bench_affinity(route_affinity_t policy)
+{
+    bench_set_t set = { .srcs = 0x3, .sinks = 0x3, .checked = 0x3 };
+    route_t r = {
+        .type = ROUTE_TYPE_BRIDGE, .flow = ROUTE_FLOW_LOSSLESS,
+        .src_port_id = 0, .dst_port_ids = { 1 }, .dst_count = 1,
+    };
+    route_affinity_t prev = route_get_affinity();
+    route_engine_stats_t es;
+
+    bench_case("affinity", ROUTE_FLOW_LOSSLESS, 256, 1, 1);
+    bench_str("policy", policy == ROUTE_AFFINITY_AUTO ? "auto" : "none");
+    route_set_affinity(policy);
+    if (bench_route(&set, &r) < 0) {
+        route_set_affinity(prev);
+        bench_fail(&set);
+        return;
+    }
+    bench_measure(&set, 256);
+    route_engine_get_stats(&es);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        char key[16];
+        snprintf(key, sizeof(key), "cpu%d_pct", c);
+        bench_num(key, es.cpu_load[c]);     // -1: run-time stats are off
+    }
+    bench_end();
+    bench_teardown(&set);
+    route_set_affinity(prev);
+}
+
+// Clone 0 -> 1 mapping DTR on 0 to RTS on 1.  Toggle DTR as a driver
+// would and time it to the router's set_signals() on port 1: the
+// end-to-end propagation, next to the router's own change-to-applied
+// latency.  (A bridge would also drive port 0's outputs, racing the
+// toggles here.)
+static void bench_signal(void)
+{
+    bench_set_t set = { 0 };
+    route_t r = {
+        .type = ROUTE_TYPE_CLONE, .flow = ROUTE_FLOW_DROP,
+        .src_port_id = 0, .dst_port_ids = { 1 }, .dst_count = 1,
+        .signal_map = { { SIGNAL_DTR, SIGNAL_RTS } }, .signal_map_count = 1,
+    };
+    mock_port_t *src = mock_port(0), *dst = mock_port(1);
+    static latency_hist_t e2e;
+    latency_summary_t a, b;
+    uint32_t missed = 0;
+
+    bench_begin("signal");
+    bench_u64("toggles", SIGNAL_TOGGLES);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(20));      // initial pass of the new route
+    latency_hist_reset(&e2e);
+    signal_router_reset_latency();
+
+    for (int i = 0; i < SIGNAL_TOGGLES; i++) {
+        uint32_t want = (i & 1) ? 0 : SIGNAL_RTS;
+        while (xSemaphoreTake(dst->sig_set, 0) == pdTRUE) {
+        }
+        src->port.signals ^= SIGNAL_DTR;
+        int64_t t0 = esp_timer_get_time();
+        port_signals_changed(&src->port);
+
+        bool seen = false;
+        while (!seen && xSemaphoreTake(dst->sig_set, pdMS_TO_TICKS(SIGNAL_TIMEOUT_MS)) == pdTRUE) {
+            seen = (dst->port.signals & SIGNAL_RTS) == want;
+        }
+        if (seen) {
+            latency_hist_record(&e2e, (uint32_t)(dst->sig_set_us - t0));
+        } else {
+            missed++;
+        }
+    }
+
+    latency_hist_summary(&e2e, &a);
+    signal_router_get_latency(&b);
+    bench_u64("p50_us",         a.p50_us);
+    bench_u64("p99_us",         a.p99_us);
+    bench_u64("max_us",         a.max_us);
+    bench_u64("router_p50_us",  b.p50_us);
+    bench_u64("router_p99_us",  b.p99_us);
+    bench_u64("missed", missed);
+    bench_check("ok",           missed == 0);
+    bench_end();
+
+    src->port.signals = 0;
+    dst->port.signals = 0;
+    bench_teardown(&set);
+}
+
+// `bridges` idle bridges (0 <-> 1, 2 <-> 3, ...): the data-plane tasks,
+// their stack and how often they wake with no traffic.  Build with
+// sdkconfig.dispatcher to compare the dispatcher against per-route tasks.
+static void bench_idle(int bridges)
+{
+    bench_set_t set = { 0 };
+    route_engine_stats_t a, b;
+
+    bench_begin("idle");
+    bench_u64("bridges", bridges);
+    for (int i = 0; i < bridges; i++) {
+        route_t r = {
+            .type = ROUTE_TYPE_BRIDGE, .flow = ROUTE_FLOW_DROP,
+            .src_port_id = 2 * i, .dst_port_ids = { 2 * i + 1 }, .dst_count = 1,
+        };
+        if (bench_route(&set, &r) < 0) {
+            bench_fail(&set);
+            return;
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    route_engine_get_stats(&a);
+    int64_t t0 = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ROUTE_BENCH_RUN_MS));
+    route_engine_get_stats(&b);
+    double secs = (esp_timer_get_time() - t0) / 1e6;
+
+    bench_str("mode",           b.dispatcher ? "dispatcher" : "tasks");
+    bench_u64("tasks",          b.tasks);
+    bench_u64("stack_bytes",    b.stack_bytes);
+    bench_num("wakeups_s",      (b.wakeups - a.wakeups) / secs);
+    bench_end();
+    bench_teardown(&set);
+}
+
+// Lossless clone 0 -> 1 whose sink stalls for every other 50 ms.  The
+// route must hold the source back rather than lose anything: once the sink
+// has caught up it has every byte the source took, in order, and nothing
+// was refused into a drop or discarded from the tx queue.
+static void bench_stall(size_t chunk)
+{
+    bench_set_t set = {
+        .srcs = 0x1, .sinks = 0x2, .checked = 0x2,
+        .stalling = 0x2, .stall_ms = 50,
+    };
+    route_t r = {
+        .type = ROUTE_TYPE_CLONE, .flow = ROUTE_FLOW_LOSSLESS,
+        .src_port_id = 0, .dst_port_ids = { 1 }, .dst_count = 1,
+    };
+    bench_snap_t a, b;
+
+    bench_case("stall", ROUTE_FLOW_LOSSLESS, chunk, 1, 1);
+    if (bench_route(&set, &r) < 0) {
+        bench_fail(&set);
+        return;
+    }
+    bench_snap(&set, &a);
+    bench_measure(&set, chunk);
+    bench_settle(&set);
+    bench_snap(&set, &b);
+
+    uint64_t undelivered = (b.in_bytes - a.in_bytes) - (b.out_bytes - a.out_bytes);
+    bench_u64("undelivered", undelivered);
+    bench_check("ok", undelivered == 0 && b.stalls > a.stalls &&
+                      b.lost == a.lost && b.tx_discarded == a.tx_discarded &&
+                      b.rx_dropped == a.rx_dropped && b.seq_errors == a.seq_errors);
+    bench_end();
+    bench_teardown(&set);
+}
+
+void app_main(void)
+{
+    vTaskPrioritySet(NULL, BENCH_PRIORITY);
+
+    if (buf_pool_init() != ESP_OK || port_registry_init() != ESP_OK ||
+        mock_ports_init() != ESP_OK || route_engine_init() != ESP_OK ||
+        signal_router_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Setup failed");
+        exit(1);
+    }
+
+    for (size_t c = 0; c < CHUNK_SIZE_COUNT; c++) {
+        rx_ring_bench(chunk_sizes[c]);
+    }
+    for (int bridges = 1; bridges <= MOCK_PORT_COUNT / 2; bridges *= 2) {
+        bench_idle(bridges);
+    }
+    for (int f = 0; f < 2; f++) {
+        for (size_t c = 0; c < CHUNK_SIZE_COUNT; c++) {
+            bench_bridge(flows[f], chunk_sizes[c]);
+            bench_clone(flows[f], chunk_sizes[c]);
+            bench_merge(flows[f], chunk_sizes[c]);
+        }
+        for (int subs = 1; subs <= 8; subs *= 2) {
+            bench_fanout(flows[f], 256, subs);
+        }
+    }
+    for (int subs = 1; subs <= 8; subs *= 2) {
+        bench_fanout_queue(256, subs);
+    }
+    // A slow line trickling a few bytes per tick, then full-speed CDC packets
+    for (int on = 0; on < 2; on++) {
+        bench_coalesce(4,   1, on ? 256 : 0, on ? 4000 : 0);
+        bench_coalesce(16,  1, on ? 256 : 0, on ? 4000 : 0);
+        bench_coalesce(512, 0, on ? 512 : 0, on ? 1000 : 0);
+    }
+    bench_merge_arb(ROUTE_ARB_BYTE, 0);
+    bench_merge_arb(ROUTE_ARB_DELIMITER, 0);
+    bench_merge_arb(ROUTE_ARB_DELIMITER, 3);
+    bench_merge_arb(ROUTE_ARB_IDLE_GAP, 0);
+    bench_signal();
+    api_bench();
+    bench_affinity(ROUTE_AFFINITY_NONE);
+    bench_affinity(ROUTE_AFFINITY_AUTO);
+    for (size_t c = 0; c < CHUNK_SIZE_COUNT; c++) {
+        bench_stall(chunk_sizes[c]);
+    }
+    exit(bench_failures() ? 1 : 0);
+}
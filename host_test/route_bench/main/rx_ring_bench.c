@@ -0,0 +1,163 @@
+#include "rx_ring_bench.h"
+#include "bench.h"
+#include "port.h"
+#include "spsc_ring.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+
+static const char *TAG = "rx_ring_bench";
+
+#define RB_STACK_SIZE       4096
+#define RB_PRODUCER_PRIO    4       // as the mock generators
+#define RB_CONSUMER_PRIO    5       // as the source pump
+#define RB_READ_SIZE        256
+#define RB_CHUNK_MAX        1024
+
+typedef enum {
+    RB_SPSC,
+    RB_STREAM,
+} rb_impl_t;
+
+static struct {
+    rb_impl_t            impl;
+    size_t               chunk;
+    spsc_ring_t          ring;
+    StreamBufferHandle_t stream;
+    volatile bool        running;
+    SemaphoreHandle_t    done;
+    uint64_t             pushes;
+    uint64_t             wakes;     // spsc: empty -> non-empty transitions signalled
+    uint64_t             reads;
+    uint64_t             bytes;
+    uint64_t             seq_errors;
+} rb;
+
+static size_t rb_space(void)
+{
+    return rb.impl == RB_SPSC ? spsc_ring_space(&rb.ring)
+                              : xStreamBufferSpacesAvailable(rb.stream);
+}
+
+static void rb_producer_task(void *arg)
+{
+    uint8_t buf[RB_CHUNK_MAX];
+    uint8_t next = 0;
+
+    while (rb.running) {
+        if (rb_space() < rb.chunk) {
+            taskYIELD();
+            continue;
+        }
+        for (size_t i = 0; i < rb.chunk; i++) {
+            buf[i] = next++;
+        }
+        if (rb.impl == RB_SPSC) {
+            bool was_empty;
+            spsc_ring_push(&rb.ring, buf, rb.chunk, &was_empty);
+            if (was_empty) {
+                spsc_ring_wake(&rb.ring);
+                __atomic_add_fetch(&rb.wakes, 1, __ATOMIC_RELAXED);
+            }
+        } else {
+            xStreamBufferSend(rb.stream, buf, rb.chunk, 0);
+        }
+        __atomic_add_fetch(&rb.pushes, 1, __ATOMIC_RELAXED);
+    }
+
+    xSemaphoreGive(rb.done);
+    vTaskDelete(NULL);
+}
+
+static void rb_consumer_task(void *arg)
+{
+    uint8_t buf[RB_READ_SIZE];
+    uint8_t expect = 0;
+
+    while (rb.running) {
+        size_t n = rb.impl == RB_SPSC
+            ? spsc_ring_read(&rb.ring, buf, sizeof(buf), pdMS_TO_TICKS(50))
+            : xStreamBufferReceive(rb.stream, buf, sizeof(buf), pdMS_TO_TICKS(50));
+        if (n == 0) continue;
+
+        uint64_t errors = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] != expect) errors++;
+            expect = buf[i] + 1;
+        }
+        __atomic_add_fetch(&rb.reads, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&rb.bytes, n, __ATOMIC_RELAXED);
+        if (errors) __atomic_add_fetch(&rb.seq_errors, errors, __ATOMIC_RELAXED);
+    }
+
+    xSemaphoreGive(rb.done);
+    vTaskDelete(NULL);
+}
+
+static void rb_run(rb_impl_t impl, size_t chunk)
+{
+    bench_begin("rx_ring");
+    bench_str("impl", impl == RB_SPSC ? "spsc" : "stream_buffer");
+    bench_u64("chunk", chunk);
+
+    rb.impl       = impl;
+    rb.chunk      = chunk < RB_CHUNK_MAX ? chunk : RB_CHUNK_MAX;
+    rb.pushes     = 0;
+    rb.wakes      = 0;
+    rb.reads      = 0;
+    rb.bytes      = 0;
+    rb.seq_errors = 0;
+    rb.running    = true;
+
+    int tasks = 0;
+    if (xTaskCreate(rb_consumer_task, "rb_consumer", RB_STACK_SIZE, NULL, RB_CONSUMER_PRIO, NULL) == pdPASS) tasks++;
+    if (xTaskCreate(rb_producer_task, "rb_producer", RB_STACK_SIZE, NULL, RB_PRODUCER_PRIO, NULL) == pdPASS) tasks++;
+    if (tasks < 2) {
+        ESP_LOGE(TAG, "Failed to create tasks");
+        bench_str("error", "task setup failed");
+        rb.running = false;
+        while (tasks--) xSemaphoreTake(rb.done, portMAX_DELAY);
+        bench_end();
+        return;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ROUTE_BENCH_RUN_MS));
+    rb.running = false;
+    double secs = (esp_timer_get_time() - t0) / 1e6;
+    for (int i = 0; i < 2; i++) {
+        xSemaphoreTake(rb.done, portMAX_DELAY);
+    }
+
+    bench_num("mb_s",       rb.bytes / 1e6 / secs);
+    bench_num("pushes_s",   rb.pushes / secs);
+    bench_num("reads_s",    rb.reads / secs);
+    bench_num("ns_per_byte", rb.bytes ? secs * 1e9 / rb.bytes : 0);
+    if (impl == RB_SPSC) bench_num("wakes_s", rb.wakes / secs);
+    bench_u64("seq_errors", rb.seq_errors);
+    bench_end();
+}
+
+void rx_ring_bench(size_t chunk)
+{
+    if (!rb.done) {
+        rb.done = xSemaphoreCreateCounting(2, 0);
+        rb.stream = xStreamBufferCreate(PORT_BUF_SIZE, 1);
+        if (!rb.done || !rb.stream || spsc_ring_init(&rb.ring, PORT_BUF_SIZE) != ESP_OK) {
+            ESP_LOGE(TAG, "Out of memory");
+            return;
+        }
+    }
+
+    // Start both empty: the producer can push once more after the consumer stops
+    uint8_t buf[RB_READ_SIZE];
+    while (spsc_ring_read(&rb.ring, buf, sizeof(buf), 0) > 0) {
+    }
+    xStreamBufferReset(rb.stream);
+
+    rb_run(RB_SPSC, chunk);
+    rb_run(RB_STREAM, chunk);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stddef.h>
+
+// Microbenchmark of a port's receive buffer on its own, the spsc_ring_t
+// every port uses against the FreeRTOS stream buffer it replaced: a
+// producer task pushes chunk-byte pieces of a counting pattern whenever
+// they fit and a consumer task reads them back 256 bytes at a time with a
+// 50 ms timeout, as the source pump does.  Prints one "rx_ring" line per
+// implementation.
+void rx_ring_bench(size_t chunk);
@@ -0,0 +1,42 @@
+#pragma once
+
+// Stand-in for the part of esp_http_server that the REST handlers use, so
+// the host bench can call api_handler.c directly: a request carries its
+// URI and body, and the response side only counts what would be sent
+// (api_bench.c).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+#include "esp_system.h"     // esp_get_free_heap_size(), as the real header pulls in
+
+#define HTTPD_MAX_URI_LEN   512
+
+typedef enum {
+    HTTPD_400_BAD_REQUEST,
+    HTTPD_404_NOT_FOUND,
+    HTTPD_500_INTERNAL_SERVER_ERROR,
+} httpd_err_code_t;
+
+typedef struct httpd_req {
+    char        uri[HTTPD_MAX_URI_LEN + 1];
+    size_t      content_len;
+    const char *body;           // request body, content_len bytes
+    size_t      body_read;
+
+    // Response
+    size_t      resp_bytes;
+    uint32_t    resp_chunks;    // httpd_resp_send_chunk() calls with data
+    bool        resp_error;     // httpd_resp_send_err() was called
+} httpd_req_t;
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len);
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg);
+int       httpd_req_recv(httpd_req_t *req, char *buf, size_t len);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t len);
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t len);
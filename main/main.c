@@ -6,6 +6,7 @@
 #include "sdkconfig.h"
 #include "port.h"
 #include "port_registry.h"
+#include "buf_pool.h"
 #include "port_cdc.h"
 #include "port_uart.h"
 #include "route.h"
@@ -24,6 +25,16 @@ static const char *TAG = "main";
 
 system_config_t sys_config;
 
+// Forward signal changes to the web UI, which coalesces them.
+static void on_signals_changed(uint32_t port_mask)
+{
+    for (int i = 0; i < PORT_MAX_COUNT; i++) {
+        if (!(port_mask & (1u << i))) continue;
+        port_t *port = port_registry_get(i);
+        if (port) web_server_notify_signal_change(i, port_get_effective_signals(port));
+    }
+}
+
 // Restart web server on WiFi mode change (e.g., STA-to-AP fallback)
 static void on_wifi_mode_change(wifi_mgr_mode_t new_mode)
 {
@@ -71,7 +82,8 @@ void app_main(void)
     config_store_init();
     config_store_load(&sys_config);
 
-    // 4. Init port registry
+    // 4. Init data-plane buffer pool and port registry
+    buf_pool_init();
     ret = port_registry_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Port registry init failed");
@@ -163,6 +175,23 @@ void app_main(void)
         memcpy(r.dst_port_ids, sys_config.routes[i].dst_port_ids, sizeof(r.dst_port_ids));
         r.signal_map_count = sys_config.routes[i].signal_map_count;
         memcpy(r.signal_map, sys_config.routes[i].signal_map, sizeof(r.signal_map));
+        r.flow = sys_config.routes[i].flow == ROUTE_FLOW_LOSSLESS ? ROUTE_FLOW_LOSSLESS
+                                                                   : ROUTE_FLOW_DROP;
+        r.coalesce_bytes = sys_config.routes[i].coalesce_bytes;
+        r.coalesce_us    = sys_config.routes[i].coalesce_us;
+        memcpy(r.merge_src_ids, sys_config.routes[i].merge_src_ids, sizeof(r.merge_src_ids));
+        r.merge_src_count = sys_config.routes[i].merge_src_count;
+        r.arbitration     = sys_config.routes[i].arbitration;
+        r.arb_delimiter   = sys_config.routes[i].arb_delimiter;
+        r.arb_idle_us     = sys_config.routes[i].arb_idle_us;
+        memcpy(r.merge_weights, sys_config.routes[i].merge_weights, sizeof(r.merge_weights));
+        r.framing         = sys_config.routes[i].framing;
+        memcpy(r.frame_delim, sys_config.routes[i].frame_delim, sizeof(r.frame_delim));
+        r.frame_delim_len = sys_config.routes[i].frame_delim_len;
+        r.frame_len       = sys_config.routes[i].frame_len;
+        r.frame_gap       = sys_config.routes[i].frame_gap;
+        r.elastic_bytes   = sys_config.routes[i].elastic_bytes;
+        r.elastic_overflow = sys_config.routes[i].elastic_overflow;
 
         uint8_t route_id;
         if (route_create(&r, &route_id) == ESP_OK) {
@@ -182,6 +211,8 @@ void app_main(void)
         ESP_LOGW(TAG, "Web server start failed: %s (continuing)", esp_err_to_name(ret));
     }
 
+    signal_router_set_listener(on_signals_changed);
+
     // Register callback to restart web server on WiFi mode changes
     wifi_mgr_set_mode_change_cb(on_wifi_mode_change);
 
@@ -205,6 +236,10 @@ void app_main(void)
                  all_ports[i]->name, all_ports[i]->id, all_ports[i]->type);
     }
 
+    // Route byte totals at the previous pass; the counters are monotonic,
+    // so activity is whatever moved since then.
+    struct { uint8_t id; bool valid; uint64_t s2d, d2s; } last_flow[ROUTE_MAX_COUNT] = {0};
+
     // Main loop: monitor state and update LED
     while (1) {
         bool any_cdc_active = false;
@@ -220,16 +255,49 @@ void app_main(void)
         route_t active_routes[ROUTE_MAX_COUNT];
         int rcount = route_get_all(active_routes, ROUTE_MAX_COUNT);
         for (int i = 0; i < rcount; i++) {
-            if (active_routes[i].bytes_fwd_src_to_dst > 0 || active_routes[i].bytes_fwd_dst_to_src > 0) {
+            route_stats_t st;
+            if (route_get_stats(active_routes[i].id, &st) != ESP_OK) continue;
+
+            int slot = -1, free_slot = -1;
+            for (int j = 0; j < ROUTE_MAX_COUNT; j++) {
+                if (last_flow[j].valid && last_flow[j].id == active_routes[i].id) { slot = j; break; }
+                if (!last_flow[j].valid && free_slot < 0) free_slot = j;
+            }
+            if (slot < 0) {
+                // First sighting: take it as the baseline.
+                if (free_slot < 0) continue;
+                last_flow[free_slot].id    = active_routes[i].id;
+                last_flow[free_slot].valid = true;
+                last_flow[free_slot].s2d   = st.src_to_dst.bytes;
+                last_flow[free_slot].d2s   = st.dst_to_src.bytes;
+                continue;
+            }
+
+            // A route recreated under the same ID starts again from zero.
+            if (st.src_to_dst.bytes < last_flow[slot].s2d || st.dst_to_src.bytes < last_flow[slot].d2s) {
+                last_flow[slot].s2d = last_flow[slot].d2s = 0;
+            }
+            uint64_t s2d = st.src_to_dst.bytes - last_flow[slot].s2d;
+            uint64_t d2s = st.dst_to_src.bytes - last_flow[slot].d2s;
+            last_flow[slot].s2d = st.src_to_dst.bytes;
+            last_flow[slot].d2s = st.dst_to_src.bytes;
+            if (s2d > 0 || d2s > 0) {
                 any_data_flowing = true;
 #if CONFIG_VUART_STATUS_LED_GPIO >= 0
                 status_led_set_activity();
 #endif
-                web_server_notify_data_flow(active_routes[i].id,
-                    active_routes[i].bytes_fwd_src_to_dst,
-                    active_routes[i].bytes_fwd_dst_to_src);
-                route_reset_counters(active_routes[i].id);
+                web_server_notify_data_flow(active_routes[i].id, (uint32_t)s2d, (uint32_t)d2s);
+            }
+        }
+
+        // Forget routes that are gone, so a reused ID starts a new baseline.
+        for (int j = 0; j < ROUTE_MAX_COUNT; j++) {
+            if (!last_flow[j].valid) continue;
+            bool seen = false;
+            for (int i = 0; i < rcount; i++) {
+                if (active_routes[i].id == last_flow[j].id) { seen = true; break; }
             }
+            if (!seen) last_flow[j].valid = false;
         }
 
 #if CONFIG_VUART_STATUS_LED_GPIO >= 0